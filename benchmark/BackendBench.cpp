@@ -0,0 +1,204 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// Run every solver backend on the same problems and report
+// success, iterations, final cost and violation and solving time.
+// usage: BackendBench [nrRun]
+
+
+// include
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <tuple>
+
+// boost
+#include <boost/math/constants/constants.hpp>
+
+// PG
+#include "ConfigStruct.h"
+#include "PostureGenerator.h"
+#include "SolverBackend.h"
+
+// Arm
+#include "Z12Arm.h"
+#include "XYZ12Arm.h"
+#include "SyntheticModel.h"
+
+
+const Eigen::Vector3d gravity(0., 9.81, 0.);
+
+
+struct BenchProblem
+{
+  std::string name;
+  pg::RobotConfig robotConfig;
+  pg::RunConfig runConfig;
+};
+
+
+std::vector<BenchProblem> makeCorpus()
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+  namespace cst = boost::math::constants;
+
+  std::vector<BenchProblem> corpus;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  std::tie(mb, mbc) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbc.q[3][0] = -0.1;
+  pg::RunConfig z12Run(mbc.q, {}, mbc.q);
+
+  Vector3d target(2., 0., 0.);
+  Matrix3d oriTarget(RotZ(-cst::pi<double>()));
+
+  {
+    pg::RobotConfig rc(mb);
+    rc.fixedPosContacts = {{12, target, PTransformd::Identity()}};
+    rc.postureScale = 1.;
+    corpus.push_back({"Z12 position", rc, z12Run});
+  }
+
+  {
+    pg::RobotConfig rc(mb);
+    rc.fixedPosContacts = {{12, target, PTransformd::Identity()}};
+    rc.fixedOriContacts = {{12, oriTarget, PTransformd::Identity()}};
+    rc.postureScale = 1.;
+    corpus.push_back({"Z12 pose", rc, z12Run});
+  }
+
+  {
+    pg::RobotConfig rc(mb);
+    rc.bodyPosTargets = {{6, Vector3d(1., 1., 0.), 1.},
+                         {12, Vector3d(2., 1., 0.), 1.}};
+    rc.postureScale = 1e-2;
+    corpus.push_back({"Z12 targets", rc, z12Run});
+  }
+
+  {
+    pg::RobotConfig rc(mb);
+    rc.fixedPosContacts = {{12, target, PTransformd::Identity()}};
+    rc.fixedOriContacts = {{12, oriTarget, PTransformd::Identity()}};
+    Matrix3d frame(RotX(-cst::pi<double>()/2.));
+    rc.forceContacts = {{0, {PTransformd(frame, Vector3d(0.01, 0., 0.)),
+                             PTransformd(frame, Vector3d(-0.01, 0., 0.))}, 1.}};
+    corpus.push_back({"Z12 static", rc, z12Run});
+  }
+
+  {
+    MultiBody mbXYZ;
+    MultiBodyConfig mbcXYZ;
+    std::tie(mbXYZ, mbcXYZ) = makeXYZ12Arm(false);
+    for(int i = 1; i < mbXYZ.nrJoints(); ++i)
+    {
+      mbcXYZ.q[i][0] = 0.1;
+    }
+
+    pg::RobotConfig rc(mbXYZ);
+    rc.fixedPosContacts = {{12, Vector3d(1., 2., 1.), PTransformd::Identity()}};
+    rc.fixedOriContacts = {{12, Matrix3d(RotX(cst::pi<double>()/2.)),
+                            PTransformd::Identity()}};
+    rc.postureScale = 1.;
+    corpus.push_back({"XYZ12 pose", rc, {mbcXYZ.q, {}, mbcXYZ.q}});
+  }
+
+  // scaling
+  {
+    SyntheticModel chain(makeSyntheticModel(SyntheticModelConfig(48)));
+    SyntheticScenario sc(makeSyntheticScenario(chain, SyntheticScenarioConfig(1)));
+    corpus.push_back({"chain48 position", sc.robotConfig, sc.runConfig});
+  }
+
+  {
+    // 4 leaves
+    SyntheticModel tree(makeSyntheticModel(SyntheticModelConfig(8, 2, 2)));
+    SyntheticScenario sc(makeSyntheticScenario(tree, SyntheticScenarioConfig(4)));
+    corpus.push_back({"tree8x4 contacts", sc.robotConfig, sc.runConfig});
+    sc = makeSyntheticScenario(tree, SyntheticScenarioConfig(4, 16));
+    corpus.push_back({"tree8x4 static", sc.robotConfig, sc.runConfig});
+  }
+
+  return corpus;
+}
+
+
+int main(int argc, char** argv)
+{
+  int nrRun = argc > 1 ? std::atoi(argv[1]) : 20;
+
+  std::vector<boost::shared_ptr<pg::SolverBackend>> backends =
+    {boost::shared_ptr<pg::SolverBackend>(new pg::RoboptimBackend("ipopt-sparse")),
+     boost::shared_ptr<pg::SolverBackend>(new pg::LMBackend)};
+
+  std::cout << std::left << std::setw(16) << "problem"
+            << std::setw(22) << "backend"
+            << std::right << std::setw(8) << "success"
+            << std::setw(8) << "iters"
+            << std::setw(14) << "cost"
+            << std::setw(14) << "violation"
+            << std::setw(12) << "mean (ms)"
+            << std::setw(12) << "min (ms)" << std::endl;
+
+  for(const BenchProblem& bp: makeCorpus())
+  {
+    for(const auto& backend: backends)
+    {
+      pg::PostureGenerator pgPb;
+      pgPb.param("ipopt.print_level", 0);
+      pgPb.param("ipopt.linear_solver", "mumps");
+      pgPb.backend(backend);
+      pgPb.robotConfigs({bp.robotConfig}, gravity);
+
+      int nrSuccess = 0;
+      double total = 0.;
+      double best = std::numeric_limits<double>::infinity();
+      for(int i = 0; i < nrRun; ++i)
+      {
+        auto start = std::chrono::steady_clock::now();
+        nrSuccess += pgPb.run({bp.runConfig}) ? 1 : 0;
+        std::chrono::duration<double, std::milli> time =
+          std::chrono::steady_clock::now() - start;
+        total += time.count();
+        best = std::min(best, time.count());
+      }
+
+      pg::IterateQuantities last{std::nan(""), std::nan("")};
+      if(pgPb.nrIters() > 0)
+      {
+        last = pgPb.quantitiesIter(pgPb.nrIters() - 1);
+      }
+
+      std::cout << std::left << std::setw(16) << bp.name
+                << std::setw(22) << backend->name()
+                << std::right << std::setw(8) << nrSuccess
+                << std::setw(8) << pgPb.nrIters()
+                << std::setw(14) << last.obj
+                << std::setw(14) << last.constr_viol
+                << std::setw(12) << total/nrRun
+                << std::setw(12) << best << std::endl;
+    }
+  }
+
+  return 0;
+}
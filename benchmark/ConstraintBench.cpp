@@ -0,0 +1,378 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// Time impl_compute and impl_jacobian of every constraint and of StdCostFunc
+// on the test arms and on synthetic chains and trees, with a varying number of force
+// points, polygon vertices and collision pairs.
+// The robot update (forward kinematics and update hooks) is timed apart.
+// Results are written in JSON.
+// usage: ConstraintBench [nrRun] [output.json]
+
+
+// include
+// std
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// boost
+#include <boost/math/constants/constants.hpp>
+#include <boost/shared_ptr.hpp>
+
+// sch
+#include <sch/S_Object/S_Sphere.h>
+
+// PG
+#include "ConfigStruct.h"
+#include "PGData.h"
+#include "FixedContactConstr.h"
+#include "PlanarSurfaceConstr.h"
+#include "StaticStabilityConstr.h"
+#include "PositiveForceConstr.h"
+#include "FrictionConeConstr.h"
+#include "CollisionConstr.h"
+#include "StdCostFunc.h"
+#include "RobotLinkConstr.h"
+#include "CylindricalSurfaceConstr.h"
+#include "CoMHalfSpaceConstr.h"
+#include "JSON.h"
+
+// Arm
+#include "Z12Arm.h"
+#include "XYZ12Arm.h"
+#include "SyntheticModel.h"
+
+
+const Eigen::Vector3d gravity(0., 9.81, 0.);
+
+
+/// @return A regular polygon of nrPoints vertices.
+std::vector<Eigen::Vector2d> makePolygon(int nrPoints, double radius)
+{
+  namespace cst = boost::math::constants;
+
+  std::vector<Eigen::Vector2d> points(nrPoints);
+  for(int i = 0; i < nrPoints; ++i)
+  {
+    double angle = 2.*cst::pi<double>()*i/nrPoints;
+    points[i] = radius*Eigen::Vector2d(std::cos(angle), std::sin(angle));
+  }
+  return points;
+}
+
+
+/// @return nrPoints force points spread on the root and the last body.
+std::vector<pg::ForceContact> makeForceContacts(int nrPoints, int lastId)
+{
+  std::vector<pg::ForceContact> contacts = {{0, {}, 0.7}, {lastId, {}, 0.7}};
+  std::vector<Eigen::Vector2d> polygon(makePolygon(nrPoints, 0.1));
+  for(int i = 0; i < nrPoints; ++i)
+  {
+    contacts[i%2].points.push_back(
+      sva::PTransformd(Eigen::Vector3d(polygon[i][0], polygon[i][1], 0.)));
+  }
+  return contacts;
+}
+
+
+struct Model
+{
+  std::string name;
+  rbd::MultiBody mb;
+  int lastId;
+};
+
+
+struct Record
+{
+  std::string model;
+  int nrDof;
+  std::string function;
+  std::string variant;
+  int outputSize, jacobianNnz;
+  double updateNs, computeNs, jacobianNs;
+};
+
+
+class Bench
+{
+public:
+  Bench(int nrRun, int nrSample)
+    : nrRun_(nrRun)
+    , nrSample_(nrSample)
+  {}
+
+  /// Time f on nrSample_ random points, pgdatas are updated before
+  /// each evaluation.
+  void run(const Model& model, const std::string& variant,
+           const roboptim::DifferentiableSparseFunction& f,
+           const std::vector<pg::PGData*>& pgdatas)
+  {
+    typedef std::chrono::steady_clock clock;
+    typedef std::chrono::duration<double, std::nano> ns;
+
+    std::srand(42);
+    std::vector<Eigen::VectorXd> xs(nrSample_);
+    for(Eigen::VectorXd& x: xs)
+    {
+      x = Eigen::VectorXd::Random(f.inputSize());
+    }
+
+    roboptim::DifferentiableSparseFunction::result_t res(f.outputSize());
+    roboptim::DifferentiableSparseFunction::jacobian_t jac(f.outputSize(), f.inputSize());
+    ns update(0.), compute(0.), jacobian(0.);
+    for(int run = 0; run < nrRun_; ++run)
+    {
+      for(const Eigen::VectorXd& x: xs)
+      {
+        clock::time_point start = clock::now();
+        for(pg::PGData* pgdata: pgdatas)
+        {
+          pgdata->x(x);
+        }
+        clock::time_point updated = clock::now();
+        f(res, x);
+        clock::time_point computed = clock::now();
+        f.jacobian(jac, x);
+        clock::time_point end = clock::now();
+
+        update += updated - start;
+        compute += computed - updated;
+        jacobian += end - computed;
+      }
+    }
+
+    double nrCall = double(nrRun_)*nrSample_;
+    records_.push_back({model.name, model.mb.nrDof(), f.getName(), variant,
+                        int(f.outputSize()), int(jac.nonZeros()),
+                        update.count()/nrCall, compute.count()/nrCall,
+                        jacobian.count()/nrCall});
+  }
+
+  void write(std::ostream& out) const
+  {
+    out << "{\n  \"benchmark\": \"ConstraintBench\",\n"
+        << "  \"nrRun\": " << nrRun_ << ",\n"
+        << "  \"nrSample\": " << nrSample_ << ",\n"
+        << "  \"results\": [";
+    for(std::size_t i = 0; i < records_.size(); ++i)
+    {
+      const Record& r = records_[i];
+      out << (i == 0 ? "\n" : ",\n") << "    {\"model\": ";
+      pg::writeJSONString(out, r.model);
+      out << ", \"nrDof\": " << r.nrDof << ", \"function\": ";
+      pg::writeJSONString(out, r.function);
+      out << ", \"variant\": ";
+      pg::writeJSONString(out, r.variant);
+      out << ", \"outputSize\": " << r.outputSize
+          << ", \"jacobianNnz\": " << r.jacobianNnz
+          << ", \"updateNs\": " << r.updateNs
+          << ", \"computeNs\": " << r.computeNs
+          << ", \"jacobianNs\": " << r.jacobianNs << "}";
+    }
+    out << "\n  ]\n}\n";
+  }
+
+private:
+  int nrRun_, nrSample_;
+  std::vector<Record> records_;
+};
+
+
+/// PGData of a model with nrForcePoints force variables.
+pg::PGData makeData(const Model& model, int nrForcePoints=0)
+{
+  int nrParams = model.mb.nrParams();
+  return pg::PGData(model.mb, gravity, nrParams + nrForcePoints*3, 0, nrParams);
+}
+
+
+void benchModel(Bench& bench, const Model& model)
+{
+  using namespace Eigen;
+  namespace cst = boost::math::constants;
+
+  const int lastId = model.lastId;
+
+  // contacts
+  {
+    pg::PGData pgdata(makeData(model));
+    sva::PTransformd surface(sva::RotZ(-cst::pi<double>()/2.), Vector3d(0., 0.1, 0.));
+    sva::PTransformd target(Vector3d(0., 1., 0.));
+
+    pg::FixedPositionContactConstr fpc(&pgdata, lastId, Vector3d(2., 0., 0.), surface);
+    bench.run(model, "", fpc, {&pgdata});
+    pg::FixedOrientationContactConstr foc(&pgdata, lastId,
+                                          Matrix3d(sva::RotZ(cst::pi<double>())),
+                                          surface);
+    bench.run(model, "", foc, {&pgdata});
+    pg::PlanarPositionContactConstr ppc(&pgdata, lastId, target, surface);
+    bench.run(model, "", ppc, {&pgdata});
+    pg::PlanarOrientationContactConstr poc(&pgdata, lastId, target, surface, 1);
+    bench.run(model, "", poc, {&pgdata});
+    pg::CylindricalPositionConstr cpc(&pgdata, lastId, target, surface);
+    bench.run(model, "", cpc, {&pgdata});
+    pg::CylindricalNVecConstr cnc(&pgdata, lastId, target, surface);
+    bench.run(model, "", cnc, {&pgdata});
+
+    for(int nrVertices: {4, 8, 16, 32})
+    {
+      pg::PlanarInclusionConstr pi(&pgdata, lastId, target,
+                                   makePolygon(nrVertices, 1.), surface,
+                                   makePolygon(nrVertices, 0.1));
+      bench.run(model, std::to_string(nrVertices) + " vertices", pi, {&pgdata});
+    }
+
+    for(int nrPlanes: {1, 8})
+    {
+      std::vector<Vector3d> O(nrPlanes, Vector3d(2., 0., 0.));
+      std::vector<Vector3d> n(nrPlanes, Vector3d(0., 1., 0.));
+      pg::CoMHalfSpaceConstr chs(&pgdata, O, n);
+      bench.run(model, std::to_string(nrPlanes) + " planes", chs, {&pgdata});
+    }
+  }
+
+  // forces
+  for(int nrPoints: {4, 16, 64})
+  {
+    const std::string variant(std::to_string(nrPoints) + " force points");
+    pg::PGData pgdata(makeData(model, nrPoints));
+    pgdata.forces(makeForceContacts(nrPoints, lastId));
+
+    pg::StaticStabilityConstr ss(&pgdata);
+    const pg::StaticStabilityConstr* ssPtr = &ss;
+    pgdata.addUpdateHook([ssPtr](){ssPtr->computeCoM();});
+    bench.run(model, variant, ss, {&pgdata});
+    pg::PositiveForceConstr pf(&pgdata);
+    bench.run(model, variant, pf, {&pgdata});
+    pg::FrictionConeConstr fc(&pgdata);
+    bench.run(model, variant, fc, {&pgdata});
+  }
+
+  // collisions
+  for(int nrPairs: {1, 4, 16})
+  {
+    const std::string variant(std::to_string(nrPairs) + " pairs");
+    std::vector<boost::shared_ptr<sch::S_Sphere>> hulls;
+    std::vector<pg::EnvCollision> envCols;
+    std::vector<pg::SelfCollision> selfCols;
+    for(int i = 0; i < nrPairs; ++i)
+    {
+      hulls.emplace_back(new sch::S_Sphere(0.1));
+      hulls.emplace_back(new sch::S_Sphere(0.2));
+      hulls.back()->setTransformation(pg::tosch(
+        sva::PTransformd(Vector3d(1., 0.5*(i%lastId), 0.))));
+      int bodyId = 1 + i%(lastId - 1);
+      envCols.emplace_back(bodyId, hulls[2*i].get(), sva::PTransformd::Identity(),
+                           hulls[2*i + 1].get(), 0.1);
+      selfCols.emplace_back(bodyId, hulls[2*i].get(), sva::PTransformd::Identity(),
+                            lastId, hulls[2*i + 1].get(), sva::PTransformd::Identity(),
+                            0.1);
+    }
+
+    {
+      pg::PGData pgdata(makeData(model));
+      pg::EnvCollisionConstr ec(&pgdata, envCols);
+      const pg::EnvCollisionConstr* ecPtr = &ec;
+      pgdata.addUpdateHook([ecPtr](){ecPtr->updateCollisionData();});
+      bench.run(model, variant, ec, {&pgdata});
+    }
+    {
+      pg::PGData pgdata(makeData(model));
+      pg::SelfCollisionConstr sc(&pgdata, selfCols);
+      const pg::SelfCollisionConstr* scPtr = &sc;
+      pgdata.addUpdateHook([scPtr](){scPtr->updateCollisionData();});
+      bench.run(model, variant, sc, {&pgdata});
+    }
+  }
+
+  // robot link
+  {
+    int nrParams = model.mb.nrParams();
+    pg::PGData pgdata1(model.mb, gravity, 2*nrParams, 0, nrParams);
+    pg::PGData pgdata2(model.mb, gravity, 2*nrParams, nrParams, 2*nrParams);
+    sva::PTransformd bT(Vector3d(0., 0.1, 0.));
+    pg::RobotLinkConstr rl(&pgdata1, &pgdata2, {{lastId, bT, bT}, {lastId/2, bT, bT}});
+    bench.run(model, "", rl, {&pgdata1, &pgdata2});
+  }
+
+  // cost
+  for(int nrPoints: {0, 16})
+  {
+    std::vector<pg::PGData> pgdatas = {makeData(model, nrPoints)};
+    if(nrPoints > 0)
+    {
+      pgdatas.back().forces(makeForceContacts(nrPoints, lastId));
+    }
+
+    pg::RobotConfig robotConfig(model.mb);
+    rbd::MultiBodyConfig mbc(model.mb);
+    mbc.zero(model.mb);
+    pg::RunConfig runConfig(mbc.q, {}, mbc.q);
+    robotConfig.postureScale = 1.;
+    robotConfig.forceScale = 1.;
+    robotConfig.bodyPosTargets = {{lastId, Vector3d(1., 1., 0.), 1.}};
+    robotConfig.bodyOriTargets = {{lastId, Matrix3d::Identity(), 1.}};
+    if(nrPoints > 0)
+    {
+      robotConfig.forceContactsMin = {{lastId, 1.}};
+    }
+
+    pg::StdCostFunc cost(pgdatas, {robotConfig}, {runConfig});
+    bench.run(model, std::to_string(nrPoints) + " force points", cost, {&pgdatas.back()});
+  }
+}
+
+
+int main(int argc, char** argv)
+{
+  int nrRun = argc > 1 ? std::atoi(argv[1]) : 20;
+
+  std::vector<Model> models;
+  models.push_back({"Z12", std::get<0>(makeZ12Arm()), 12});
+  models.push_back({"XYZ12", std::get<0>(makeXYZ12Arm(false)), 12});
+  for(int depth: {48, 96})
+  {
+    SyntheticModel chain(makeSyntheticModel(SyntheticModelConfig(depth)));
+    models.push_back({"chain" + std::to_string(depth), chain.mb, chain.leafIds[0]});
+  }
+  // 8 leaves
+  SyntheticModel tree(makeSyntheticModel(SyntheticModelConfig(8, 2, 3)));
+  models.push_back({"tree8x2", tree.mb, tree.leafIds[0]});
+
+  Bench bench(nrRun, 50);
+  for(const Model& model: models)
+  {
+    benchModel(bench, model);
+  }
+
+  if(argc > 2)
+  {
+    std::ofstream out(argv[2]);
+    bench.write(out);
+  }
+  else
+  {
+    bench.write(std::cout);
+  }
+
+  return 0;
+}
@@ -0,0 +1,439 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// Run a corpus of complete problems (fixed arm IK, planar multi-contact,
+// gripper and cylinder, collision heavy and linked multi-robot) through
+// PostureGenerator::run and report per problem the success rate, the wall
+// time (mean, median and min), the maximum number of iterations of the runs
+// and the number of cost and constraints evaluations.
+// Evaluations are counted on an extra profiled run so that the timed runs
+// don't pay the profiling overhead.
+// Results can be saved and compared with a previous result (baseline): a
+// problem regress when its median time exceed the baseline one by more
+// than tolerance percent, its success rate decrease or its number of
+// iterations exceed the baseline one by more than iterTolerance percent.
+// The SolveBenchBaseline target save the results of the build machine in
+// the sources SolveBench.tsv and SolveBenchCompare compare with it.
+// usage: SolveBench [nrRun] [baseline.tsv|-] [output.tsv] [tolerance]
+//                   [iterTolerance]
+// return 1 if a problem regress.
+
+
+// include
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// boost
+#include <boost/math/constants/constants.hpp>
+#include <boost/shared_ptr.hpp>
+
+// sch
+#include <sch/S_Object/S_Sphere.h>
+
+// PG
+#include "ConfigStruct.h"
+#include "PostureGenerator.h"
+#include "CollisionConstr.h" // tosch
+
+// Arm
+#include "Z12Arm.h"
+#include "XYZ12Arm.h"
+#include "SyntheticModel.h"
+
+const Eigen::Vector3d gravity(0., 9.81, 0.);
+
+
+struct BenchProblem
+{
+  std::string name;
+  std::vector<pg::RobotConfig> robotConfigs;
+  std::vector<pg::RobotLink> robotLinks;
+  std::vector<pg::RunConfig> runConfigs;
+  /// Hulls used by the collisions.
+  std::vector<boost::shared_ptr<sch::S_Object>> hulls;
+};
+
+
+/// Result of a problem, also a line of the results file.
+struct BenchResult
+{
+  std::string name;
+  double successRate;
+  double meanMs, medianMs, minMs;
+  int nrIters;
+  int nrEvals;
+};
+
+
+/// Keep model and scenario hulls alive with the problem.
+void addHulls(BenchProblem& bp, const SyntheticModel& model,
+              const SyntheticScenario& sc)
+{
+  bp.hulls.insert(bp.hulls.end(), model.hulls.begin(), model.hulls.end());
+  bp.hulls.insert(bp.hulls.end(), sc.obstacles.begin(), sc.obstacles.end());
+}
+
+
+std::vector<BenchProblem> makeCorpus()
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+  namespace cst = boost::math::constants;
+
+  std::vector<BenchProblem> corpus;
+
+  MultiBody mb;
+  MultiBodyConfig mbc;
+  std::tie(mb, mbc) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbc.q[3][0] = -0.1;
+  pg::RunConfig z12Run(mbc.q, {}, mbc.q);
+
+  Vector3d target(2., 0., 0.);
+  Matrix3d oriTarget(RotZ(-cst::pi<double>()));
+  Matrix3d frame(RotX(-cst::pi<double>()/2.));
+  std::vector<Vector2d> targetPoints = {{1., 1.}, {-0., 1.}, {-0., -1.}, {1., -1.}};
+  std::vector<Vector2d> surfPoints = {{0.1, 0.1}, {-0.1, 0.1}, {-0.1, -0.1}, {0.1, -0.1}};
+
+  /*
+   *   Fixed arm IK
+   */
+  {
+    pg::RobotConfig rc(mb);
+    rc.fixedPosContacts = {{12, target, PTransformd::Identity()}};
+    rc.postureScale = 1.;
+    corpus.push_back({"Z12 position", {rc}, {}, {z12Run}, {}});
+  }
+
+  {
+    pg::RobotConfig rc(mb);
+    rc.fixedPosContacts = {{12, target, PTransformd::Identity()}};
+    rc.fixedOriContacts = {{12, oriTarget, PTransformd::Identity()}};
+    rc.postureScale = 1.;
+    corpus.push_back({"Z12 pose", {rc}, {}, {z12Run}, {}});
+  }
+
+  {
+    MultiBody mbXYZ;
+    MultiBodyConfig mbcXYZ;
+    std::tie(mbXYZ, mbcXYZ) = makeXYZ12Arm(false);
+    for(int i = 1; i < mbXYZ.nrJoints(); ++i)
+    {
+      mbcXYZ.q[i][0] = 0.1;
+    }
+
+    pg::RobotConfig rc(mbXYZ);
+    rc.fixedPosContacts = {{12, Vector3d(1., 2., 1.), PTransformd::Identity()}};
+    rc.fixedOriContacts = {{12, Matrix3d(RotX(cst::pi<double>()/2.)),
+                            PTransformd::Identity()}};
+    rc.postureScale = 1.;
+    corpus.push_back({"XYZ12 pose", {rc}, {}, {{mbcXYZ.q, {}, mbcXYZ.q}}, {}});
+  }
+
+  {
+    SyntheticModel chain(makeSyntheticModel(SyntheticModelConfig(48)));
+    SyntheticScenario sc(makeSyntheticScenario(chain, SyntheticScenarioConfig(1)));
+    corpus.push_back({"chain48 position", {sc.robotConfig}, {}, {sc.runConfig}, {}});
+  }
+
+  /*
+   *   Planar multi-contact
+   */
+  {
+    pg::RobotConfig rc(mb);
+    rc.planarContacts = {{12, PTransformd(frame, Vector3d(0., 1., 0.)), targetPoints,
+                          PTransformd(frame), surfPoints}};
+    rc.forceContacts = {{0, {PTransformd(frame, Vector3d(0.01, 0., 0.)),
+                             PTransformd(frame, Vector3d(-0.01, 0., 0.))}, 1.},
+                        {12, {PTransformd(frame, Vector3d(0.1, 0., 0.)),
+                              PTransformd(frame, Vector3d(-0.1, 0., 0.))}, 1.}};
+    rc.bodyPosTargets = {{12, Vector3d(2., 1., 0.), 10.}};
+    corpus.push_back({"Z12 planar static", {rc}, {}, {z12Run}, {}});
+  }
+
+  {
+    // 4 leaves, each one on an horizontal plane at its random posture position
+    SyntheticModel tree(makeSyntheticModel(SyntheticModelConfig(8, 2, 2)));
+    SyntheticScenario sc(makeSyntheticScenario(tree, SyntheticScenarioConfig(4, 16)));
+    pg::RobotConfig rc(sc.robotConfig);
+    for(const pg::FixedPositionContact& fpc: rc.fixedPosContacts)
+    {
+      rc.planarContacts.push_back({fpc.bodyId, PTransformd(fpc.target), targetPoints,
+                                   PTransformd::Identity(), surfPoints});
+    }
+    rc.fixedPosContacts.clear();
+    corpus.push_back({"tree8x4 planar static", {rc}, {}, {sc.runConfig}, {}});
+    addHulls(corpus.back(), tree, sc);
+  }
+
+  /*
+   *   Gripper and cylinder
+   */
+  {
+    pg::RobotConfig rc(mb);
+    rc.gripperContacts = {{12, PTransformd(frame, Vector3d(0., 1., 0.)), targetPoints,
+                           PTransformd(frame), surfPoints}};
+    rc.cylindricalContacts = {{6, 0.1, 5.,
+                               PTransformd(RotY(cst::pi<double>()/2.), Vector3d(0., 1., 0.)),
+                               PTransformd(Matrix3d(RotX(cst::pi<double>()/2.)*
+                                                    RotY(cst::pi<double>()/2.)))}};
+    rc.postureScale = 1e-2;
+    corpus.push_back({"Z12 gripper cylinder", {rc}, {}, {z12Run}, {}});
+  }
+
+  /*
+   *   Collision heavy
+   */
+  {
+    BenchProblem bp{"Z12 env collision", {}, {}, {z12Run}, {}};
+    pg::RobotConfig rc(mb);
+    rc.bodyPosTargets = {{12, Vector3d::Zero(), 0.1}};
+    for(int i = 0; i < 4; ++i)
+    {
+      boost::shared_ptr<sch::S_Sphere> body(new sch::S_Sphere(0.2));
+      boost::shared_ptr<sch::S_Sphere> env(new sch::S_Sphere(0.3));
+      env->setTransformation(pg::tosch(PTransformd(Vector3d(0.5*i, 0.5, 0.))));
+      rc.envCollisions.push_back({12 - i, body.get(), PTransformd::Identity(),
+                                  env.get(), 0.05});
+      bp.hulls.push_back(body);
+      bp.hulls.push_back(env);
+    }
+    bp.robotConfigs = {rc};
+    corpus.push_back(bp);
+  }
+
+  {
+    // 2 leaves
+    SyntheticModel tree(makeSyntheticModel(SyntheticModelConfig(8, 2, 1)));
+    SyntheticScenario sc(makeSyntheticScenario(tree, SyntheticScenarioConfig(2, 0, 8, 16, 1)));
+    corpus.push_back({"tree8x2 collisions", {sc.robotConfig}, {}, {sc.runConfig}, {}});
+    addHulls(corpus.back(), tree, sc);
+  }
+
+  /*
+   *   Linked multi-robot
+   */
+  {
+    pg::RobotConfig rc1(mb), rc2(mb);
+    rc1.fixedPosContacts = {{12, target, PTransformd::Identity()}};
+    rc1.fixedOriContacts = {{12, oriTarget, PTransformd::Identity()}};
+    pg::RobotLink rl(0, 1, {{12, PTransformd::Identity(), PTransformd::Identity()}});
+    corpus.push_back({"Z12x2 linked", {rc1, rc2}, {rl}, {z12Run, z12Run}, {}});
+  }
+
+  {
+    pg::RobotConfig rc1(mb), rc2(mb), rc3(mb);
+    rc1.fixedPosContacts = {{12, target, PTransformd::Identity()}};
+    rc3.bodyPosTargets = {{12, Vector3d(1., 1., 0.), 1.}};
+    pg::RobotLink rl1(0, 1, {{12, PTransformd::Identity(), PTransformd::Identity()}});
+    pg::RobotLink rl2(1, 2, {{6, PTransformd::Identity(), PTransformd::Identity()}});
+    corpus.push_back({"Z12x3 linked", {rc1, rc2, rc3}, {rl1, rl2},
+                      {z12Run, z12Run, z12Run}, {}});
+  }
+
+  return corpus;
+}
+
+
+BenchResult runProblem(const BenchProblem& bp, int nrRun)
+{
+  pg::PostureGenerator pgPb;
+  pgPb.param("ipopt.print_level", 0);
+  pgPb.param("ipopt.linear_solver", "mumps");
+  pgPb.iterateRecording(pg::IterateRecording(pg::IterateRecording::Quantities));
+  pgPb.robotConfigs(bp.robotConfigs, gravity);
+  pgPb.robotLinks(bp.robotLinks);
+
+  int nrSuccess = 0;
+  int nrIters = 0;
+  std::vector<double> times;
+  for(int i = 0; i < nrRun; ++i)
+  {
+    auto start = std::chrono::steady_clock::now();
+    nrSuccess += pgPb.run(bp.runConfigs) ? 1 : 0;
+    std::chrono::duration<double, std::milli> time =
+      std::chrono::steady_clock::now() - start;
+    times.push_back(time.count());
+    nrIters = std::max(nrIters, pgPb.nrIters());
+  }
+
+  pgPb.profiling(true);
+  pgPb.run(bp.runConfigs);
+  int nrEvals = 0;
+  for(const pg::FunctionProfile& fp: pgPb.profile().functions)
+  {
+    nrEvals += fp.compute.calls + fp.jacobian.calls + fp.gradient.calls;
+  }
+
+  BenchResult res{bp.name, double(nrSuccess)/nrRun, 0., 0., 0., nrIters, nrEvals};
+  if(!times.empty())
+  {
+    std::sort(times.begin(), times.end());
+    for(double t: times)
+    {
+      res.meanMs += t/nrRun;
+    }
+    res.medianMs = times[times.size()/2];
+    res.minMs = times.front();
+  }
+  return res;
+}
+
+
+/*
+ *   Results file: one tab separated line per problem
+ *   name, success rate, mean, median, min (ms), iterations, evaluations
+ *   Lines starting with # are comments.
+ */
+
+
+void writeResults(std::ostream& out, const std::vector<BenchResult>& results)
+{
+  out << "# name\tsuccess\tmean (ms)\tmedian (ms)\tmin (ms)\titers\tevals\n";
+  for(const BenchResult& r: results)
+  {
+    out << r.name << '\t' << r.successRate << '\t' << r.meanMs << '\t'
+        << r.medianMs << '\t' << r.minMs << '\t' << r.nrIters << '\t'
+        << r.nrEvals << '\n';
+  }
+}
+
+
+std::map<std::string, BenchResult> readResults(const std::string& file)
+{
+  std::ifstream in(file);
+  if(!in)
+  {
+    std::cerr << "Can't open baseline " << file << std::endl;
+    std::exit(2);
+  }
+
+  std::map<std::string, BenchResult> results;
+  std::string line;
+  while(std::getline(in, line))
+  {
+    if(line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+    std::istringstream ls(line);
+    BenchResult r;
+    if(std::getline(ls, r.name, '\t') &&
+       ls >> r.successRate >> r.meanMs >> r.medianMs >> r.minMs
+          >> r.nrIters >> r.nrEvals)
+    {
+      results[r.name] = r;
+    }
+  }
+  return results;
+}
+
+
+int main(int argc, char** argv)
+{
+  int nrRun = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 10;
+  std::string baselineFile = argc > 2 ? argv[2] : "-";
+  double tolerance = argc > 4 ? std::atof(argv[4]) : 10.;
+  double iterTolerance = argc > 5 ? std::atof(argv[5]) : 10.;
+
+  std::map<std::string, BenchResult> baseline;
+  if(baselineFile != "-")
+  {
+    baseline = readResults(baselineFile);
+    if(baseline.empty())
+    {
+      std::cerr << "No result in baseline " << baselineFile << std::endl;
+    }
+  }
+
+  std::cout << std::left << std::setw(24) << "problem"
+            << std::right << std::setw(9) << "success"
+            << std::setw(12) << "mean (ms)"
+            << std::setw(12) << "median (ms)"
+            << std::setw(12) << "min (ms)"
+            << std::setw(8) << "iters"
+            << std::setw(8) << "evals";
+  if(!baseline.empty())
+  {
+    std::cout << std::setw(10) << "vs base";
+  }
+  std::cout << std::endl;
+
+  bool regression = false;
+  std::vector<BenchResult> results;
+  for(const BenchProblem& bp: makeCorpus())
+  {
+    BenchResult r = runProblem(bp, nrRun);
+    results.push_back(r);
+
+    std::cout << std::left << std::setw(24) << r.name
+              << std::right << std::setw(8) << 100.*r.successRate << "%"
+              << std::setw(12) << r.meanMs
+              << std::setw(12) << r.medianMs
+              << std::setw(12) << r.minMs
+              << std::setw(8) << r.nrIters
+              << std::setw(8) << r.nrEvals;
+
+    auto base = baseline.find(r.name);
+    if(base != baseline.end())
+    {
+      const BenchResult& b = base->second;
+      double change = 100.*(r.medianMs - b.medianMs)/b.medianMs;
+      std::ostringstream changeStr;
+      changeStr << std::showpos << std::fixed << std::setprecision(1) << change << "%";
+      std::cout << std::setw(10) << changeStr.str();
+
+      if(change > tolerance)
+      {
+        std::cout << "  slower";
+        regression = true;
+      }
+      if(r.successRate < b.successRate)
+      {
+        std::cout << "  success " << 100.*b.successRate << "%";
+        regression = true;
+      }
+      if(r.nrIters > b.nrIters*(1. + iterTolerance/100.))
+      {
+        std::cout << "  iters " << b.nrIters;
+        regression = true;
+      }
+    }
+    else if(!baseline.empty())
+    {
+      std::cout << std::setw(10) << "new";
+    }
+    std::cout << std::endl;
+  }
+
+  if(argc > 3)
+  {
+    std::ofstream out(argv[3]);
+    writeResults(out, results);
+  }
+
+  return regression ? 1 : 0;
+}
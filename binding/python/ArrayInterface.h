@@ -0,0 +1,108 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <cstdint>
+
+// PG
+#include <PostureGenerator.h>
+
+
+namespace pg
+{
+
+/**
+  * Copy of a PostureGenerator vector owned by its NumPy views (see __init__.py).
+  * The next run reallocates x and Ring recording overwrites the iterates
+  * without allocating, so the views can't point into the solver memory.
+  */
+class VectorBuffer
+{
+public:
+  VectorBuffer()
+  {}
+
+  VectorBuffer(const Eigen::VectorXd& v)
+    : data_(v)
+  {}
+
+  unsigned long long address() const
+  {
+    return static_cast<unsigned long long>(
+      reinterpret_cast<std::uintptr_t>(data_.data()));
+  }
+
+  int size() const
+  {
+    return int(data_.size());
+  }
+
+private:
+  Eigen::VectorXd data_;
+};
+
+
+// Returned by pointer so that Python own the only copy.
+
+inline VectorBuffer* xBuffer(const PostureGenerator& pgPb)
+{
+  return new VectorBuffer(pgPb.x());
+}
+
+
+inline VectorBuffer* xIterBuffer(const PostureGenerator& pgPb, int i)
+{
+  return new VectorBuffer(pgPb.xIter(i));
+}
+
+
+// Address and size of the BatchResult solutions used by the
+// __array_interface__ of the batch NumPy view.
+
+inline unsigned long long batchXAddress(const BatchResult& res)
+{
+  return static_cast<unsigned long long>(
+    reinterpret_cast<std::uintptr_t>(res.x.data()));
+}
+
+
+inline int batchXSize(const BatchResult& res)
+{
+  return int(res.x.rows());
+}
+
+
+// PostureGenerator::runBatch on C-contiguous NumPy buffers:
+// initQ (nrQueries, nrQ) and targets (nrQueries, nrTargets) rows are queries,
+// the same memory is seen by Eigen as column-major (nrQ, nrQueries).
+inline BatchResult runBatchBuffers(const PostureGenerator& pgPb,
+                                   const std::vector<RunConfig>& configs,
+                                   unsigned long long initQAddress, int nrQueries, int nrQ,
+                                   const std::vector<TargetParameter>& params,
+                                   unsigned long long targetsAddress, int nrTargets,
+                                   int nrThreads)
+{
+  typedef Eigen::Map<const Eigen::MatrixXd> MapXd;
+  MapXd initQ(reinterpret_cast<const double*>(std::uintptr_t(initQAddress)),
+              nrQ, nrQueries);
+  MapXd targets(reinterpret_cast<const double*>(std::uintptr_t(targetsAddress)),
+                nrTargets, nrTargets > 0 ? nrQueries : 0);
+  return pgPb.runBatch(configs, initQ, params, targets, nrThreads);
+}
+
+} // namespace pg
@@ -15,3 +15,94 @@
 
 from _pg import *
 
+
+import sys as _sys
+
+
+class ArrayView(object):
+  """
+  Read-only view of a C-contiguous array of shape shape through
+  the NumPy __array_interface__. The view, and the arrays built from it,
+  keep owner, the object holding the memory at address, alive.
+  """
+  def __init__(self, owner, address, shape):
+    self.owner = owner
+    self.__array_interface__ = {
+      'version': 3,
+      'typestr': ('<' if _sys.byteorder == 'little' else '>') + 'f8',
+      'data': (address, True),
+      'shape': shape,
+    }
+
+
+def _array(owner, address, shape):
+  import numpy
+  return numpy.asarray(ArrayView(owner, address, shape))
+
+
+def _bufferArray(buf):
+  return _array(buf, buf.address(), (buf.size(),))
+
+
+def xArray(pgPb):
+  """
+  Copy of the last run solution (PostureGenerator.x) as a NumPy array.
+  The copy is made once in C++ and owned by the array, so it stays valid
+  after the next run. Slice it with qArray and forcesArray.
+  """
+  return _bufferArray(xBuffer(pgPb))
+
+
+def xIterArray(pgPb, i):
+  """Copy of x of iterate i as a NumPy array (see xArray)."""
+  return _bufferArray(xIterBuffer(pgPb, i))
+
+
+def xIterArrays(pgPb):
+  """Copies of x of all the stored iterates as NumPy arrays."""
+  return [xIterArray(pgPb, i) for i in range(pgPb.nrIters())]
+
+
+def qArray(pgPb, x, robot=0):
+  """
+  Robot joints parameters as a view of x, an array returned by xArray or
+  xIterArray (rbd.paramToVector order, free joint quaternion not normalized).
+  """
+  begin = pgPb.qParamsBegin(robot)
+  return x[begin:begin + pgPb.nrParams(robot)]
+
+
+def forcesArray(pgPb, x, robot=0):
+  """
+  Robot contact forces as a view of shape (n, 3) of x, an array returned by
+  xArray or xIterArray.
+  """
+  begin = pgPb.forceParamsBegin(robot)
+  nrPoints = pgPb.nrForcePoints(robot)
+  return x[begin:begin + 3*nrPoints].reshape((nrPoints, 3))
+
+
+def runBatch(pgPb, configs, initQ, params=None, targets=None, nrThreads=0):
+  """
+  Solve a batch of queries on a native thread pool without the GIL
+  (see PostureGenerator.runBatch). Like with PostureGenerator.run, other
+  Python threads must not use pgPb until it returns.
+  initQ is a (nrQueries, nrQ) array of the joints parameters of all robots
+  of each starting point, targets a (nrQueries, nrTargets) array of the
+  params targets displacements.
+  Return the success and number of iterations of each query and a
+  (nrQueries, xSize) view of the solutions (NaN rows if no result).
+  """
+  import numpy
+  initQ = numpy.ascontiguousarray(initQ, dtype=numpy.float64)
+  if params is None:
+    params = []
+  if targets is None:
+    targets = numpy.zeros((initQ.shape[0], 0))
+  targets = numpy.ascontiguousarray(targets, dtype=numpy.float64)
+  res = runBatchBuffers(pgPb, configs,
+                        initQ.ctypes.data, initQ.shape[0], initQ.shape[1],
+                        params,
+                        targets.ctypes.data, targets.shape[1], nrThreads)
+  x = _array(res, batchXAddress(res), (initQ.shape[0], batchXSize(res)))
+  return (numpy.array(res.success, dtype=bool), x, numpy.array(res.nrIters))
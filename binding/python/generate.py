@@ -69,12 +69,29 @@ def build_pg(pg):
   normalForceTarget = pg.add_struct('NormalForceTarget')
   tanForceMin = pg.add_struct('TangentialForceMinimization')
   iterateQuantities = pg.add_struct('IterateQuantities')
+  iterateData = pg.add_struct('IterateData')
+  iterateRecording = pg.add_struct('IterateRecording')
+  profileCounter = pg.add_struct('ProfileCounter')
+  functionProfile = pg.add_struct('FunctionProfile')
+  robotProfile = pg.add_struct('RobotProfile')
+  profile = pg.add_struct('Profile')
+  tracer = pg.add_class('Tracer')
+  capturedProblem = pg.add_struct('CapturedProblem')
+  reachabilityConfig = pg.add_struct('ReachabilityConfig')
+  reachabilityMap = pg.add_class('ReachabilityMap')
+  unreachableContact = pg.add_struct('UnreachableContact')
+  targetParameter = pg.add_struct('TargetParameter')
+  batchResult = pg.add_struct('BatchResult')
+  vectorBuffer = pg.add_class('VectorBuffer')
   ellipseResult = pg.add_struct('EllipseResult')
   comHalfSpace = pg.add_struct('CoMHalfSpace')
   runConfig = pg.add_struct('RunConfig')
   bodyLink = pg.add_struct('BodyLink')
   robotLink = pg.add_struct('RobotLink')
   cylindricalContact = pg.add_struct('CylindricalContact')
+  runHandle = pg.add_class('RunHandle')
+  runProgress = pg.add_struct('Progress', outer_class=runHandle)
+  pgOptions = pg.add_struct('Options', outer_class=pgSolver)
 
   # build list type
   pg.add_container('std::vector<pg::FixedPositionContact>', 'pg::FixedPositionContact', 'vector')
@@ -96,13 +113,24 @@ def build_pg(pg):
   pg.add_container('std::vector<Eigen::VectorXd>', 'Eigen::VectorXd', 'vector')
   pg.add_container('std::vector<std::vector<Eigen::VectorXd> >', 'std::vector<Eigen::VectorXd>', 'vector')
   pg.add_container('std::vector<pg::EllipseResult>', 'pg::EllipseResult', 'vector')
+  pg.add_container('std::vector<pg::IterateData>', 'pg::IterateData', 'vector')
+  pg.add_container('std::vector<pg::FunctionProfile>', 'pg::FunctionProfile', 'vector')
+  pg.add_container('std::vector<pg::RobotProfile>', 'pg::RobotProfile', 'vector')
   pg.add_container('std::vector<pg::RobotConfig>', 'pg::RobotConfig', 'vector')
   pg.add_container('std::vector<pg::RunConfig>', 'pg::RunConfig', 'vector')
+  pg.add_container('std::vector<int>', 'int', 'vector')
   pg.add_container('std::vector<pg::BodyLink>', 'pg::BodyLink', 'vector')
   pg.add_container('std::vector<pg::RobotLink>', 'pg::RobotLink', 'vector')
   pg.add_container('std::vector<pg::CylindricalContact>', 'pg::CylindricalContact', 'vector')
+  pg.add_container('std::vector<pg::ReachabilityMap>', 'pg::ReachabilityMap', 'vector')
+  pg.add_container('std::vector<std::vector<pg::ReachabilityMap> >', 'std::vector<pg::ReachabilityMap>', 'vector')
+  pg.add_container('std::vector<pg::UnreachableContact>', 'pg::UnreachableContact', 'vector')
+  pg.add_container('std::vector<pg::TargetParameter>', 'pg::TargetParameter', 'vector')
 
   # PostureGenerator
+  pgSolver.add_enum('Engine', ['AutoEngine', 'IpoptEngine', 'LMEngine', 'CustomEngine'])
+  pgSolver.add_enum('ResultSelection', ['NoResult', 'Converged',
+                                        'LowestCostFeasible', 'LeastViolating'])
   pgSolver.add_constructor([])
 
   pgSolver.add_method('robotConfigs', None, [param('std::vector<pg::RobotConfig>', 'rc'), param('const Eigen::Vector3d&', 'gravity')])
@@ -117,7 +145,69 @@ def build_pg(pg):
   pgSolver.add_method('param', None, [param('const std::string&', 'name'), param('int', 'value')])
   pgSolver.add_method('param', None, [param('const std::string&', 'name'), param('double', 'value')])
 
-  pgSolver.add_method('run', retval('bool'), [param('const std::vector<pg::RunConfig>&', 'config')])
+  pgSolver.add_method('options', None, [param('pg::PostureGenerator::Options', 'options')],
+                      throw=[dom_ex])
+  pgSolver.add_method('options', retval('pg::PostureGenerator::Options'), [], is_const=True)
+  pgSolver.add_method('parallelUpdate', None, [param('bool', 'parallel')])
+  pgSolver.add_method('parallelUpdate', retval('bool'), [], is_const=True)
+  pgSolver.add_method('modelReduction', None, [param('bool', 'reduce')])
+  pgSolver.add_method('modelReduction', retval('bool'), [], is_const=True)
+  pgSolver.add_method('contactProjection', None, [param('int', 'nrIter')])
+  pgSolver.add_method('contactProjection', retval('int'), [], is_const=True)
+  pgSolver.add_method('engine', None, [param('pg::PostureGenerator::Engine', 'engine')],
+                      throw=[dom_ex])
+  pgSolver.add_method('engine', retval('pg::PostureGenerator::Engine'), [], is_const=True)
+  pgSolver.add_method('usedEngine', retval('pg::PostureGenerator::Engine'), [], is_const=True)
+  pgSolver.add_method('deadline', None, [param('double', 'seconds')])
+  pgSolver.add_method('deadline', retval('double'), [], is_const=True)
+  pgSolver.add_method('resultSelection', retval('pg::PostureGenerator::ResultSelection'), [], is_const=True)
+  pgSolver.add_method('iterateRecording', None, [param('pg::IterateRecording', 'recording')])
+  pgSolver.add_method('iterateRecording', retval('pg::IterateRecording'), [], is_const=True)
+  pgSolver.add_method('profiling', None, [param('bool', 'profile')])
+  pgSolver.add_method('profiling', retval('bool'), [], is_const=True)
+  pgSolver.add_method('profile', retval('pg::Profile'), [], is_const=True)
+  pgSolver.add_method('tracing', None, [param('bool', 'trace')])
+  pgSolver.add_method('tracing', retval('bool'), [], is_const=True)
+  pgSolver.add_method('traceCapacity', None, [param('int', 'capacity')],
+                      throw=[dom_ex])
+  pgSolver.add_method('traceCapacity', retval('int'), [], is_const=True)
+  pgSolver.add_method('tracer', retval('pg::Tracer'), [], is_const=True)
+
+  pgSolver.add_method('reachabilityMaps', None,
+                      [param('std::vector<std::vector<pg::ReachabilityMap> >', 'maps'),
+                       param('bool', 'reject', default_value='false')])
+  pgSolver.add_method('reachabilityMaps', retval('std::vector<std::vector<pg::ReachabilityMap> >'),
+                      [], is_const=True)
+  pgSolver.add_method('unreachableContacts', retval('std::vector<pg::UnreachableContact>'),
+                      [], is_const=True)
+
+  pgSolver.add_method('sensitivityParameters', None,
+                      [param('std::vector<pg::TargetParameter>', 'params')],
+                      throw=[out_ex])
+  pgSolver.add_method('sensitivityParameters', retval('std::vector<pg::TargetParameter>'),
+                      [], is_const=True)
+  pgSolver.add_method('sensitivity', retval('Eigen::MatrixXd'), [], is_const=True)
+  pgSolver.add_method('qSensitivity', retval('Eigen::MatrixXd'), [param('int', 'robot')],
+                      is_const=True, throw=[out_ex])
+
+  # the GIL is released while solving, other Python threads must not use
+  # this PostureGenerator until run returns
+  pgSolver.add_method('run', retval('bool'), [param('const std::vector<pg::RunConfig>&', 'config')],
+                      throw=[run_ex], unblock_threads=True,
+                      docstring='Solve the problem without holding the GIL. '
+                                'Other threads must not use this object until run returns.')
+  pgSolver.add_method('runAsync', retval('pg::RunHandle'), [param('std::vector<pg::RunConfig>', 'config')],
+                      throw=[log_ex])
+
+  pgSolver.add_method('x', retval('Eigen::VectorXd'), [], is_const=True)
+  pgSolver.add_method('qParamsBegin', retval('int'), [param('int', 'robot')],
+                      is_const=True, throw=[out_ex])
+  pgSolver.add_method('nrParams', retval('int'), [param('int', 'robot')],
+                      is_const=True, throw=[out_ex])
+  pgSolver.add_method('forceParamsBegin', retval('int'), [param('int', 'robot')],
+                      is_const=True, throw=[out_ex])
+  pgSolver.add_method('nrForcePoints', retval('int'), [param('int', 'robot')],
+                      is_const=True, throw=[out_ex])
 
   pgSolver.add_method('q', retval('std::vector<std::vector<double> >'), [], is_const=True)
   pgSolver.add_method('forces', retval('std::vector<sva::ForceVecd>'), [], is_const=True)
@@ -152,6 +242,12 @@ def build_pg(pg):
                       [param('int', 'robot'), param('int', 'iter')], throw=[out_ex], is_const=True)
   pgSolver.add_method('quantitiesIter', retval('pg::IterateQuantities'),
                       [param('int', 'iter')], throw=[out_ex], is_const=True)
+  pgSolver.add_method('xIter', retval('Eigen::VectorXd'),
+                      [param('int', 'iter')], throw=[out_ex], is_const=True)
+  pgSolver.add_method('capture', retval('pg::CapturedProblem'),
+                      [param('const std::vector<pg::RunConfig>&', 'configs'),
+                       param('bool', 'withResult', default_value='false')],
+                      is_const=True)
 
   # FixedPositionContact
   fixedPositionContact.add_constructor([])
@@ -368,6 +464,7 @@ def build_pg(pg):
   runConfig.add_instance_attribute('initQ', 'std::vector<std::vector<double> >')
   runConfig.add_instance_attribute('initForces', 'std::vector<sva::ForceVecd>')
   runConfig.add_instance_attribute('targetQ', 'std::vector<std::vector<double> >')
+  runConfig.add_instance_attribute('lockedJoints', 'std::vector<int>')
 
   # BodyLink
   bodyLink.add_constructor([])
@@ -401,10 +498,191 @@ def build_pg(pg):
   cylindricalContact.add_instance_attribute('targetFrame', 'sva::PTransformd')
   cylindricalContact.add_instance_attribute('surfaceFrame', 'sva::PTransformd')
 
+  # RunHandle
+  runHandle.add_constructor([])
+  runHandle.add_method('valid', retval('bool'), [], is_const=True)
+  runHandle.add_method('cancel', None, [])
+  runHandle.add_method('done', retval('bool'), [], throw=[log_ex], is_const=True)
+  runHandle.add_method('wait', retval('bool'), [param('double', 'seconds')],
+                       throw=[log_ex], is_const=True, unblock_threads=True)
+  runHandle.add_method('get', retval('bool'), [], throw=[log_ex], is_const=True,
+                       unblock_threads=True)
+  runHandle.add_method('progress', retval('pg::RunHandle::Progress'), [], is_const=True)
+
+  runProgress.add_instance_attribute('nrIters', 'int')
+  runProgress.add_instance_attribute('obj', 'double')
+  runProgress.add_instance_attribute('constr_viol', 'double')
+
   # IterateQuantities
   iterateQuantities.add_instance_attribute('obj', 'double')
   iterateQuantities.add_instance_attribute('constr_viol', 'double')
 
+  # IterateData
+  iterateData.add_instance_attribute('x', 'Eigen::VectorXd')
+  iterateData.add_instance_attribute('obj', 'double')
+  iterateData.add_instance_attribute('constr_viol', 'double')
+
+  pg.add_function('readIterateFile', retval('std::vector<pg::IterateData>'),
+                  [param('const std::string&', 'file')],
+                  throw=[run_ex])
+
+  # IterateRecording
+  iterateRecording.add_enum('Mode', ['All', 'Off', 'Quantities', 'Ring', 'File'])
+  iterateRecording.add_constructor([])
+  iterateRecording.add_constructor([param('pg::IterateRecording::Mode', 'mode'),
+                                    param('int', 'ringSize', default_value='10'),
+                                    param('std::string', 'file', default_value='std::string()')])
+  iterateRecording.add_instance_attribute('mode', 'pg::IterateRecording::Mode')
+  iterateRecording.add_instance_attribute('ringSize', 'int')
+  iterateRecording.add_instance_attribute('file', 'std::string')
+
+  # Profile
+  profileCounter.add_instance_attribute('calls', 'int')
+  profileCounter.add_instance_attribute('time', 'double')
+
+  functionProfile.add_instance_attribute('name', 'std::string')
+  functionProfile.add_instance_attribute('compute', 'pg::ProfileCounter')
+  functionProfile.add_instance_attribute('jacobian', 'pg::ProfileCounter')
+  functionProfile.add_instance_attribute('gradient', 'pg::ProfileCounter')
+  functionProfile.add_instance_attribute('jacobianNnz', 'int')
+
+  robotProfile.add_instance_attribute('fk', 'pg::ProfileCounter')
+  robotProfile.add_instance_attribute('collision', 'pg::ProfileCounter')
+
+  profile.add_instance_attribute('functions', 'std::vector<pg::FunctionProfile>')
+  profile.add_instance_attribute('robots', 'std::vector<pg::RobotProfile>')
+  profile.add_instance_attribute('solve', 'pg::ProfileCounter')
+  profile.add_method('functionsTime', retval('double'), [], is_const=True)
+  profile.add_method('solverTime', retval('double'), [], is_const=True)
+  profile.add_method('report', retval('std::string'), [], is_const=True)
+
+  # Tracer
+  tracer.add_method('nrLanes', retval('int'), [], is_const=True)
+  tracer.add_method('nrEvents', retval('int'), [], is_const=True)
+  tracer.add_method('nrDropped', retval('int'), [], is_const=True)
+  tracer.add_method('laneCapacity', retval('int'), [], is_const=True)
+  tracer.add_method('write', None, [param('const std::string&', 'file')],
+                    throw=[run_ex], is_const=True)
+
+  # PostureGenerator::Options (params and backend are set with PostureGenerator)
+  pgOptions.add_constructor([])
+  pgOptions.add_instance_attribute('parallelUpdate', 'bool')
+  pgOptions.add_instance_attribute('modelReduction', 'bool')
+  pgOptions.add_instance_attribute('contactProjection', 'int')
+  pgOptions.add_instance_attribute('engine', 'pg::PostureGenerator::Engine')
+  pgOptions.add_instance_attribute('deadline', 'double')
+  pgOptions.add_instance_attribute('maxIter', 'int')
+  pgOptions.add_instance_attribute('recording', 'pg::IterateRecording')
+  pgOptions.add_instance_attribute('profiling', 'bool')
+  pgOptions.add_instance_attribute('tracing', 'bool')
+
+  # CapturedProblem
+  capturedProblem.add_constructor([])
+  capturedProblem.add_method('setup', None, [param('pg::PostureGenerator&', 'pg')],
+                             is_const=True)
+  capturedProblem.add_instance_attribute('robotConfigs', 'std::vector<pg::RobotConfig>')
+  capturedProblem.add_instance_attribute('gravity', 'Eigen::Vector3d')
+  capturedProblem.add_instance_attribute('robotLinks', 'std::vector<pg::RobotLink>')
+  capturedProblem.add_instance_attribute('runConfigs', 'std::vector<pg::RunConfig>')
+  capturedProblem.add_instance_attribute('options', 'pg::PostureGenerator::Options')
+  capturedProblem.add_instance_attribute('backendName', 'std::string')
+  capturedProblem.add_instance_attribute('hasResult', 'bool')
+  capturedProblem.add_instance_attribute('resultSelection', 'pg::PostureGenerator::ResultSelection')
+  capturedProblem.add_instance_attribute('x', 'Eigen::VectorXd')
+  capturedProblem.add_instance_attribute('iterates', 'std::vector<pg::IterateData>')
+
+  pg.add_function('saveProblem', None,
+                  [param('const std::string&', 'file'),
+                   param('const pg::CapturedProblem&', 'problem')],
+                  throw=[dom_ex, run_ex])
+  pg.add_function('loadProblem', retval('pg::CapturedProblem'),
+                  [param('const std::string&', 'file')],
+                  throw=[run_ex])
+
+  # ReachabilityMap
+  reachabilityConfig.add_constructor([param('double', 'voxelSize', default_value='0.05'),
+                                      param('int', 'nrSamples', default_value='1000000'),
+                                      param('int', 'nrThreads', default_value='0'),
+                                      param('unsigned int', 'seed', default_value='0')])
+  reachabilityConfig.add_instance_attribute('voxelSize', 'double')
+  reachabilityConfig.add_instance_attribute('nrSamples', 'int')
+  reachabilityConfig.add_instance_attribute('nrThreads', 'int')
+  reachabilityConfig.add_instance_attribute('seed', 'unsigned int')
+
+  reachabilityMap.add_constructor([])
+  reachabilityMap.add_method('bodyId', retval('int'), [], is_const=True)
+  reachabilityMap.add_method('axis', retval('Eigen::Vector3d'), [], is_const=True)
+  reachabilityMap.add_method('voxelSize', retval('double'), [], is_const=True)
+  reachabilityMap.add_method('nrReached', retval('int'), [], is_const=True)
+  reachabilityMap.add_method('reachable', retval('bool'),
+                             [param('const Eigen::Vector3d&', 'pos'),
+                              param('double', 'radius')], is_const=True)
+  reachabilityMap.add_method('reachable', retval('bool'),
+                             [param('const Eigen::Vector3d&', 'pos'),
+                              param('double', 'radius'),
+                              param('const Eigen::Vector3d&', 'dir')], is_const=True)
+
+  unreachableContact.add_instance_attribute('robot', 'int')
+  unreachableContact.add_instance_attribute('bodyId', 'int')
+  unreachableContact.add_instance_attribute('target', 'Eigen::Vector3d')
+
+  pg.add_function('buildReachabilityMaps', retval('std::vector<pg::ReachabilityMap>'),
+                  [param('const rbd::MultiBody&', 'mb'),
+                   param('const std::vector<std::vector<double> >&', 'ql'),
+                   param('const std::vector<std::vector<double> >&', 'qu'),
+                   param('const std::vector<int>&', 'bodyIds'),
+                   param('const std::vector<Eigen::Vector3d>&', 'axes'),
+                   param('const pg::ReachabilityConfig&', 'config')],
+                  throw=[dom_ex])
+  pg.add_function('saveReachabilityMaps', None,
+                  [param('const std::string&', 'file'),
+                   param('const std::vector<pg::ReachabilityMap>&', 'maps')],
+                  throw=[run_ex])
+  pg.add_function('loadReachabilityMaps', retval('std::vector<pg::ReachabilityMap>'),
+                  [param('const std::string&', 'file')],
+                  throw=[run_ex])
+
+  # NumPy views (see __init__.py)
+  pg.add_function('xBuffer', retval('pg::VectorBuffer*', caller_owns_return=True),
+                  [param('const pg::PostureGenerator&', 'pg')])
+  pg.add_function('xIterBuffer', retval('pg::VectorBuffer*', caller_owns_return=True),
+                  [param('const pg::PostureGenerator&', 'pg'), param('int', 'iter')],
+                  throw=[out_ex])
+  pg.add_function('batchXAddress', retval('unsigned long long'),
+                  [param('const pg::BatchResult&', 'res')])
+  pg.add_function('batchXSize', retval('int'),
+                  [param('const pg::BatchResult&', 'res')])
+  pg.add_function('runBatchBuffers', retval('pg::BatchResult'),
+                  [param('const pg::PostureGenerator&', 'pg'),
+                   param('const std::vector<pg::RunConfig>&', 'configs'),
+                   param('unsigned long long', 'initQAddress'),
+                   param('int', 'nrQueries'), param('int', 'nrQ'),
+                   param('const std::vector<pg::TargetParameter>&', 'params'),
+                   param('unsigned long long', 'targetsAddress'),
+                   param('int', 'nrTargets'), param('int', 'nrThreads')],
+                  throw=[dom_ex, out_ex, run_ex], unblock_threads=True)
+
+  # VectorBuffer
+  vectorBuffer.add_constructor([])
+  vectorBuffer.add_method('address', retval('unsigned long long'), [], is_const=True)
+  vectorBuffer.add_method('size', retval('int'), [], is_const=True)
+
+  # BatchResult
+  batchResult.add_constructor([])
+  batchResult.add_instance_attribute('success', 'std::vector<int>')
+  batchResult.add_instance_attribute('nrIters', 'std::vector<int>')
+
+  # TargetParameter
+  targetParameter.add_enum('Kind', ['BodyPosition', 'BodyOrientation', 'FixedPosition',
+                                    'FixedOrientation', 'PlanarFrame', 'TargetQ'])
+  targetParameter.add_constructor([])
+  targetParameter.add_constructor([param('pg::TargetParameter::Kind', 'kind'),
+                                   param('int', 'robot'),
+                                   param('int', 'index')])
+  targetParameter.add_instance_attribute('kind', 'pg::TargetParameter::Kind')
+  targetParameter.add_instance_attribute('robot', 'int')
+  targetParameter.add_instance_attribute('index', 'int')
+
   # EllipseResult
   ellipseResult.add_instance_attribute('bodyIndex', 'int')
   ellipseResult.add_instance_attribute('x', 'double')
@@ -420,6 +698,9 @@ if __name__ == '__main__':
 
   pg = Module('_pg', cpp_namespace='::pg')
   pg.add_include('<PostureGenerator.h>')
+  pg.add_include('<IterateFile.h>')
+  pg.add_include('<ProblemCapture.h>')
+  pg.add_include('<ArrayInterface.h>')
 
   pg.add_include('<sch/S_Object/S_Object.h>')
   pg.add_include('<sch/CD/CD_Pair.h>')
@@ -428,6 +709,10 @@ if __name__ == '__main__':
                                message_rvalue='%(EXC)s.what()')
   out_ex = pg.add_exception('std::out_of_range', foreign_cpp_namespace=' ',
                                message_rvalue='%(EXC)s.what()')
+  run_ex = pg.add_exception('std::runtime_error', foreign_cpp_namespace=' ',
+                               message_rvalue='%(EXC)s.what()')
+  log_ex = pg.add_exception('std::logic_error', foreign_cpp_namespace=' ',
+                               message_rvalue='%(EXC)s.what()')
 
   # import Eigen3, sva and rbd types
   import_eigen3_types(pg)
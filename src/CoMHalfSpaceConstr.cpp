@@ -22,7 +22,6 @@
 
 // PG
 #include "PGData.h"
-#include "FillSparse.h"
 
 
 namespace pg
@@ -44,8 +43,12 @@ CoMHalfSpaceConstr::CoMHalfSpaceConstr(PGData* pgdata,
   , n_(std::move(n))
   , jac_(pgdata->mb())
   , eqJac_(O_.size(), pgdata->mb().nrDof())
+  , pattern_(int(O_.size()), pgdata->pbSize())
+  , block_(pattern_.addDense(int(O_.size()), pgdata->mb().nrDof(),
+                             {0, pgdata->qParamsBegin()}))
 {
   assert(O_.size() == n_.size());
+  pattern_.finalize();
 }
 
 
@@ -70,16 +73,16 @@ void CoMHalfSpaceConstr::impl_compute(result_t& res, const argument_t& x) const
 void CoMHalfSpaceConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
   pgdata_->x(x);
-  jac.reserve(int(O_.size())*pgdata_->mb().nrDof());
 
   const Eigen::MatrixXd& jacMat = jac_.jacobian(pgdata_->multibody(),
     pgdata_->mbc());
 
   for(std::size_t i = 0; i < O_.size(); i++)
   {
-    eqJac_.row(i) = n_[i].transpose()*jacMat;
+    eqJac_.row(i).noalias() = n_[i].transpose()*jacMat;
   }
-  fillSparse(eqJac_, jac, {0, pgdata_->qParamsBegin()});
+  pattern_.set(block_, eqJac_);
+  pattern_.copyTo(jac);
 }
 
 
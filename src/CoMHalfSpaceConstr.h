@@ -22,6 +22,9 @@
 // RBDyn
 #include <RBDyn/CoM.h>
 
+// PG
+#include "FillSparse.h"
+
 
 namespace pg
 {
@@ -55,6 +58,8 @@ private:
   std::vector<Eigen::Vector3d> n_;
   mutable rbd::CoMJacobian jac_;
   mutable Eigen::MatrixXd eqJac_;
+  mutable SparsePattern pattern_;
+  int block_;
 };
 
 } // namespace pg
@@ -23,7 +23,6 @@
 // PG
 #include "ConfigStruct.h"
 #include "PGData.h"
-#include "FillSparse.h"
 
 namespace pg
 {
@@ -84,22 +83,24 @@ closestPoints(sch::CD_Pair* pair)
 EnvCollisionConstr::EnvCollisionConstr(PGData* pgdata, const std::vector<EnvCollision>& cols)
   : roboptim::DifferentiableSparseFunction(pgdata->pbSize(), int(cols.size()), "EnvCollision")
   , pgdata_(pgdata)
-  , nrNonZero_(0)
   , xStamp_(0)
+  , pattern_(int(cols.size()), pgdata->pbSize())
 {
   cols_.reserve(cols.size());
   for(const EnvCollision& sc: cols)
   {
     rbd::Jacobian jac(pgdata_->mb(), sc.bodyId);
     Eigen::MatrixXd jacMat(1, jac.dof());
+    int block = pattern_.addJacobian(pgdata_->mb(), jac, 1,
+                                     {int(cols_.size()), pgdata_->qParamsBegin()});
     sch::CD_Pair* sch_pair = new sch::CD_Pair(sc.bodyHull, sc.envHull);
     sch_pair->setEpsilon(std::numeric_limits<double>::epsilon());
     sch_pair->setRelativePrecision(SCH_REL_PREC);
     cols_.push_back({pgdata_->multibody().bodyIndexById(sc.bodyId),
                      sc.bodyT, sch_pair,
-                     jac, jacMat, 0., Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero()});
-    nrNonZero_ += jac.dof();
+                     jac, jacMat, block, 0., Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero()});
   }
+  pattern_.finalize();
 }
 
 
@@ -136,9 +137,6 @@ void EnvCollisionConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) con
     updateCollisionData();
   }
 
-  jac.reserve(nrNonZero_);
-
-  int i = 0;
   for(CollisionData& cd: cols_)
   {
     sva::PTransformd X_0_b(pgdata_->mbc().bodyPosW[cd.bodyIndex]);
@@ -150,9 +148,9 @@ void EnvCollisionConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) con
     double coef = std::copysign(2., cd.dist);
     const Eigen::MatrixXd& jacMat = cd.jac.jacobian(pgdata_->mb(), pgdata_->mbc());
     cd.jacMat.noalias() = coef*dist3d.transpose()*jacMat.block(3, 0, 3, cd.jac.dof());
-    fullJacobianSparse(pgdata_->mb(), cd.jac, cd.jacMat, jac, {i, pgdata_->qParamsBegin()});
-    ++i;
+    pattern_.set(cd.block, cd.jacMat);
   }
+  pattern_.copyTo(jac);
 }
 
 
@@ -176,37 +174,32 @@ void EnvCollisionConstr::updateCollisionData() const
 SelfCollisionConstr::SelfCollisionConstr(PGData* pgdata, const std::vector<SelfCollision>& cols)
   : roboptim::DifferentiableSparseFunction(pgdata->pbSize(), int(cols.size()), "EnvCollision")
   , pgdata_(pgdata)
-  , nrNonZero_(0)
   , xStamp_(0)
+  , pattern_(int(cols.size()), pgdata->pbSize())
 {
   cols_.reserve(cols.size());
   for(const SelfCollision& sc: cols)
   {
+    int row = int(cols_.size());
     rbd::Jacobian jac1(pgdata_->mb(), sc.body1Id);
     Eigen::MatrixXd jac1Mat(1, jac1.dof());
-    Eigen::SparseMatrix<double, Eigen::RowMajor> jac1MatFull(outputSize(),
-                                                             pgdata_->pbSize());
-
-    jac1MatFull.reserve(jac1.dof());
+    int block1 = pattern_.addJacobian(pgdata_->mb(), jac1, 1, {row, pgdata_->qParamsBegin()});
 
     rbd::Jacobian jac2(pgdata_->mb(), sc.body2Id);
     Eigen::MatrixXd jac2Mat(1, jac2.dof());
-    Eigen::SparseMatrix<double, Eigen::RowMajor> jac2MatFull(outputSize(),
-                                                             pgdata_->pbSize());
-    jac2MatFull.reserve(jac2.dof());
+    int block2 = pattern_.addJacobian(pgdata_->mb(), jac2, 1, {row, pgdata_->qParamsBegin()});
 
     sch::CD_Pair* sch_pair = new sch::CD_Pair(sc.body1Hull, sc.body2Hull);
     sch_pair->setEpsilon(std::numeric_limits<double>::epsilon());
     sch_pair->setRelativePrecision(SCH_REL_PREC);
     cols_.push_back({pgdata_->multibody().bodyIndexById(sc.body1Id),
-                     sc.body1T, jac1, jac1Mat, jac1MatFull,
+                     sc.body1T, jac1, jac1Mat, block1,
                      pgdata_->multibody().bodyIndexById(sc.body2Id),
-                     sc.body2T, jac2, jac2Mat, jac2MatFull,
+                     sc.body2T, jac2, jac2Mat, block2,
                      sch_pair,
                      0., Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero()});
-    // not true, but better to ask bigger
-    nrNonZero_ += jac1.dof() + jac2.dof();
   }
+  pattern_.finalize();
 }
 
 
@@ -242,9 +235,8 @@ void SelfCollisionConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) co
   {
     updateCollisionData();
   }
-  jac.reserve(nrNonZero_);
 
-  int i = 0;
+  pattern_.setZero();
   for(CollisionData& cd: cols_)
   {
     sva::PTransformd X_0_b1(pgdata_->mbc().bodyPosW[cd.body1Index]);
@@ -264,11 +256,10 @@ void SelfCollisionConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) co
     cd.jac1Mat.noalias() = coef*dist3d.transpose()*jac1Mat.block(3, 0, 3, cd.jac1.dof());
     cd.jac2Mat.noalias() = coef*dist3d.transpose()*jac2Mat.block(3, 0, 3, cd.jac2.dof());
 
-    updateFullJacobianSparse(pgdata_->mb(), cd.jac1, cd.jac1Mat, cd.jac1MatFull, {i, pgdata_->qParamsBegin()});
-    updateFullJacobianSparse(pgdata_->mb(), cd.jac2, cd.jac2Mat, cd.jac2MatFull, {i, pgdata_->qParamsBegin()});
-    jac += cd.jac1MatFull - cd.jac2MatFull;
-    ++i;
+    pattern_.add(cd.block1, cd.jac1Mat);
+    pattern_.add(cd.block2, -cd.jac2Mat);
   }
+  pattern_.copyTo(jac);
 }
 
 
@@ -28,6 +28,9 @@
 // sch
 #include <sch/Matrix/SCH_Types.h>
 
+// PG
+#include "FillSparse.h"
+
 
 // forward declaration
 namespace sch
@@ -63,6 +66,9 @@ public:
     throw std::runtime_error("NEVER GO HERE");
   }
 
+  /// Compute the closest points for the current PGData state.
+  void updateCollisionData() const;
+
 private:
   struct CollisionData
   {
@@ -71,18 +77,16 @@ private:
     sch::CD_Pair* pair;
     rbd::Jacobian jac;
     Eigen::MatrixXd jacMat;
+    int block;
     double dist;
     Eigen::Vector3d T_0_p, T_0_e;
   };
 
-private:
-  void updateCollisionData() const;
-
 private:
   PGData* pgdata_;
-  int nrNonZero_;
   mutable std::vector<CollisionData> cols_;
   mutable std::size_t xStamp_;
+  mutable SparsePattern pattern_;
 };
 
 
@@ -104,6 +108,9 @@ public:
     throw std::runtime_error("NEVER GO HERE");
   }
 
+  /// Compute the closest points for the current PGData state.
+  void updateCollisionData() const;
+
 private:
   struct CollisionData
   {
@@ -111,25 +118,23 @@ private:
     sva::PTransformd body1T;
     rbd::Jacobian jac1;
     Eigen::MatrixXd jac1Mat;
-    Eigen::SparseMatrix<double, Eigen::RowMajor> jac1MatFull;
+    int block1;
     int body2Index;
     sva::PTransformd body2T;
     rbd::Jacobian jac2;
     Eigen::MatrixXd jac2Mat;
-    Eigen::SparseMatrix<double, Eigen::RowMajor> jac2MatFull;
+    int block2;
     sch::CD_Pair* pair;
     double dist;
     Eigen::Vector3d T_0_p1, T_0_p2;
   };
 
-private:
-  void updateCollisionData() const;
-
 private:
   PGData* pgdata_;
-  int nrNonZero_;
   mutable std::vector<CollisionData> cols_;
   mutable std::size_t xStamp_;
+  /// The two bodies blocks of a collision can overlap.
+  mutable SparsePattern pattern_;
 };
 
 } // namespace pg
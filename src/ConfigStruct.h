@@ -17,6 +17,7 @@
 
 // include
 // std
+#include <string>
 #include <vector>
 
 // boost
@@ -463,6 +464,7 @@ struct RunConfig
   std::vector<std::vector<double>> initQ;
   std::vector<sva::ForceVecd> initForces;
   std::vector<std::vector<double>> targetQ;
+  std::vector<int> lockedJoints; ///< Id of the joints locked at their initQ value.
 };
 
 
@@ -471,4 +473,58 @@ struct IterateQuantities
   double obj, constr_viol;
 };
 
+
+/// Iterate recorded by a solver.
+struct IterateData
+{
+  Eigen::VectorXd x;
+  double obj, constr_viol;
+};
+
+
+/// Choose how the iterates of a run are recorded.
+struct IterateRecording
+{
+  enum Mode
+  {
+    /// Keep every iterate.
+    All,
+    /// Keep nothing.
+    Off,
+    /// Keep the objective and constraint violation of every iterate.
+    Quantities,
+    /// Keep the ringSize last iterates.
+    Ring,
+    /// Write every iterate in file (see IterateFile.h).
+    File
+  };
+
+  IterateRecording()
+    : mode(All)
+    , ringSize(10)
+    , file()
+  {}
+  IterateRecording(Mode m, int rSize=10, std::string f=std::string())
+    : mode(m)
+    , ringSize(rSize)
+    , file(std::move(f))
+  {}
+
+  Mode mode;
+  int ringSize;
+  std::string file;
+};
+
+
+/// Results of PostureGenerator::runBatch.
+struct BatchResult
+{
+  /// Solution of query i in column i, NaN if the query has no result.
+  Eigen::MatrixXd x;
+  /// Run result of each query (1 if successful).
+  std::vector<int> success;
+  /// Solver iterations of each query.
+  std::vector<int> nrIters;
+};
+
 } // namespace pg
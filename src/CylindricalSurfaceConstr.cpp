@@ -19,7 +19,6 @@
 // include
 // PG
 #include "PGData.h"
-#include "FillSparse.h"
 
 
 namespace pg
@@ -42,7 +41,11 @@ CylindricalPositionConstr::CylindricalPositionConstr(
   , surfaceFrame_(surfaceFrame)
   , jac_(pgdata->mb(), bodyId, surfaceFrame.translation())
   , jacMat_(3, jac_.dof())
-{}
+  , pattern_(3, pgdata->pbSize())
+  , block_(pattern_.addJacobian(pgdata->mb(), jac_, 3, {0, pgdata->qParamsBegin()}))
+{
+  pattern_.finalize();
+}
 
 
 CylindricalPositionConstr::~CylindricalPositionConstr()
@@ -64,8 +67,6 @@ void CylindricalPositionConstr::impl_compute(result_t& res, const argument_t& x)
 
 void CylindricalPositionConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
-  jac.reserve(3*jac_.dof());
-
   pgdata_->x(x);
 
   const Eigen::MatrixXd& jacMat = jac_.jacobian(pgdata_->mb(), pgdata_->mbc());
@@ -73,8 +74,8 @@ void CylindricalPositionConstr::impl_jacobian(jacobian_t& jac, const argument_t&
   jacMat_.row(0).noalias() = targetFrame_.rotation().row(0)*jacMat.block(3, 0, 3, jac_.dof());
   jacMat_.row(1).noalias() = targetFrame_.rotation().row(1)*jacMat.block(3, 0, 3, jac_.dof());
   jacMat_.row(2).noalias() = targetFrame_.rotation().row(2)*jacMat.block(3, 0, 3, jac_.dof());
-  fullJacobianSparse(pgdata_->mb(), jac_, jacMat_,
-                     jac, {0, pgdata_->qParamsBegin()});
+  pattern_.set(block_, jacMat_);
+  pattern_.copyTo(jac);
 }
 
 
@@ -94,7 +95,11 @@ CylindricalNVecConstr::CylindricalNVecConstr(
   , surfaceFrame_(surfaceFrame)
   , jac_(pgdata->mb(), bodyId)
   , jacMat_(1, jac_.dof())
-{}
+  , pattern_(1, pgdata->pbSize())
+  , block_(pattern_.addJacobian(pgdata->mb(), jac_, 1, {0, pgdata->qParamsBegin()}))
+{
+  pattern_.finalize();
+}
 
 
 CylindricalNVecConstr::~CylindricalNVecConstr()
@@ -115,8 +120,6 @@ void CylindricalNVecConstr::impl_compute(result_t& res, const argument_t& x) con
 
 void CylindricalNVecConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
-  jac.reserve(jac_.dof());
-
   pgdata_->x(x);
 
   sva::PTransformd pos = surfaceFrame_*pgdata_->mbc().bodyPosW[bodyIndex_];
@@ -138,8 +141,8 @@ void CylindricalNVecConstr::impl_jacobian(jacobian_t& jac, const argument_t& x)
   jacMat_.row(0).noalias() -= vecNDot*pos.rotation().row(2)*jacMat.block(3, 0, 3, jac_.dof());
   jacMat_.row(0).noalias() += (2.*vec.transpose())*jacMat.block(3, 0, 3, jac_.dof());
 
-  fullJacobianSparse(pgdata_->mb(), jac_, jacMat_,
-                     jac, {0, pgdata_->qParamsBegin()});
+  pattern_.set(block_, jacMat_);
+  pattern_.copyTo(jac);
 }
 
 
@@ -22,6 +22,9 @@
 // RBDyn
 #include <RBDyn/Jacobian.h>
 
+// PG
+#include "FillSparse.h"
+
 namespace pg
 {
 class PGData;
@@ -55,6 +58,8 @@ private:
   sva::PTransformd surfaceFrame_;
   mutable rbd::Jacobian jac_;
   mutable Eigen::MatrixXd jacMat_;
+  mutable SparsePattern pattern_;
+  int block_;
 };
 
 
@@ -87,6 +92,8 @@ private:
   sva::PTransformd surfaceFrame_;
   mutable rbd::Jacobian jac_;
   mutable Eigen::MatrixXd jacMat_;
+  mutable SparsePattern pattern_;
+  int block_;
 };
 
 
@@ -0,0 +1,200 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "EquilibriumForces.h"
+
+// include
+// std
+#include <algorithm>
+
+// Eigen
+#include <Eigen/QR>
+
+// SpaceVecAlg
+#include <SpaceVecAlg/SpaceVecAlg>
+
+// RBDyn
+#include <RBDyn/CoM.h>
+
+// PG
+#include "PGData.h"
+
+
+namespace pg
+{
+
+
+Eigen::VectorXd nonNegativeLeastSquares(const Eigen::MatrixXd& A,
+                                        const Eigen::VectorXd& b,
+                                        int maxIter)
+{
+  const int n = int(A.cols());
+  const double tol = 1e-10*std::max(1., A.cwiseAbs().maxCoeff());
+
+  Eigen::VectorXd x(Eigen::VectorXd::Zero(n));
+  Eigen::VectorXd s(n);
+  std::vector<bool> passive(n, false), skip(n, false);
+  std::vector<int> passiveIndex;
+  Eigen::MatrixXd AP(A.rows(), n);
+
+  // solve the unconstrained least square on the passive set into s
+  auto solvePassive = [&]()
+  {
+    for(std::size_t i = 0; i < passiveIndex.size(); ++i)
+    {
+      AP.col(i) = A.col(passiveIndex[i]);
+    }
+    Eigen::VectorXd sP =
+      AP.leftCols(passiveIndex.size()).colPivHouseholderQr().solve(b);
+    s.setZero();
+    for(std::size_t i = 0; i < passiveIndex.size(); ++i)
+    {
+      s(passiveIndex[i]) = sP(i);
+    }
+  };
+
+  for(int iter = 0; iter < maxIter; ++iter)
+  {
+    Eigen::VectorXd w(A.transpose()*(b - A*x));
+
+    // most violated active constraint
+    int j = -1;
+    double wMax = tol;
+    for(int i = 0; i < n; ++i)
+    {
+      if(!passive[i] && !skip[i] && w(i) > wMax)
+      {
+        wMax = w(i);
+        j = i;
+      }
+    }
+    if(j == -1)
+    {
+      break;
+    }
+
+    passive[j] = true;
+    passiveIndex.push_back(j);
+
+    // numerical failure, the new variable can't increase
+    solvePassive();
+    if(s(j) <= tol)
+    {
+      passive[j] = false;
+      passiveIndex.pop_back();
+      skip[j] = true;
+      continue;
+    }
+    std::fill(skip.begin(), skip.end(), false);
+
+    for(int inner = 0; inner < maxIter; ++inner)
+    {
+      if(inner > 0)
+      {
+        solvePassive();
+      }
+
+      double alpha = 1.;
+      for(int i: passiveIndex)
+      {
+        if(s(i) <= tol && x(i) > s(i))
+        {
+          alpha = std::min(alpha, x(i)/(x(i) - s(i)));
+        }
+      }
+      if(alpha >= 1.)
+      {
+        x = s;
+        break;
+      }
+
+      // move back to the active set the variables that reached 0
+      x += alpha*(s - x);
+      std::vector<int> newPassive;
+      for(int i: passiveIndex)
+      {
+        if(x(i) <= tol)
+        {
+          x(i) = 0.;
+          passive[i] = false;
+        }
+        else
+        {
+          newPassive.push_back(i);
+        }
+      }
+      passiveIndex = std::move(newPassive);
+    }
+  }
+
+  return x;
+}
+
+
+std::vector<Eigen::Vector3d> equilibriumForces(const PGData& pgdata)
+{
+  // weight of the equilibrium against the forces norm minimization
+  const double equilibriumWeight = 1e3;
+
+  const int nrForcePoints = pgdata.nrForcePoints();
+  const int nrVar = 4*nrForcePoints;
+  Eigen::Vector3d com = rbd::computeCoM(pgdata.mb(), pgdata.mbc());
+
+  // rows: couple (3), force (3), forces norm (3 by force point)
+  Eigen::MatrixXd A(Eigen::MatrixXd::Zero(6 + 3*nrForcePoints, nrVar));
+  Eigen::VectorXd b(Eigen::VectorXd::Zero(A.rows()));
+  b.segment<3>(3) = equilibriumWeight*pgdata.robotMass()*pgdata.gravity();
+
+  // friction cone edges of each force point
+  Eigen::MatrixXd generators(3, nrVar);
+  int index = 0;
+  for(const PGData::ForceData& fd: pgdata.forceDatas())
+  {
+    const sva::PTransformd& X_0_b = pgdata.mbc().bodyPosW[fd.bodyIndex];
+    for(std::size_t i = 0; i < fd.points.size(); ++i)
+    {
+      sva::PTransformd X_0_pi = fd.points[i]*X_0_b;
+      Eigen::Vector3d t(X_0_pi.rotation().row(0).transpose());
+      Eigen::Vector3d bi(X_0_pi.rotation().row(1).transpose());
+      Eigen::Vector3d n(X_0_pi.rotation().row(2).transpose());
+
+      auto G = generators.middleCols<4>(index*4);
+      G.col(0) = n + fd.mu*t;
+      G.col(1) = n - fd.mu*t;
+      G.col(2) = n + fd.mu*bi;
+      G.col(3) = n - fd.mu*bi;
+
+      Eigen::Vector3d T_com_fi(X_0_pi.translation() - com);
+      A.block<3, 4>(0, index*4) =
+        equilibriumWeight*sva::vector3ToCrossMatrix(T_com_fi)*G;
+      A.block<3, 4>(3, index*4) = equilibriumWeight*G;
+      A.block<3, 4>(6 + index*3, index*4) = G;
+      ++index;
+    }
+  }
+
+  Eigen::VectorXd lambda(nonNegativeLeastSquares(A, b));
+
+  std::vector<Eigen::Vector3d> forces(nrForcePoints);
+  for(int i = 0; i < nrForcePoints; ++i)
+  {
+    forces[i] = generators.middleCols<4>(i*4)*lambda.segment<4>(i*4);
+  }
+  return forces;
+}
+
+
+} // pg
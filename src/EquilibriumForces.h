@@ -0,0 +1,48 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+
+namespace pg
+{
+class PGData;
+
+/**
+  * Solve min ||A x - b||^2 s.t. x >= 0 with the Lawson-Hanson active set method.
+  */
+Eigen::VectorXd nonNegativeLeastSquares(const Eigen::MatrixXd& A,
+                                        const Eigen::VectorXd& b,
+                                        int maxIter=200);
+
+
+/**
+  * Compute contact forces that balance the robot gravity in the current
+  * pgdata configuration.
+  * Each force is a positive combination of the 4 edges of its linearized
+  * friction cone (n +- mu t, n +- mu b in the force point frame).
+  * The equilibrium residual is minimized first, then the forces norm.
+  * @return World frame force of each pgdata force point.
+  */
+std::vector<Eigen::Vector3d> equilibriumForces(const PGData& pgdata);
+
+} // namespace pg
@@ -17,6 +17,9 @@
 #include "FillSparse.h"
 
 // includes
+// std
+#include <cassert>
+
 // RBDyn
 #include <RBDyn/MultiBody.h>
 #include <RBDyn/Jacobian.h>
@@ -93,4 +96,134 @@ void incrementFullJacobianSparse(const rbd::MultiBody& mb, const rbd::Jacobian&
 }
 
 
+/*
+ *                          SparsePattern
+ */
+
+
+SparsePattern::SparsePattern()
+  : mat_()
+  , blocks_()
+{}
+
+
+SparsePattern::SparsePattern(int rows, int cols)
+  : mat_(rows, cols)
+  , blocks_()
+{}
+
+
+int SparsePattern::addJacobian(const rbd::MultiBody& mb, const rbd::Jacobian& jac,
+  int rows, const jac_offset_t& offset)
+{
+  Block b;
+  b.rowBegin = offset.first;
+  b.rows = rows;
+  b.cols.reserve(jac.dof());
+  for(int i: jac.jointsPath())
+  {
+    int posInDof = mb.jointPosInDof(i);
+    for(int dof = 0; dof < mb.joint(i).dof(); ++dof)
+    {
+      b.cols.push_back(posInDof + dof + offset.second);
+    }
+  }
+
+  blocks_.push_back(std::move(b));
+  return int(blocks_.size()) - 1;
+}
+
+
+int SparsePattern::addDense(int rows, int cols, const jac_offset_t& offset)
+{
+  Block b;
+  b.rowBegin = offset.first;
+  b.rows = rows;
+  b.cols.reserve(cols);
+  for(int col = 0; col < cols; ++col)
+  {
+    b.cols.push_back(col + offset.second);
+  }
+
+  blocks_.push_back(std::move(b));
+  return int(blocks_.size()) - 1;
+}
+
+
+void SparsePattern::finalize()
+{
+  std::vector<Eigen::Triplet<double>> triplets;
+  for(const Block& b: blocks_)
+  {
+    for(int row = 0; row < b.rows; ++row)
+    {
+      for(int col: b.cols)
+      {
+        triplets.emplace_back(b.rowBegin + row, col, 0.);
+      }
+    }
+  }
+
+  mat_.setFromTriplets(triplets.begin(), triplets.end());
+  mat_.makeCompressed();
+
+  const int* outer = mat_.outerIndexPtr();
+  const int* inner = mat_.innerIndexPtr();
+  for(Block& b: blocks_)
+  {
+    b.valueIndex.clear();
+    b.valueIndex.reserve(b.rows*b.cols.size());
+    for(int row = b.rowBegin; row < b.rowBegin + b.rows; ++row)
+    {
+      for(int col: b.cols)
+      {
+        const int* it = std::lower_bound(inner + outer[row], inner + outer[row + 1], col);
+        b.valueIndex.push_back(int(it - inner));
+      }
+    }
+  }
+}
+
+
+void SparsePattern::copyTo(matrix_t& res) const
+{
+  int nnz = int(mat_.nonZeros());
+  if(res.isCompressed() && res.nonZeros() == nnz &&
+     res.rows() == mat_.rows() && res.cols() == mat_.cols() &&
+     std::equal(mat_.outerIndexPtr(), mat_.outerIndexPtr() + mat_.rows() + 1,
+                res.outerIndexPtr()) &&
+     std::equal(mat_.innerIndexPtr(), mat_.innerIndexPtr() + nnz,
+                res.innerIndexPtr()))
+  {
+    std::copy(mat_.valuePtr(), mat_.valuePtr() + nnz, res.valuePtr());
+  }
+  else
+  {
+    res = mat_;
+  }
+}
+
+
+void SparsePattern::copyTo(Eigen::SparseVector<double>& res) const
+{
+  assert(mat_.rows() == 1);
+  int nnz = int(mat_.nonZeros());
+  if(res.size() == mat_.cols() && res.nonZeros() == nnz &&
+     std::equal(mat_.innerIndexPtr(), mat_.innerIndexPtr() + nnz,
+                res.innerIndexPtr()))
+  {
+    std::copy(mat_.valuePtr(), mat_.valuePtr() + nnz, res.valuePtr());
+  }
+  else
+  {
+    res.resize(mat_.cols());
+    res.reserve(nnz);
+    for(int i = 0; i < nnz; ++i)
+    {
+      res.insertBack(mat_.innerIndexPtr()[i]) = mat_.valuePtr()[i];
+    }
+  }
+}
+
+
 } // pg
@@ -17,6 +17,7 @@
 
 // includes
 // std
+#include <algorithm>
 #include <vector>
 
 // Eigen
@@ -53,6 +54,105 @@ void incrementFullJacobianSparse(const rbd::MultiBody& mb, const rbd::Jacobian&
   const jac_offset_t& offset=jac_offset_t(0, 0));
 
 
+/**
+  * Sparse matrix with a structure fixed at construction.
+  * Blocks (robot Jacobians or dense blocks) are registered once, then
+  * finalize build the matrix and the index of each block coefficient in the
+  * value array. Jacobian evaluation can then write the values directly
+  * instead of searching (and maybe inserting) each coefficient.
+  * Blocks can overlap, add accumulate into the coefficients.
+  */
+class SparsePattern
+{
+public:
+  typedef Eigen::SparseMatrix<double, Eigen::RowMajor> matrix_t;
+
+public:
+  SparsePattern();
+  SparsePattern(int rows, int cols);
+
+  /// Register a rows x jac.dof() block, jacobian columns are mapped
+  /// like in fullJacobianSparse.
+  /// @return block index.
+  int addJacobian(const rbd::MultiBody& mb, const rbd::Jacobian& jac, int rows,
+    const jac_offset_t& offset=jac_offset_t(0, 0));
+  /// Register a dense rows x cols block.
+  /// @return block index.
+  int addDense(int rows, int cols,
+    const jac_offset_t& offset=jac_offset_t(0, 0));
+
+  /// Build the matrix structure, must be called after the last add*.
+  void finalize();
+
+  int nonZeros() const
+  {
+    return int(mat_.nonZeros());
+  }
+
+  void setZero()
+  {
+    std::fill(mat_.valuePtr(), mat_.valuePtr() + mat_.nonZeros(), 0.);
+  }
+
+  /// Add mat to the block coefficients.
+  template <typename Derived>
+  void add(int block, const Eigen::MatrixBase<Derived>& mat)
+  {
+    const Block& b = blocks_[block];
+    double* values = mat_.valuePtr();
+    const int* index = b.valueIndex.data();
+    for(int row = 0; row < b.rows; ++row)
+    {
+      for(int col = 0; col < int(b.cols.size()); ++col)
+      {
+        values[*index++] += mat(row, col);
+      }
+    }
+  }
+
+  /// Set the block coefficients to mat.
+  /// Only valid if no other block overlap this one.
+  template <typename Derived>
+  void set(int block, const Eigen::MatrixBase<Derived>& mat)
+  {
+    const Block& b = blocks_[block];
+    double* values = mat_.valuePtr();
+    const int* index = b.valueIndex.data();
+    for(int row = 0; row < b.rows; ++row)
+    {
+      for(int col = 0; col < int(b.cols.size()); ++col)
+      {
+        values[*index++] = mat(row, col);
+      }
+    }
+  }
+
+  const matrix_t& matrix() const
+  {
+    return mat_;
+  }
+
+  /// Copy the matrix into res. Only the values are copied when res already
+  /// has the same structure.
+  void copyTo(matrix_t& res) const;
+  /// Copy the row of a one row matrix into res (a gradient).
+  /// Only the values are copied when res already has the same structure.
+  void copyTo(Eigen::SparseVector<double>& res) const;
+
+private:
+  struct Block
+  {
+    int rowBegin, rows;
+    std::vector<int> cols;
+    std::vector<int> valueIndex;
+  };
+
+private:
+  matrix_t mat_;
+  std::vector<Block> blocks_;
+};
+
+
 template <typename Derived>
 void fillSparse(const Eigen::MatrixBase<Derived>& mat,
   Eigen::SparseMatrix<double, Eigen::RowMajor>& res,
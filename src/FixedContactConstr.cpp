@@ -19,7 +19,6 @@
 // include
 // PG
 #include "PGData.h"
-#include "FillSparse.h"
 
 namespace pg
 {
@@ -39,13 +38,23 @@ FixedPositionContactConstr::FixedPositionContactConstr(PGData* pgdata, int bodyI
   , target_(target)
   , surfaceFrame_(surfaceFrame)
   , jac_(pgdata->multibody(), bodyId, surfaceFrame.translation())
-{}
+  , pattern_(3, pgdata->pbSize())
+  , block_(pattern_.addJacobian(pgdata->mb(), jac_, 3, {0, pgdata->qParamsBegin()}))
+{
+  pattern_.finalize();
+}
 
 
 FixedPositionContactConstr::~FixedPositionContactConstr()
 { }
 
 
+void FixedPositionContactConstr::target(const Eigen::Vector3d& target)
+{
+  target_ = target;
+}
+
+
 void FixedPositionContactConstr::impl_compute(result_t& res, const argument_t& x) const
 {
   pgdata_->x(x);
@@ -57,10 +66,9 @@ void FixedPositionContactConstr::impl_compute(result_t& res, const argument_t& x
 void FixedPositionContactConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
   pgdata_->x(x);
-  jac.reserve(3*jac_.dof());
   const Eigen::MatrixXd& jacMat = jac_.jacobian(pgdata_->multibody(), pgdata_->mbc());
-  fullJacobianSparse(pgdata_->mb(), jac_, jacMat.block(3, 0, 3, jacMat.cols()),
-                     jac, {0, pgdata_->qParamsBegin()});
+  pattern_.set(block_, jacMat.bottomRows<3>());
+  pattern_.copyTo(jac);
 }
 
 
@@ -79,13 +87,23 @@ FixedOrientationContactConstr::FixedOrientationContactConstr(PGData* pgdata, int
   , surfaceFrame_(surfaceFrame)
   , jac_(pgdata->multibody(), bodyId)
   , dotCacheSum_(3, jac_.dof())
-{}
+  , pattern_(3, pgdata->pbSize())
+  , block_(pattern_.addJacobian(pgdata->mb(), jac_, 3, {0, pgdata->qParamsBegin()}))
+{
+  pattern_.finalize();
+}
 
 
 FixedOrientationContactConstr::~FixedOrientationContactConstr()
 { }
 
 
+void FixedOrientationContactConstr::target(const Eigen::Matrix3d& target)
+{
+  target_ = target;
+}
+
+
 void FixedOrientationContactConstr::impl_compute(result_t& res, const argument_t& x) const
 {
   pgdata_->x(x);
@@ -112,13 +130,13 @@ void FixedOrientationContactConstr::dotDerivative(
 void FixedOrientationContactConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
   pgdata_->x(x);
-  jac.reserve(3*jac_.dof());
 
   dotDerivative(surfaceFrame_.rotation().row(0), target_.row(0), dotCacheSum_.row(0));
   dotDerivative(surfaceFrame_.rotation().row(1), target_.row(1), dotCacheSum_.row(1));
   dotDerivative(surfaceFrame_.rotation().row(2), target_.row(2), dotCacheSum_.row(2));
 
-  fullJacobianSparse(pgdata_->mb(), jac_, dotCacheSum_, jac, {0, pgdata_->qParamsBegin()});
+  pattern_.set(block_, dotCacheSum_);
+  pattern_.copyTo(jac);
 }
 
 
@@ -22,6 +22,9 @@
 // RBDyn
 #include <RBDyn/Jacobian.h>
 
+// PG
+#include "FillSparse.h"
+
 namespace pg
 {
 class PGData;
@@ -37,6 +40,8 @@ public:
       const sva::PTransformd& surfaceFrame);
   ~FixedPositionContactConstr();
 
+  void target(const Eigen::Vector3d& target);
+
 
   void impl_compute(result_t& res, const argument_t& x) const;
   void impl_jacobian(jacobian_t& jac, const argument_t& x) const;
@@ -53,6 +58,8 @@ private:
   Eigen::Vector3d target_;
   sva::PTransformd surfaceFrame_;
   mutable rbd::Jacobian jac_;
+  mutable SparsePattern pattern_;
+  int block_;
 };
 
 
@@ -69,6 +76,8 @@ public:
       const sva::PTransformd& surfaceFrame);
   ~FixedOrientationContactConstr();
 
+  void target(const Eigen::Matrix3d& target);
+
 
   void impl_compute(result_t& res, const argument_t& x) const;
   void impl_jacobian(jacobian_t& jac, const argument_t& x) const;
@@ -93,6 +102,8 @@ private:
 
   mutable rbd::Jacobian jac_;
   mutable Eigen::MatrixXd dotCacheSum_;
+  mutable SparsePattern pattern_;
+  int block_;
 };
 
 } // namespace pg
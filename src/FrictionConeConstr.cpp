@@ -19,7 +19,6 @@
 // PG
 #include "ConfigStruct.h"
 #include "PGData.h"
-#include "FillSparse.h"
 
 namespace pg
 {
@@ -28,9 +27,11 @@ namespace pg
 FrictionConeConstr::FrictionConeConstr(PGData* pgdata)
   : roboptim::DifferentiableSparseFunction(pgdata->pbSize(), pgdata->nrForcePoints(), "FrictionConeConstr")
   , pgdata_(pgdata)
-  , nrNonZero_(0)
   , jacPoints_(pgdata->nrForcePoints())
   , jacPointsMatTmp_(pgdata->nrForcePoints())
+  , pattern_(pgdata->nrForcePoints(), pgdata->pbSize())
+  , jacBlocks_(pgdata->nrForcePoints())
+  , forceBlocks_(pgdata->nrForcePoints())
 {
   std::size_t index = 0;
   for(const PGData::ForceData& fd: pgdata_->forceDatas())
@@ -39,11 +40,14 @@ FrictionConeConstr::FrictionConeConstr(PGData* pgdata)
     {
       jacPoints_[index] = rbd::Jacobian(pgdata_->mb(), fd.bodyId, fd.points[i].translation());
       jacPointsMatTmp_[index].resize(1, jacPoints_[index].dof());
-      // jacobian dof + force vec
-      nrNonZero_ += jacPoints_[index].dof() + 3;
+      jacBlocks_[index] = pattern_.addJacobian(pgdata_->mb(), jacPoints_[index], 1,
+                                               {int(index), pgdata_->qParamsBegin()});
+      forceBlocks_[index] = pattern_.addDense(1, 3,
+        {int(index), pgdata_->forceParamsBegin() + int(index)*3});
       ++index;
     }
   }
+  pattern_.finalize();
 }
 
 
@@ -74,7 +78,6 @@ void FrictionConeConstr::impl_compute(result_t& res, const argument_t& x) const
 void FrictionConeConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
   pgdata_->x(x);
-  jac.reserve(nrNonZero_);
 
   int index = 0;
   for(const PGData::ForceData& fd: pgdata_->forceDatas())
@@ -102,8 +105,8 @@ void FrictionConeConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) con
                                            pgdata_->mbc(),
                                            fd.points[i].rotation().row(2).transpose())\
           .block(3, 0, 3, jacPoints_[index].dof());
-      jacPointsMatTmp_[index].row(0).noalias() =
-          (-2.*muSquare*fBody.z())*(fd.forces[i].force().transpose()*jacPointVecZMat);
+      jacPointsMatTmp_[index].noalias() =
+          ((-2.*muSquare*fBody.z())*fd.forces[i].force().transpose())*jacPointVecZMat;
 
       const auto& jacPointVecXMat =
           jacPoints_[index].vectorJacobian(pgdata_->mb(),
@@ -111,7 +114,7 @@ void FrictionConeConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) con
                                            fd.points[i].rotation().row(0).transpose())\
           .block(3, 0, 3, jacPoints_[index].dof());
       jacPointsMatTmp_[index].noalias() +=
-          (2.*fBody.x())*(fd.forces[i].force().transpose()*jacPointVecXMat);
+          ((2.*fBody.x())*fd.forces[i].force().transpose())*jacPointVecXMat;
 
       const auto& jacPointVecYMat =
           jacPoints_[index].vectorJacobian(pgdata_->mb(),
@@ -119,10 +122,9 @@ void FrictionConeConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) con
                                            fd.points[i].rotation().row(1).transpose())\
           .block(3, 0, 3, jacPoints_[index].dof());
       jacPointsMatTmp_[index].noalias() +=
-          (2.*fBody.y())*(fd.forces[i].force().transpose()*jacPointVecYMat);
+          ((2.*fBody.y())*fd.forces[i].force().transpose())*jacPointVecYMat;
 
-      fullJacobianSparse(pgdata_->mb(), jacPoints_[index], jacPointsMatTmp_[index],
-        jac, {index, pgdata_->qParamsBegin()});
+      pattern_.set(jacBlocks_[index], jacPointsMatTmp_[index]);
 
       // Z axis
       //                dforceW
@@ -138,14 +140,12 @@ void FrictionConeConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) con
       Eigen::RowVector3d fDiff = (-2.*muSquare*fBody.z())*X_0_pi.rotation().row(2);
       fDiff.noalias() += (2.*fBody.x())*X_0_pi.rotation().row(0);
       fDiff.noalias() += (2.*fBody.y())*X_0_pi.rotation().row(1);
-      int indexCols = pgdata_->forceParamsBegin() + index*3;
-      jac.insert(index, indexCols + 0) = fDiff(0);
-      jac.insert(index, indexCols + 1) = fDiff(1);
-      jac.insert(index, indexCols + 2) = fDiff(2);
+      pattern_.set(forceBlocks_[index], fDiff);
 
       ++index;
     }
   }
+  pattern_.copyTo(jac);
 }
 
 
@@ -25,6 +25,9 @@
 // RBDyn
 #include <RBDyn/Jacobian.h>
 
+// PG
+#include "FillSparse.h"
+
 
 namespace pg
 {
@@ -50,10 +53,12 @@ public:
 
 private:
   PGData* pgdata_;
-  int nrNonZero_;
 
   mutable std::vector<rbd::Jacobian> jacPoints_;
   mutable std::vector<Eigen::MatrixXd> jacPointsMatTmp_;
+  mutable SparsePattern pattern_;
+  /// Joints and force blocks of each force point.
+  std::vector<int> jacBlocks_, forceBlocks_;
 };
 
 } // namespace pg
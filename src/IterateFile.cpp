@@ -0,0 +1,99 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "IterateFile.h"
+
+// include
+// std
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace pg
+{
+
+static const char iterateFileMagic[4] = {'P', 'G', 'I', 'T'};
+static const std::uint32_t iterateFileVersion = 1;
+
+
+IterateFileWriter::IterateFileWriter(const std::string& file)
+  : out_(file, std::ios::binary | std::ios::trunc)
+  , xSize_(-1)
+{
+  if(!out_)
+  {
+    throw std::runtime_error("Can't open iterate file " + file);
+  }
+}
+
+
+void IterateFileWriter::write(const IterateData& data)
+{
+  if(xSize_ == -1)
+  {
+    xSize_ = int(data.x.size());
+    std::uint32_t xSize = std::uint32_t(xSize_);
+    out_.write(iterateFileMagic, 4);
+    out_.write(reinterpret_cast<const char*>(&iterateFileVersion), sizeof(std::uint32_t));
+    out_.write(reinterpret_cast<const char*>(&xSize), sizeof(std::uint32_t));
+  }
+  else if(xSize_ != int(data.x.size()))
+  {
+    throw std::runtime_error("Iterate size changed");
+  }
+
+  out_.write(reinterpret_cast<const char*>(&data.obj), sizeof(double));
+  out_.write(reinterpret_cast<const char*>(&data.constr_viol), sizeof(double));
+  out_.write(reinterpret_cast<const char*>(data.x.data()), sizeof(double)*xSize_);
+}
+
+
+std::vector<IterateData> readIterateFile(const std::string& file)
+{
+  std::ifstream in(file, std::ios::binary);
+  std::vector<IterateData> datas;
+
+  char magic[4];
+  std::uint32_t version = 0, xSize = 0;
+  in.read(magic, 4);
+  // empty file: no iterate was written
+  if(in.gcount() == 0)
+  {
+    return datas;
+  }
+  in.read(reinterpret_cast<char*>(&version), sizeof(std::uint32_t));
+  in.read(reinterpret_cast<char*>(&xSize), sizeof(std::uint32_t));
+  if(!in || std::memcmp(magic, iterateFileMagic, 4) != 0 ||
+     version != iterateFileVersion)
+  {
+    throw std::runtime_error(file + " is not an iterate file");
+  }
+
+  IterateData d;
+  d.x.resize(xSize);
+  while(in.read(reinterpret_cast<char*>(&d.obj), sizeof(double)) &&
+        in.read(reinterpret_cast<char*>(&d.constr_viol), sizeof(double)) &&
+        in.read(reinterpret_cast<char*>(d.x.data()), sizeof(double)*xSize))
+  {
+    datas.push_back(d);
+  }
+
+  return datas;
+}
+
+
+} // pg
@@ -0,0 +1,58 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <fstream>
+#include <string>
+#include <vector>
+
+// PG
+#include "ConfigStruct.h"
+
+
+namespace pg
+{
+
+/**
+  * Write iterates in a binary file.
+  * Format (native endianness): "PGIT", uint32 version, uint32 x size,
+  * then for each iterate: double obj, double constr_viol, x size doubles.
+  * The header is written with the first iterate.
+  */
+class IterateFileWriter
+{
+public:
+  /// @throw std::runtime_error if file can't be opened.
+  IterateFileWriter(const std::string& file);
+
+  /// @throw std::runtime_error if x size change.
+  void write(const IterateData& data);
+
+private:
+  std::ofstream out_;
+  int xSize_;
+};
+
+
+/**
+  * Read a file written by IterateFileWriter.
+  * @throw std::runtime_error if the file is not an iterate file.
+  */
+std::vector<IterateData> readIterateFile(const std::string& file);
+
+} // namespace pg
@@ -14,43 +14,333 @@
 
 #pragma once
 
+// include
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// boost
+#include <boost/shared_ptr.hpp>
+#include <boost/variant/get.hpp>
+
+// Eigen
 #include <Eigen/Dense>
 
+// PG
+#include "ConfigStruct.h"
+#include "IterateFile.h"
+#include "Tracer.h"
+
 namespace pg
 {
 
+/// Thrown by IterationCallback when the solving deadline is reached
+/// or the run is cancelled, except in IPOPT callbacks.
+struct DeadlineReached : public std::runtime_error
+{
+  DeadlineReached()
+    : std::runtime_error("Deadline reached")
+  {}
+};
+
+
 template <class problem_t, class solverState_t>
 struct IterationCallback
 {
-  struct Data
+  typedef std::chrono::steady_clock clock;
+  typedef IterateData Data;
+
+  IterationCallback()
+    : recording()
+    , datas()
+    , ringBegin(0)
+    , nrIterations(0)
+    , hasBestFeasible(false)
+    , bestFeasible()
+    , hasLeastViolating(false)
+    , leastViolating()
+    , feasibilityTol(1e-4)
+    , hasDeadline(false)
+    , deadline()
+    , deadlineReached(false)
+    , cancel()
+    , observer()
+    , trace(nullptr)
+    , lastIteration()
+    , writer_()
+    , current_()
+    , modeLookedUp_(false)
+    , modeState_(nullptr)
+    , modeParam_(nullptr)
+  {}
+
+  /// Prepare the recording of a new run.
+  /// @throw std::runtime_error if the recording file can't be opened.
+  void start()
+  {
+    datas.clear();
+    if(recording.mode == IterateRecording::Ring)
+    {
+      datas.reserve(std::max(recording.ringSize, 0));
+    }
+    ringBegin = 0;
+    nrIterations = 0;
+    hasBestFeasible = false;
+    hasLeastViolating = false;
+    writer_.reset();
+    if(recording.mode == IterateRecording::File)
+    {
+      writer_.reset(new IterateFileWriter(recording.file));
+    }
+    modeLookedUp_ = false;
+    modeState_ = nullptr;
+    modeParam_ = nullptr;
+    lastIteration = clock::now();
+  }
+
+  /// Stop the solvers seconds from now, no deadline if seconds <= 0.
+  void startDeadline(double seconds)
+  {
+    hasDeadline = seconds > 0.;
+    deadline = clock::now() +
+      std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(seconds));
+    deadlineReached = false;
+  }
+
+  /// True, and set deadlineReached, when the deadline is passed
+  /// or cancel is set.
+  bool stopRequested()
+  {
+    if((hasDeadline && clock::now() >= deadline) || (cancel && *cancel))
+    {
+      deadlineReached = true;
+    }
+    return deadlineReached;
+  }
+
+  /// Throw DeadlineReached when stopRequested.
+  void checkDeadline()
   {
-    Eigen::VectorXd x;
-    double obj, constr_viol;
-  };
+    if(stopRequested())
+    {
+      throw DeadlineReached();
+    }
+  }
 
-  void operator()(const problem_t& /*problem*/, const solverState_t& state)
+  /// True if recorded iterates must provide x.
+  bool recordX() const
   {
-    Data d;
+    return recording.mode == IterateRecording::All ||
+      recording.mode == IterateRecording::Ring ||
+      recording.mode == IterateRecording::File;
+  }
+
+  /// Record an iterate without checking the deadline.
+  /// x is only copied where it is kept (stored iterates, best iterates,
+  /// file and observer), an empty x is only stored in Quantities mode.
+  void record(const Eigen::VectorXd& x, double obj, double constrViol)
+  {
+    ++nrIterations;
+    track(x, obj, constrViol);
+
+    switch(recording.mode)
+    {
+      case IterateRecording::All:
+        datas.push_back(Data{x, obj, constrViol});
+        break;
+      case IterateRecording::Quantities:
+        datas.push_back(Data{Eigen::VectorXd(), obj, constrViol});
+        break;
+      case IterateRecording::Ring:
+        if(int(datas.size()) < recording.ringSize)
+        {
+          datas.push_back(Data{x, obj, constrViol});
+        }
+        else if(!datas.empty())
+        {
+          // reuse the oldest iterate memory
+          assign(datas[ringBegin], x, obj, constrViol);
+          ringBegin = (ringBegin + 1) % int(datas.size());
+        }
+        break;
+      case IterateRecording::File:
+        assign(current_, x, obj, constrViol);
+        writer_->write(current_);
+        break;
+      case IterateRecording::Off:
+        break;
+    }
+
+    if(observer)
+    {
+      assign(current_, x, obj, constrViol);
+      observer(current_);
+    }
+  }
+
+  void record(const Data& d)
+  {
+    record(d.x, d.obj, d.constr_viol);
+  }
+
+  /// Add a span from the previous iteration to trace.
+  void traceIteration()
+  {
+    if(trace)
+    {
+      clock::time_point now = clock::now();
+      trace->add(Tracer::Iteration, Tracer::Run, lastIteration, now);
+      lastIteration = now;
+    }
+  }
+
+  /// Record an iterate of a solver that don't use operator().
+  void push(const Eigen::VectorXd& x, double obj, double constrViol)
+  {
+    traceIteration();
+    record(x, obj, constrViol);
+    checkDeadline();
+  }
+
+  /// Solver iteration callback.
+  /// IPOPT is stopped by its ipopt.stop state parameter (its intermediate
+  /// callback then return false), other solvers by DeadlineReached.
+  void operator()(const problem_t& /*problem*/, solverState_t& state)
+  {
+    traceIteration();
 
     // we only store iteration data in regular mode
     // because some quantities don't have the same meaning
     // in other mode
-    std::string mode("");
-    try {
-      mode = state.template getParameter<std::string>("ipopt.mode");
+    if(regularMode(state))
+    {
+      record(state.x(), state.cost().get(), state.constraintViolation().get());
     }
-    catch(std::out_of_range & e){ std::cerr << e.what() << std::endl;}
 
-    if(mode == "RegularMode")
+    if(stopRequested())
     {
-      d.x = state.x();
-      d.obj = state.cost().get();
-      d.constr_viol = state.constraintViolation().get();
-      datas.push_back(d);
+      auto it = state.parameters().find("ipopt.stop");
+      if(it == state.parameters().end())
+      {
+        throw DeadlineReached();
+      }
+      it->second.value = true;
     }
   }
 
+  /// Number of stored iterates.
+  int size() const
+  {
+    return int(datas.size());
+  }
+
+  /// i-th stored iterate, from the oldest.
+  /// @throw std::out_of_range if i is not a stored iterate.
+  const Data& at(int i) const
+  {
+    if(i < 0 || i >= size())
+    {
+      throw std::out_of_range("No iterate " + std::to_string(i));
+    }
+    return datas[(ringBegin + i) % datas.size()];
+  }
+
+  IterateRecording recording;
   std::vector<Data> datas;
+  /// Index of the oldest iterate in datas (Ring mode).
+  int ringBegin;
+  /// Number of recorded iterates, stored or not.
+  int nrIterations;
+
+  /// Lowest cost iterate with constr_viol <= feasibilityTol.
+  bool hasBestFeasible;
+  Data bestFeasible;
+  bool hasLeastViolating;
+  Data leastViolating;
+  double feasibilityTol;
+
+  bool hasDeadline;
+  clock::time_point deadline;
+  /// Set when stopRequested has returned true.
+  bool deadlineReached;
+  /// Set from another thread to stop the solver.
+  std::shared_ptr<std::atomic<bool>> cancel;
+  /// Called on each recorded iterate.
+  std::function<void(const Data&)> observer;
+  /// Iterations spans (disabled if null).
+  TraceBuffer* trace;
+  clock::time_point lastIteration;
+
+private:
+  void track(const Eigen::VectorXd& x, double obj, double constrViol)
+  {
+    // iterates without x can't be selected
+    if(x.size() == 0)
+    {
+      return;
+    }
+    if(!hasLeastViolating)
+    {
+      // the first feasible iterate is often found later, its memory is
+      // allocated now to keep the next iterations allocation free
+      bestFeasible.x.resize(x.size());
+    }
+    if(constrViol <= feasibilityTol &&
+       (!hasBestFeasible || obj < bestFeasible.obj))
+    {
+      hasBestFeasible = true;
+      assign(bestFeasible, x, obj, constrViol);
+    }
+    if(!hasLeastViolating || constrViol < leastViolating.constr_viol)
+    {
+      hasLeastViolating = true;
+      assign(leastViolating, x, obj, constrViol);
+    }
+  }
+
+  /// Copy an iterate in d, reusing d.x memory.
+  static void assign(Data& d, const Eigen::VectorXd& x, double obj, double constrViol)
+  {
+    d.x = x;
+    d.obj = obj;
+    d.constr_viol = constrViol;
+  }
+
+  /// The ipopt.mode parameter is looked up once per solver state
+  /// and then only compared.
+  /// Iterates are recorded when the solver don't have this parameter.
+  bool regularMode(const solverState_t& state)
+  {
+    // solvers without ipopt.mode are only looked up once per state
+    if(!modeLookedUp_ || modeState_ != &state)
+    {
+      modeLookedUp_ = true;
+      modeState_ = &state;
+      auto it = state.parameters().find("ipopt.mode");
+      modeParam_ = it == state.parameters().end() ? nullptr : &it->second;
+    }
+    if(!modeParam_)
+    {
+      return true;
+    }
+    const std::string* mode = boost::get<std::string>(&modeParam_->value);
+    return mode && *mode == "RegularMode";
+  }
+
+private:
+  boost::shared_ptr<IterateFileWriter> writer_;
+  /// Last iterate given to the file writer and the observer.
+  Data current_;
+  /// ipopt.mode was looked up in modeState_ parameters.
+  bool modeLookedUp_;
+  const solverState_t* modeState_;
+  const typename solverState_t::parameters_t::mapped_type* modeParam_;
 };
 
 } // namespace pg
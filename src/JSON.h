@@ -0,0 +1,51 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <ostream>
+#include <string>
+
+
+namespace pg
+{
+
+/// Write str as a JSON string, control characters are written as \uXXXX.
+inline void writeJSONString(std::ostream& out, const std::string& str)
+{
+  static const char hex[] = "0123456789abcdef";
+  out << '"';
+  for(char c: str)
+  {
+    unsigned char uc = static_cast<unsigned char>(c);
+    if(c == '"' || c == '\\')
+    {
+      out << '\\' << c;
+    }
+    else if(uc < 0x20)
+    {
+      out << "\\u00" << hex[uc >> 4] << hex[uc & 0xf];
+    }
+    else
+    {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+} // namespace pg
@@ -0,0 +1,197 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "LeastSquaresCostFunc.h"
+
+// include
+// std
+#include <cmath>
+
+// PG
+#include "ConfigStruct.h"
+#include "PGData.h"
+
+
+namespace pg
+{
+
+
+LeastSquaresCostFunc::LeastSquaresCostFunc(std::vector<PGData>& pgdatas,
+    const std::vector<RobotConfig>& robotConfigs,
+    const std::vector<RunConfig>& runConfigs)
+  : roboptim::DifferentiableSparseFunction(pgdatas[0].pbSize(),
+                                           nrResiduals(robotConfigs),
+                                           "LeastSquaresCostFunc")
+  , robotDatas_(pgdatas.size())
+  , pattern_(nrResiduals(robotConfigs), pgdatas[0].pbSize())
+{
+  // same robot average than StdCostFunc
+  double scale = 1./double(robotConfigs.size());
+  int row = 0;
+
+  for(std::size_t robotIndex = 0; robotIndex < pgdatas.size(); ++robotIndex)
+  {
+    const RobotConfig& robotConfig = robotConfigs[robotIndex];
+    const RunConfig& runConfig = runConfigs[robotIndex];
+    PGData& pgdata = pgdatas[robotIndex];
+    RobotData& data = robotDatas_[robotIndex];
+    data.pgdata = &pgdata;
+
+    if(robotConfig.postureScale > 0.)
+    {
+      double weight = std::sqrt(robotConfig.postureScale*scale);
+      for(int i = 0; i < pgdata.mb().nrJoints(); ++i)
+      {
+        if(pgdata.mb().joint(i).params() == 1)
+        {
+          int col = pgdata.qParamsBegin() + pgdata.mb().jointPosInParam(i);
+          int block = pattern_.addDense(1, 1, {row, col});
+          data.posture.push_back({i, runConfig.targetQ[i][0], weight, block});
+          ++row;
+        }
+      }
+    }
+
+    for(const BodyPositionTarget& bp: robotConfig.bodyPosTargets)
+    {
+      rbd::Jacobian jac(pgdata.mb(), bp.bodyId);
+      int block = pattern_.addJacobian(pgdata.mb(), jac, 3,
+                                       {row, pgdata.qParamsBegin()});
+      data.bodyPosTargets.push_back({pgdata.mb().bodyIndexById(bp.bodyId),
+                                     bp.target, Eigen::Matrix3d::Identity(),
+                                     std::sqrt(bp.scale*scale), jac, block});
+      row += 3;
+    }
+
+    for(const BodyOrientationTarget& bo: robotConfig.bodyOriTargets)
+    {
+      rbd::Jacobian jac(pgdata.mb(), bo.bodyId);
+      int block = pattern_.addJacobian(pgdata.mb(), jac, 3,
+                                       {row, pgdata.qParamsBegin()});
+      data.bodyOriTargets.push_back({pgdata.mb().bodyIndexById(bo.bodyId),
+                                     Eigen::Vector3d::Zero(), bo.target,
+                                     std::sqrt(bo.scale*scale), jac, block});
+      row += 3;
+    }
+  }
+
+  pattern_.finalize();
+}
+
+
+void LeastSquaresCostFunc::targets(const std::vector<RobotConfig>& robotConfigs,
+                                   const std::vector<RunConfig>& runConfigs)
+{
+  for(std::size_t robotIndex = 0; robotIndex < robotDatas_.size(); ++robotIndex)
+  {
+    const RobotConfig& robotConfig = robotConfigs[robotIndex];
+    RobotData& data = robotDatas_[robotIndex];
+    for(PostureData& pd: data.posture)
+    {
+      pd.target = runConfigs[robotIndex].targetQ[pd.jointIndex][0];
+    }
+    for(std::size_t i = 0; i < data.bodyPosTargets.size(); ++i)
+    {
+      data.bodyPosTargets[i].posTarget = robotConfig.bodyPosTargets[i].target;
+    }
+    for(std::size_t i = 0; i < data.bodyOriTargets.size(); ++i)
+    {
+      data.bodyOriTargets[i].oriTarget = robotConfig.bodyOriTargets[i].target;
+    }
+  }
+}
+
+
+int LeastSquaresCostFunc::nrResiduals(const std::vector<RobotConfig>& robotConfigs)
+{
+  int nrRes = 0;
+  for(const RobotConfig& rc: robotConfigs)
+  {
+    if(rc.postureScale > 0.)
+    {
+      for(int i = 0; i < rc.mb.nrJoints(); ++i)
+      {
+        nrRes += rc.mb.joint(i).params() == 1 ? 1 : 0;
+      }
+    }
+    nrRes += 3*int(rc.bodyPosTargets.size() + rc.bodyOriTargets.size());
+  }
+  return nrRes;
+}
+
+
+void LeastSquaresCostFunc::impl_compute(result_t& res, const argument_t& x) const
+{
+  int row = 0;
+  for(const RobotData& rd: robotDatas_)
+  {
+    rd.pgdata->x(x);
+    const rbd::MultiBodyConfig& mbc = rd.pgdata->mbc();
+
+    for(const PostureData& pd: rd.posture)
+    {
+      res(row) = pd.weight*(mbc.q[pd.jointIndex][0] - pd.target);
+      ++row;
+    }
+
+    for(const BodyTargetData& bp: rd.bodyPosTargets)
+    {
+      res.segment<3>(row) = bp.weight*
+        (mbc.bodyPosW[bp.bodyIndex].translation() - bp.posTarget);
+      row += 3;
+    }
+
+    for(const BodyTargetData& bo: rd.bodyOriTargets)
+    {
+      res.segment<3>(row) = bo.weight*
+        sva::rotationError(bo.oriTarget, mbc.bodyPosW[bo.bodyIndex].rotation(), 1e-7);
+      row += 3;
+    }
+  }
+}
+
+
+void LeastSquaresCostFunc::impl_jacobian(jacobian_t& jac, const argument_t& x) const
+{
+  pattern_.setZero();
+  for(RobotData& rd: robotDatas_)
+  {
+    rd.pgdata->x(x);
+
+    for(const PostureData& pd: rd.posture)
+    {
+      pattern_.add(pd.block, Eigen::Matrix<double, 1, 1>::Constant(pd.weight));
+    }
+
+    for(BodyTargetData& bp: rd.bodyPosTargets)
+    {
+      const Eigen::MatrixXd& jacMat = bp.jac.jacobian(rd.pgdata->mb(), rd.pgdata->mbc());
+      pattern_.add(bp.block, bp.weight*jacMat.bottomRows<3>());
+    }
+
+    // same angular velocity approximation of the rotation error
+    // derivative than StdCostFunc
+    for(BodyTargetData& bo: rd.bodyOriTargets)
+    {
+      const Eigen::MatrixXd& jacMat = bo.jac.jacobian(rd.pgdata->mb(), rd.pgdata->mbc());
+      pattern_.add(bo.block, bo.weight*jacMat.topRows<3>());
+    }
+  }
+  pattern_.copyTo(jac);
+}
+
+
+} // pg
@@ -0,0 +1,99 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// roboptim
+#include <roboptim/core/differentiable-function.hh>
+
+// RBDyn
+#include <RBDyn/Jacobian.h>
+
+// PG
+#include "FillSparse.h"
+
+
+namespace pg
+{
+class PGData;
+class RobotConfig;
+class RunConfig;
+
+/**
+  * Kinematic terms of StdCostFunc written as a residual vector r such that
+  * r^T r is the StdCostFunc value: posture (one row by single parameter
+  * joint), body position targets and body orientation targets (3 rows each).
+  * Force terms are ignored.
+  */
+class LeastSquaresCostFunc : public roboptim::DifferentiableSparseFunction
+{
+public:
+  typedef typename parent_t::argument_t argument_t;
+
+public:
+  LeastSquaresCostFunc(std::vector<PGData>& pgdatas,
+                       const std::vector<RobotConfig>& robotConfigs,
+                       const std::vector<RunConfig>& runConfigs);
+
+  /// Copy the targets of robotConfigs and runConfigs (configs with the
+  /// same structure than the constructor ones).
+  void targets(const std::vector<RobotConfig>& robotConfigs,
+               const std::vector<RunConfig>& runConfigs);
+
+  /// @return Number of residuals of the robotConfigs kinematic terms.
+  static int nrResiduals(const std::vector<RobotConfig>& robotConfigs);
+
+  void impl_compute(result_t& res, const argument_t& x) const;
+  void impl_jacobian(jacobian_t& jac, const argument_t& x) const;
+  void impl_gradient(gradient_t& /* gradient */,
+      const argument_t& /* x */, size_type /* functionId */) const
+  {
+    throw std::runtime_error("NEVER GO HERE");
+  }
+
+private:
+  struct PostureData
+  {
+    int jointIndex;
+    double target;
+    double weight;
+    int block;
+  };
+
+  struct BodyTargetData
+  {
+    int bodyIndex;
+    Eigen::Vector3d posTarget;
+    Eigen::Matrix3d oriTarget;
+    double weight;
+    rbd::Jacobian jac;
+    int block;
+  };
+
+  struct RobotData
+  {
+    PGData* pgdata;
+    std::vector<PostureData> posture;
+    std::vector<BodyTargetData> bodyPosTargets;
+    std::vector<BodyTargetData> bodyOriTargets;
+  };
+
+private:
+  mutable std::vector<RobotData> robotDatas_;
+  mutable SparsePattern pattern_;
+};
+
+} // namespace pg
@@ -0,0 +1,257 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "LevenbergMarquardt.h"
+
+// include
+// std
+#include <algorithm>
+#include <cmath>
+
+// Eigen
+#include <Eigen/Cholesky>
+
+
+namespace pg
+{
+
+
+LevenbergMarquardt::LevenbergMarquardt()
+  : functions_()
+  , normalize_()
+  , callback_()
+  , nrResiduals_(0)
+  , nrIters_(0)
+{}
+
+
+void LevenbergMarquardt::addFunction(boost::shared_ptr<function_t> f,
+                                     intervals_t bounds, double weight)
+{
+  int row = nrResiduals_;
+  nrResiduals_ += int(f->outputSize());
+  functions_.push_back({f, std::move(bounds), weight, row,
+                        Eigen::VectorXd(), function_t::jacobian_t()});
+}
+
+
+void LevenbergMarquardt::addFunctions(const LevenbergMarquardt& lm, double weight)
+{
+  for(const Function& fun: lm.functions_)
+  {
+    addFunction(fun.f, fun.bounds, fun.weight*weight);
+  }
+}
+
+
+void LevenbergMarquardt::normalizer(std::function<void(Eigen::VectorXd&)> normalize)
+{
+  normalize_ = std::move(normalize);
+}
+
+
+void LevenbergMarquardt::iterationCallback(
+  std::function<void(const Eigen::VectorXd&, const Eigen::VectorXd&)> callback)
+{
+  callback_ = std::move(callback);
+}
+
+
+double LevenbergMarquardt::solve(Eigen::VectorXd& x, const intervals_t& argBounds,
+                                 int maxIter, double tol)
+{
+  nrIters_ = 0;
+
+  clamp(x, argBounds);
+  Eigen::VectorXd r(nrResiduals_), rTrial(nrResiduals_);
+  Eigen::VectorXd xTrial(x.size()), y(nrResiduals_);
+  Eigen::MatrixXd J(nrResiduals_, x.size());
+  Eigen::MatrixXd JJt(nrResiduals_, nrResiduals_);
+  Eigen::LDLT<Eigen::MatrixXd> ldlt(nrResiduals_);
+
+  residual(x, r);
+  double norm = r.norm();
+  double lambda = -1.;
+  bool newPoint = true;
+
+  for(int iter = 0; iter < maxIter && norm > tol; ++iter)
+  {
+    if(newPoint)
+    {
+      jacobian(x, r, J);
+      JJt.noalias() = J*J.transpose();
+      if(lambda < 0.)
+      {
+        lambda = 1e-3*std::max(JJt.diagonal().maxCoeff(), 1e-12);
+      }
+      newPoint = false;
+    }
+
+    JJt.diagonal().array() += lambda;
+    ldlt.compute(JJt);
+    JJt.diagonal().array() -= lambda;
+    y = ldlt.solve(r);
+
+    xTrial = x;
+    xTrial.noalias() -= J.transpose()*y;
+    clamp(xTrial, argBounds);
+    residual(xTrial, rTrial);
+    double trialNorm = rTrial.norm();
+
+    if(trialNorm < norm)
+    {
+      bool stalled = norm - trialNorm <= 1e-10*norm;
+      x.swap(xTrial);
+      r.swap(rTrial);
+      norm = trialNorm;
+      lambda = std::max(lambda/10., 1e-15);
+      newPoint = true;
+      ++nrIters_;
+      if(callback_)
+      {
+        callback_(x, r);
+      }
+      if(stalled)
+      {
+        break;
+      }
+    }
+    else
+    {
+      lambda *= 10.;
+      // no descent direction anymore
+      if(lambda > 1e10)
+      {
+        break;
+      }
+    }
+  }
+
+  return norm;
+}
+
+
+void LevenbergMarquardt::residual(const Eigen::VectorXd& x, Eigen::VectorXd& r) const
+{
+  r.resize(nrResiduals_);
+  for(const Function& fun: functions_)
+  {
+    fun.value.resize(fun.f->outputSize());
+    (*fun.f)(fun.value, x);
+    for(int i = 0; i < int(fun.value.size()); ++i)
+    {
+      double v = fun.value(i);
+      double clamped = std::min(std::max(v, fun.bounds[i].first), fun.bounds[i].second);
+      r(fun.row + i) = fun.weight*(v - clamped);
+    }
+  }
+}
+
+
+void LevenbergMarquardt::prepareJacobian(const Function& fun,
+                                         const Eigen::VectorXd& x) const
+{
+  // functions overwrite their whole jacobian, the previous structure
+  // is kept to let them copy their values in place
+  if(fun.jac.rows() != fun.f->outputSize() || fun.jac.cols() != x.size())
+  {
+    fun.jac.resize(fun.f->outputSize(), x.size());
+  }
+}
+
+
+void LevenbergMarquardt::jacobian(const Eigen::VectorXd& x, const Eigen::VectorXd& r,
+                                  Eigen::MatrixXd& J) const
+{
+  J.setZero();
+  for(const Function& fun: functions_)
+  {
+    prepareJacobian(fun, x);
+    fun.f->jacobian(fun.jac, x);
+    for(int i = 0; i < int(fun.jac.rows()); ++i)
+    {
+      // satisfied inequalities don't contribute to the residual
+      if(r(fun.row + i) == 0. && fun.bounds[i].first != fun.bounds[i].second)
+      {
+        continue;
+      }
+      for(function_t::jacobian_t::InnerIterator it(fun.jac, i); it; ++it)
+      {
+        J(fun.row + i, it.col()) = fun.weight*it.value();
+      }
+    }
+  }
+}
+
+
+Eigen::MatrixXd LevenbergMarquardt::activeJacobian(const Eigen::VectorXd& x,
+                                                   double tol,
+                                                   std::vector<int>& rows) const
+{
+  rows.clear();
+  std::vector<int> activeRow(nrResiduals_, -1);
+  for(const Function& fun: functions_)
+  {
+    fun.value.resize(fun.f->outputSize());
+    (*fun.f)(fun.value, x);
+    for(int i = 0; i < int(fun.value.size()); ++i)
+    {
+      if(std::abs(fun.value(i) - fun.bounds[i].first) <= tol ||
+         std::abs(fun.value(i) - fun.bounds[i].second) <= tol)
+      {
+        activeRow[fun.row + i] = int(rows.size());
+        rows.push_back(fun.row + i);
+      }
+    }
+  }
+
+  Eigen::MatrixXd J(Eigen::MatrixXd::Zero(rows.size(), x.size()));
+  for(const Function& fun: functions_)
+  {
+    prepareJacobian(fun, x);
+    fun.f->jacobian(fun.jac, x);
+    for(int i = 0; i < int(fun.jac.rows()); ++i)
+    {
+      int row = activeRow[fun.row + i];
+      if(row == -1)
+      {
+        continue;
+      }
+      for(function_t::jacobian_t::InnerIterator it(fun.jac, i); it; ++it)
+      {
+        J(row, it.col()) = fun.weight*it.value();
+      }
+    }
+  }
+  return J;
+}
+
+
+void LevenbergMarquardt::clamp(Eigen::VectorXd& x, const intervals_t& argBounds) const
+{
+  for(int i = 0; i < int(argBounds.size()); ++i)
+  {
+    x(i) = std::min(std::max(x(i), argBounds[i].first), argBounds[i].second);
+  }
+
+  if(normalize_)
+  {
+    normalize_(x);
+  }
+}
+
+
+} // pg
@@ -0,0 +1,132 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <functional>
+#include <vector>
+
+// boost
+#include <boost/shared_ptr.hpp>
+
+// Eigen
+#include <Eigen/Core>
+
+// roboptim
+#include <roboptim/core/differentiable-function.hh>
+
+
+namespace pg
+{
+
+/**
+  * Damped least squares (Levenberg-Marquardt) minimization of the violation
+  * of a set of roboptim functions.
+  * The residual of a function f with bounds [l, u] is w*(f(x) - clamp(f(x), l, u)),
+  * so equality and inequality constraints can be mixed.
+  * The step is computed in its dual form (J J^T + lambda I) y = r, dx = -J^T y,
+  * that is cheap when there is less residuals than variables.
+  */
+class LevenbergMarquardt
+{
+public:
+  typedef roboptim::DifferentiableSparseFunction function_t;
+  typedef function_t::intervals_t intervals_t;
+
+public:
+  LevenbergMarquardt();
+
+  void addFunction(boost::shared_ptr<function_t> f, intervals_t bounds,
+                   double weight=1.);
+  /// Add all the functions of lm, their weight is multiplied by weight.
+  void addFunctions(const LevenbergMarquardt& lm, double weight=1.);
+
+  /// Called on each trial point to bring it back on the variables manifold
+  /// (free joint quaternion normalization).
+  void normalizer(std::function<void(Eigen::VectorXd&)> normalize);
+
+  /// Called with the point and its residuals after each accepted step.
+  void iterationCallback(
+    std::function<void(const Eigen::VectorXd&, const Eigen::VectorXd&)> callback);
+
+  int nrResiduals() const
+  {
+    return nrResiduals_;
+  }
+
+  /**
+    * Minimize the squared residuals norm.
+    * @param x Starting point, the last accepted point on output.
+    * @param argBounds Variables bounds, each trial point is clamped on them.
+    * @param maxIter Maximum number of iterations.
+    * @param tol Stop when the residuals norm is below tol.
+    * The minimization also stop when a step don't decrease the residuals norm
+    * by more than a relative 1e-10.
+    * @return Residuals norm at x.
+    */
+  double solve(Eigen::VectorXd& x, const intervals_t& argBounds,
+               int maxIter, double tol=1e-8);
+
+  /// Number of accepted steps of the last solve.
+  int nrIters() const
+  {
+    return nrIters_;
+  }
+
+  /// Compute the residuals at x.
+  void residual(const Eigen::VectorXd& x, Eigen::VectorXd& r) const;
+
+  /**
+    * Weighted jacobian of the residuals active at x: equalities and
+    * inequalities with a value within tol of a bound.
+    * @param rows Residual index of each jacobian row.
+    */
+  Eigen::MatrixXd activeJacobian(const Eigen::VectorXd& x, double tol,
+                                 std::vector<int>& rows) const;
+
+private:
+  /// Jacobian of the residuals, rows of satisfied inequalities are left to zero.
+  void jacobian(const Eigen::VectorXd& x, const Eigen::VectorXd& r,
+                Eigen::MatrixXd& J) const;
+  /// Clamp x on its bounds and normalize it.
+  void clamp(Eigen::VectorXd& x, const intervals_t& argBounds) const;
+
+private:
+  struct Function
+  {
+    boost::shared_ptr<function_t> f;
+    intervals_t bounds;
+    double weight;
+    int row;
+    /// Evaluation buffers, kept between calls so that a function writing
+    /// the same jacobian structure don't allocate.
+    mutable Eigen::VectorXd value;
+    mutable function_t::jacobian_t jac;
+  };
+
+  /// Resize fun.jac only if its dimensions changed.
+  void prepareJacobian(const Function& fun, const Eigen::VectorXd& x) const;
+
+private:
+  std::vector<Function> functions_;
+  std::function<void(Eigen::VectorXd&)> normalize_;
+  std::function<void(const Eigen::VectorXd&, const Eigen::VectorXd&)> callback_;
+  int nrResiduals_;
+  int nrIters_;
+};
+
+} // namespace pg
@@ -0,0 +1,245 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "ModelReduction.h"
+
+// include
+// std
+#include <algorithm>
+
+// RBDyn
+#include <RBDyn/FK.h>
+#include <RBDyn/MultiBodyConfig.h>
+
+
+namespace pg
+{
+
+
+std::vector<int> referencedBodies(const RobotConfig& rc)
+{
+  std::vector<int> ids;
+  auto add = [&ids](int id) {ids.push_back(id);};
+
+  for(const FixedPositionContact& c: rc.fixedPosContacts) add(c.bodyId);
+  for(const FixedOrientationContact& c: rc.fixedOriContacts) add(c.bodyId);
+  for(const PlanarContact& c: rc.planarContacts) add(c.bodyId);
+  for(const EllipseContact& c: rc.ellipseContacts) add(c.bodyId);
+  for(const GripperContact& c: rc.gripperContacts) add(c.bodyId);
+  for(const CylindricalContact& c: rc.cylindricalContacts) add(c.bodyId);
+  for(const ForceContact& c: rc.forceContacts) add(c.bodyId);
+  for(const EnvCollision& c: rc.envCollisions) add(c.bodyId);
+  for(const SelfCollision& c: rc.selfCollisions)
+  {
+    add(c.body1Id);
+    add(c.body2Id);
+  }
+  for(const BodyPositionTarget& t: rc.bodyPosTargets) add(t.bodyId);
+  for(const BodyOrientationTarget& t: rc.bodyOriTargets) add(t.bodyId);
+  for(const ForceContactMinimization& t: rc.forceContactsMin) add(t.bodyId);
+  for(const TorqueContactMinimization& t: rc.torqueContactsMin) add(t.bodyId);
+  for(const NormalForceTarget& t: rc.normalForceTargets) add(t.bodyId);
+  for(const TangentialForceMinimization& t: rc.tanForceMin) add(t.bodyId);
+
+  return ids;
+}
+
+
+/*
+ *                        ModelReduction
+ */
+
+
+template <typename T>
+std::vector<T> ModelReduction::reduce(const std::vector<T>& jointVec) const
+{
+  // vector not sized by joint (like empty bound vector) are left unchanged
+  if(int(jointVec.size()) != nrFullJoints_)
+  {
+    return jointVec;
+  }
+
+  std::vector<T> res;
+  res.reserve(joints_.size());
+  for(std::size_t i = 0; i < joints_.size(); ++i)
+  {
+    // locked joints are fixed joints without parameters
+    res.push_back(locked_[i] ? T() : jointVec[joints_[i]]);
+  }
+  return res;
+}
+
+
+ModelReduction::ModelReduction(const RobotConfig& robotConfig,
+                               const RunConfig& runConfig,
+                               const std::vector<int>& extraBodyIds,
+                               bool reduceTree)
+  : robotConfig_(robotConfig)
+  , runConfig_(runConfig)
+  , reduced_(false)
+  , nrFullJoints_(robotConfig.mb.nrJoints())
+  , joints_()
+  , locked_()
+  , params_()
+  , initQ_(rbd::paramToVector(robotConfig.mb, runConfig.initQ))
+{
+  const rbd::MultiBody& mb = robotConfig.mb;
+
+  // keep the path from the root to each referenced body
+  std::vector<bool> keep(mb.nrBodies(), !reduceTree);
+  keep[0] = true;
+  auto keepPath = [&mb, &keep](int bodyId)
+  {
+    for(int i = mb.bodyIndexById(bodyId); !keep[i]; i = mb.parent(i))
+    {
+      keep[i] = true;
+    }
+  };
+  for(int id: referencedBodies(robotConfig))
+  {
+    keepPath(id);
+  }
+  for(int id: extraBodyIds)
+  {
+    keepPath(id);
+  }
+
+  // joints with parameters to lock
+  std::vector<bool> lock(mb.nrJoints(), false);
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    const rbd::Joint& j = mb.joint(i);
+    lock[i] = j.params() > 0 &&
+      std::find(runConfig.lockedJoints.begin(), runConfig.lockedJoints.end(),
+                j.id()) != runConfig.lockedJoints.end();
+  }
+
+  reduced_ = std::find(keep.begin(), keep.end(), false) != keep.end() ||
+    std::find(lock.begin(), lock.end(), true) != lock.end();
+  if(!reduced_)
+  {
+    return;
+  }
+
+  // merge removed bodies inertia into their closest kept ancestor
+  // at the initQ configuration
+  rbd::MultiBodyConfig mbc(mb);
+  mbc.zero(mb);
+  mbc.q = runConfig.initQ;
+  rbd::forwardKinematics(mb, mbc);
+
+  std::vector<sva::RBInertiad> inertias;
+  inertias.reserve(mb.nrBodies());
+  for(const rbd::Body& b: mb.bodies())
+  {
+    inertias.push_back(b.inertia());
+  }
+
+  for(int i = 0; i < mb.nrBodies(); ++i)
+  {
+    if(!keep[i])
+    {
+      int ancestor = mb.parent(i);
+      while(!keep[ancestor])
+      {
+        ancestor = mb.parent(ancestor);
+      }
+      sva::PTransformd X_a_i = mbc.bodyPosW[i]*mbc.bodyPosW[ancestor].inv();
+      inertias[ancestor] = inertias[ancestor] + X_a_i.transMul(mb.body(i).inertia());
+    }
+  }
+
+  // build the reduced multibody, the parents are always before their
+  // children so keeping the full model order is enough
+  std::vector<int> index(mb.nrBodies(), -1);
+  std::vector<rbd::Body> bodies;
+  std::vector<rbd::Joint> joints;
+  std::vector<int> pred, succ, parent;
+  std::vector<sva::PTransformd> Xt;
+  auto toReduced = [&index](int i) {return i < 0 ? -1 : index[i];};
+
+  for(int i = 0; i < mb.nrBodies(); ++i)
+  {
+    if(keep[i])
+    {
+      const rbd::Body& b = mb.body(i);
+      index[i] = int(bodies.size());
+      bodies.emplace_back(inertias[i], b.id(), b.name());
+    }
+  }
+
+  int reducedPos = 0;
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    if(keep[mb.successor(i)])
+    {
+      const rbd::Joint& j = mb.joint(i);
+      joints_.push_back(i);
+      locked_.push_back(lock[i]);
+      pred.push_back(toReduced(mb.predecessor(i)));
+      succ.push_back(toReduced(mb.successor(i)));
+      parent.push_back(toReduced(mb.parent(i)));
+
+      if(lock[i])
+      {
+        // parentToSon = jointConfig*Xt, jointConfig is constant when locked
+        joints.emplace_back(rbd::Joint::Fixed, true, j.id(), j.name());
+        Xt.push_back(j.pose(runConfig.initQ[i])*mb.transform(i));
+      }
+      else
+      {
+        joints.push_back(j);
+        Xt.push_back(mb.transform(i));
+
+        int size = j.params();
+        params_.push_back({mb.jointPosInParam(i), reducedPos, size});
+        reducedPos += size;
+      }
+    }
+  }
+
+  robotConfig_.mb = rbd::MultiBody(bodies, joints, pred, succ, parent, Xt);
+  robotConfig_.ql = reduce(robotConfig.ql);
+  robotConfig_.qu = reduce(robotConfig.qu);
+  robotConfig_.tl = reduce(robotConfig.tl);
+  robotConfig_.tu = reduce(robotConfig.tu);
+  robotConfig_.tlPoly = reduce(robotConfig.tlPoly);
+  robotConfig_.tuPoly = reduce(robotConfig.tuPoly);
+
+  runConfig_.initQ = reduce(runConfig.initQ);
+  runConfig_.targetQ = reduce(runConfig.targetQ);
+  runConfig_.lockedJoints.clear();
+}
+
+
+void ModelReduction::expandQ(const Eigen::Ref<const Eigen::VectorXd>& reducedQ,
+                             Eigen::Ref<Eigen::VectorXd> q) const
+{
+  if(!reduced())
+  {
+    q = reducedQ;
+    return;
+  }
+
+  q = initQ_;
+  for(const ParamSegment& ps: params_)
+  {
+    q.segment(ps.fullPos, ps.size) = reducedQ.segment(ps.reducedPos, ps.size);
+  }
+}
+
+
+} // pg
@@ -0,0 +1,112 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// PG
+#include "ConfigStruct.h"
+
+
+namespace pg
+{
+
+/// @return Id of the bodies used by the constraints and the costs of robotConfig.
+std::vector<int> referencedBodies(const RobotConfig& robotConfig);
+
+
+/**
+  * Robot model restricted to the bodies referenced by a problem.
+  * When the tree is reduced only the joints on the path from the root to a
+  * referenced body are kept, the others are locked at their initQ value and
+  * their bodies inertia is merged into the closest kept ancestor, so the
+  * robot mass and CoM are unchanged.
+  * Kept joints listed in RunConfig::lockedJoints become fixed joints
+  * at their initQ value and then have no variables.
+  * Body and joint id are kept, contacts, targets and collisions then
+  * reference the same bodies in the reduced model.
+  */
+class ModelReduction
+{
+public:
+  /**
+    * @param robotConfig Full model robot configuration.
+    * @param runConfig Full model run configuration.
+    * @param extraBodyIds Id of bodies used outside robotConfig (robot links).
+    * @param reduceTree Remove the joints that don't move a referenced body.
+    */
+  ModelReduction(const RobotConfig& robotConfig, const RunConfig& runConfig,
+                 const std::vector<int>& extraBodyIds, bool reduceTree);
+
+  /// @return true if at least one joint was removed or locked.
+  bool reduced() const
+  {
+    return reduced_;
+  }
+
+  /// Reduced model robot configuration.
+  const RobotConfig& robotConfig() const
+  {
+    return robotConfig_;
+  }
+
+  /// Reduced model run configuration.
+  const RunConfig& runConfig() const
+  {
+    return runConfig_;
+  }
+
+  /// Full model index of each reduced model joint (locked joints included).
+  const std::vector<int>& joints() const
+  {
+    return joints_;
+  }
+
+  /**
+    * Compute the full model parameter vector.
+    * @param reducedQ Reduced model parameter vector.
+    * @param q Full model parameter vector.
+    */
+  void expandQ(const Eigen::Ref<const Eigen::VectorXd>& reducedQ,
+               Eigen::Ref<Eigen::VectorXd> q) const;
+
+private:
+  template <typename T>
+  std::vector<T> reduce(const std::vector<T>& jointVec) const;
+
+private:
+  struct ParamSegment
+  {
+    int fullPos, reducedPos, size;
+  };
+
+private:
+  RobotConfig robotConfig_;
+  RunConfig runConfig_;
+  bool reduced_;
+  int nrFullJoints_;
+  std::vector<int> joints_;
+  std::vector<bool> locked_;
+  std::vector<ParamSegment> params_;
+  Eigen::VectorXd initQ_;
+};
+
+} // namespace pg
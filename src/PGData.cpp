@@ -27,6 +27,9 @@
 // PG
 #include "ConfigStruct.h"
 #include "JacobianPatcher.h"
+#include "PGDataGroup.h"
+#include "Profiler.h"
+#include "Tracer.h"
 
 namespace pg
 {
@@ -45,6 +48,10 @@ PGData::PGData(const rbd::MultiBody& mb, const Eigen::Vector3d& gravity,
   , qBegin_(qBegin)
   , forceBegin_(forceBegin)
   , xStamp_(0)
+  , group_(nullptr)
+  , updateHooks_()
+  , fkProfile_(nullptr)
+  , trace_(nullptr)
 {
   xq_.setZero();
   mbc_.zero(mb_);
@@ -59,6 +66,18 @@ PGData::PGData(const rbd::MultiBody& mb, const Eigen::Vector3d& gravity,
 
 
 std::size_t PGData::x(const Eigen::VectorXd& x)
+{
+  if(group_)
+  {
+    group_->x(x);
+    return xStamp_;
+  }
+
+  return updateX(x);
+}
+
+
+std::size_t PGData::updateX(const Eigen::VectorXd& x)
 {
   if(xq_ != x.segment(qBegin_, mb_.nrParams()) ||
      xf_ != x.segment(forceBegin_, nrForcePoints_*3))
@@ -68,7 +87,19 @@ std::size_t PGData::x(const Eigen::VectorXd& x)
     update();
   }
 
-   return xStamp_;
+  return xStamp_;
+}
+
+
+void PGData::addUpdateHook(std::function<void()> hook)
+{
+  updateHooks_.push_back(std::move(hook));
+}
+
+
+void PGData::clearUpdateHooks()
+{
+  updateHooks_.clear();
 }
 
 
@@ -108,9 +139,13 @@ void PGData::ellipses(const std::vector<EllipseContact>& ellipseContacts)
 void PGData::update()
 {
   ++xStamp_;
-  rbd::vectorToParam(xq_, mbc_.q);
-  rbd::forwardKinematics(mb_, mbc_);
-  patchMbc(mb_, mbc_);
+  {
+    ScopedProfile prof(fkProfile_);
+    ScopedTrace trace(trace_, Tracer::FK, Tracer::Robot);
+    rbd::vectorToParam(xq_, mbc_.q);
+    rbd::forwardKinematics(mb_, mbc_);
+    patchMbc(mb_, mbc_);
+  }
 
   int fPos = 0;
   for(ForceData& fd: forceDatas_)
@@ -123,6 +158,11 @@ void PGData::update()
     }
   }
 
+  for(const std::function<void()>& hook: updateHooks_)
+  {
+    hook();
+  }
+
   /*
   for(EllipseData& ed: ellipseDatas_)
   {
@@ -18,6 +18,7 @@
 // include
 // std
 #include <cassert>
+#include <functional>
 #include <vector>
 
 // boost
@@ -36,6 +37,9 @@ namespace pg
 {
 class ForceContact;
 class EllipseContact;
+class PGDataGroup;
+struct ProfileCounter;
+class TraceBuffer;
 
 class PGData
 {
@@ -71,6 +75,26 @@ public:
          int pbSize, int qBegin, int forceBegin);
 
   std::size_t x(const Eigen::VectorXd& x);
+  /// Update this robot from x without going through the group.
+  std::size_t updateX(const Eigen::VectorXd& x);
+
+  /// When set x call are forwarded to the group that update all the robots.
+  void group(PGDataGroup* group)
+  {
+    group_ = group;
+  }
+
+  /// Profile the forward kinematics of each update in fk
+  /// and trace them in trace (disabled if null).
+  void profile(ProfileCounter* fk, TraceBuffer* trace=nullptr)
+  {
+    fkProfile_ = fk;
+    trace_ = trace;
+  }
+
+  /// Hook called at each update after the forward kinematics.
+  void addUpdateHook(std::function<void()> hook);
+  void clearUpdateHooks();
 
   void forces(const std::vector<ForceContact>& fd);
   void ellipses(const std::vector<EllipseContact>& ed);
@@ -159,6 +183,11 @@ private:
 
   std::vector<EllipseData> ellipseDatas_;
   std::size_t xStamp_;
+
+  PGDataGroup* group_;
+  std::vector<std::function<void()>> updateHooks_;
+  ProfileCounter* fkProfile_;
+  TraceBuffer* trace_;
 };
 
 
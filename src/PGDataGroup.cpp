@@ -0,0 +1,168 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "PGDataGroup.h"
+
+// include
+// PG
+#include "PGData.h"
+
+
+namespace pg
+{
+
+
+PGDataGroup::PGDataGroup(std::vector<PGData>& pgdatas, bool parallel)
+  : pgdatas_()
+  , x_()
+  , workers_()
+  , generation_(0)
+  , pending_(0)
+  , stop_(false)
+  , error_()
+{
+  pgdatas_.reserve(pgdatas.size());
+  for(PGData& pgdata: pgdatas)
+  {
+    pgdata.group(this);
+    pgdatas_.push_back(&pgdata);
+  }
+
+  // the calling thread always update the first robot
+  if(parallel && pgdatas_.size() > 1)
+  {
+    workers_.reserve(pgdatas_.size() - 1);
+    for(std::size_t i = 1; i < pgdatas_.size(); ++i)
+    {
+      workers_.emplace_back(&PGDataGroup::work, this, i);
+    }
+  }
+}
+
+
+PGDataGroup::~PGDataGroup()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  workCond_.notify_all();
+  for(std::thread& t: workers_)
+  {
+    t.join();
+  }
+
+  // update hooks are bound to the constraints of the current run
+  for(PGData* pgdata: pgdatas_)
+  {
+    pgdata->group(nullptr);
+    pgdata->clearUpdateHooks();
+  }
+}
+
+
+void PGDataGroup::x(const Eigen::VectorXd& x)
+{
+  if(x_.size() == x.size() && x_ == x)
+  {
+    return;
+  }
+  x_ = x;
+
+  if(workers_.empty())
+  {
+    for(PGData* pgdata: pgdatas_)
+    {
+      pgdata->updateX(x_);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    pending_ = workers_.size();
+    error_ = std::exception_ptr();
+  }
+  workCond_.notify_all();
+
+  std::exception_ptr error;
+  try
+  {
+    pgdatas_[0]->updateX(x_);
+  }
+  catch(...)
+  {
+    error = std::current_exception();
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  doneCond_.wait(lock, [this](){return pending_ == 0;});
+  if(!error)
+  {
+    error = error_;
+  }
+
+  if(error)
+  {
+    // force a full update next time
+    x_.resize(0);
+    std::rethrow_exception(error);
+  }
+}
+
+
+void PGDataGroup::work(std::size_t index)
+{
+  std::size_t generation = 0;
+  while(true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      workCond_.wait(lock, [this, generation](){return stop_ || generation_ != generation;});
+      if(stop_)
+      {
+        return;
+      }
+      generation = generation_;
+    }
+
+    std::exception_ptr error;
+    try
+    {
+      pgdatas_[index]->updateX(x_);
+    }
+    catch(...)
+    {
+      error = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if(error)
+      {
+        error_ = error;
+      }
+      if(--pending_ == 0)
+      {
+        doneCond_.notify_one();
+      }
+    }
+  }
+}
+
+
+} // pg
@@ -0,0 +1,68 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+
+namespace pg
+{
+class PGData;
+
+/**
+  * Update all the robots of a problem for a given iterate.
+  * The first PGData::x call with a new iterate run the forward kinematics
+  * and the update hooks (collision, CoM, ...) of every robot, each robot
+  * on its own thread when parallel is true.
+  * Constraints then only read the robots state.
+  */
+class PGDataGroup
+{
+public:
+  PGDataGroup(std::vector<PGData>& pgdatas, bool parallel);
+  ~PGDataGroup();
+
+  PGDataGroup(const PGDataGroup&) = delete;
+  PGDataGroup& operator=(const PGDataGroup&) = delete;
+
+  void x(const Eigen::VectorXd& x);
+
+private:
+  void work(std::size_t index);
+
+private:
+  std::vector<PGData*> pgdatas_;
+  Eigen::VectorXd x_;
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable workCond_, doneCond_;
+  std::size_t generation_;
+  std::size_t pending_;
+  bool stop_;
+  std::exception_ptr error_;
+};
+
+} // namespace pg
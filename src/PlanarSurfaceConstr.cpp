@@ -19,7 +19,6 @@
 // include
 // PG
 #include "PGData.h"
-#include "FillSparse.h"
 
 
 namespace pg
@@ -41,13 +40,23 @@ PlanarPositionContactConstr::PlanarPositionContactConstr(PGData* pgdata, int bod
   , surfaceFrame_(surfaceFrame)
   , jac_(pgdata->multibody(), bodyId, surfaceFrame.translation())
   , dotCache_(1, jac_.dof())
-{}
+  , pattern_(1, pgdata->pbSize())
+  , block_(pattern_.addJacobian(pgdata->mb(), jac_, 1, {0, pgdata->qParamsBegin()}))
+{
+  pattern_.finalize();
+}
 
 
 PlanarPositionContactConstr::~PlanarPositionContactConstr()
 { }
 
 
+void PlanarPositionContactConstr::targetFrame(const sva::PTransformd& targetFrame)
+{
+  targetFrame_ = targetFrame;
+}
+
+
 void PlanarPositionContactConstr::impl_compute(result_t& res, const argument_t& x) const
 {
   pgdata_->x(x);
@@ -60,11 +69,11 @@ void PlanarPositionContactConstr::impl_compute(result_t& res, const argument_t&
 void PlanarPositionContactConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
   pgdata_->x(x);
-  jac.reserve(jac_.dof());
 
   const Eigen::MatrixXd& mat = jac_.jacobian(pgdata_->multibody(), pgdata_->mbc());
   dotCache_.noalias() = targetFrame_.rotation().row(2)*mat.block(3, 0, 3, mat.cols());
-  fullJacobianSparse(pgdata_->mb(), jac_, dotCache_, jac, {0, pgdata_->qParamsBegin()});
+  pattern_.set(block_, dotCache_);
+  pattern_.copyTo(jac);
 }
 
 
@@ -87,13 +96,23 @@ PlanarOrientationContactConstr::PlanarOrientationContactConstr(PGData* pgdata, i
   , Baxis_((axis + 2) % 3)
   , jac_(pgdata->multibody(), bodyId, surfaceFrame.translation())
   , dotCache_(3, jac_.dof())
-{}
+  , pattern_(3, pgdata->pbSize())
+  , block_(pattern_.addJacobian(pgdata->mb(), jac_, 3, {0, pgdata->qParamsBegin()}))
+{
+  pattern_.finalize();
+}
 
 
 PlanarOrientationContactConstr::~PlanarOrientationContactConstr()
 { }
 
 
+void PlanarOrientationContactConstr::targetFrame(const sva::PTransformd& targetFrame)
+{
+  targetFrame_ = targetFrame;
+}
+
+
 void PlanarOrientationContactConstr::impl_compute(result_t& res, const argument_t& x) const
 {
   pgdata_->x(x);
@@ -108,7 +127,6 @@ void PlanarOrientationContactConstr::impl_compute(result_t& res, const argument_
 void PlanarOrientationContactConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
   pgdata_->x(x);
-  jac.reserve(jac_.dof()*3);
 
   const Eigen::MatrixXd& mat = jac_.vectorJacobian(pgdata_->multibody(),
       pgdata_->mbc(), surfaceFrame_.rotation().row(Naxis_).transpose());
@@ -116,7 +134,8 @@ void PlanarOrientationContactConstr::impl_jacobian(jacobian_t& jac, const argume
   dotCache_.row(0).noalias() = targetFrame_.rotation().row(Naxis_)*mat.block(3, 0, 3, mat.cols());
   dotCache_.row(1).noalias() = targetFrame_.rotation().row(Taxis_)*mat.block(3, 0, 3, mat.cols());
   dotCache_.row(2).noalias() = targetFrame_.rotation().row(Baxis_)*mat.block(3, 0, 3, mat.cols());
-  fullJacobianSparse(pgdata_->mb(), jac_, dotCache_, jac, {0, pgdata_->qParamsBegin()});
+  pattern_.set(block_, dotCache_);
+  pattern_.copyTo(jac);
 }
 
 
@@ -143,6 +162,9 @@ PlanarInclusionConstr::PlanarInclusionConstr(PGData* pgdata, int bodyId,
   , bJac_(1, jac_.dof())
   , sumJac_(1, jac_.dof())
   , fullJac_(outputSize(), jac_.dof())
+  , pattern_(int(outputSize()), pgdata->pbSize())
+  , block_(pattern_.addJacobian(pgdata->mb(), jac_, int(outputSize()),
+                                 {0, pgdata->qParamsBegin()}))
 {
   assert(targetPoints.size() > 2);
   for(std::size_t i = 0; i < targetPoints.size(); ++i)
@@ -158,6 +180,7 @@ PlanarInclusionConstr::PlanarInclusionConstr(PGData* pgdata, int bodyId,
     sva::PTransformd p(Eigen::Vector3d(surfacePoints[i].x(), surfacePoints[i].y(), 0.));
     surfacePoints_[i] = p*surfaceFrame;
   }
+  pattern_.finalize();
 }
 
 
@@ -165,6 +188,12 @@ PlanarInclusionConstr::~PlanarInclusionConstr()
 { }
 
 
+void PlanarInclusionConstr::targetFrame(const sva::PTransformd& targetFrame)
+{
+  targetFrame_ = targetFrame;
+}
+
+
 void PlanarInclusionConstr::impl_compute(result_t& res, const argument_t& x) const
 {
   pgdata_->x(x);
@@ -191,7 +220,6 @@ void PlanarInclusionConstr::impl_compute(result_t& res, const argument_t& x) con
 void PlanarInclusionConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
   pgdata_->x(x);
-  jac.reserve(outputSize()*jac_.dof());
 
   const Eigen::MatrixXd& jacMat = jac_.jacobian(pgdata_->multibody(), pgdata_->mbc());
   int resIndex = 0;
@@ -209,7 +237,8 @@ void PlanarInclusionConstr::impl_jacobian(jacobian_t& jac, const argument_t& x)
       ++resIndex;
     }
   }
-  fullJacobianSparse(pgdata_->mb(), jac_, fullJac_, jac, {0, pgdata_->qParamsBegin()});
+  pattern_.set(block_, fullJac_);
+  pattern_.copyTo(jac);
 }
 
 } // pg
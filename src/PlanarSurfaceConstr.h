@@ -26,6 +26,9 @@
 // RBDyn
 #include <RBDyn/Jacobian.h>
 
+// PG
+#include "FillSparse.h"
+
 
 namespace pg
 {
@@ -42,6 +45,8 @@ public:
       const sva::PTransformd& surfaceFrame);
   ~PlanarPositionContactConstr();
 
+  void targetFrame(const sva::PTransformd& targetFrame);
+
 
   void impl_compute(result_t& res, const argument_t& x) const;
   void impl_jacobian(jacobian_t& jac, const argument_t& x) const;
@@ -59,6 +64,8 @@ private:
   sva::PTransformd surfaceFrame_;
   mutable rbd::Jacobian jac_;
   mutable Eigen::MatrixXd dotCache_;
+  mutable SparsePattern pattern_;
+  int block_;
 };
 
 
@@ -75,6 +82,8 @@ public:
       int axis);
   ~PlanarOrientationContactConstr();
 
+  void targetFrame(const sva::PTransformd& targetFrame);
+
 
   void impl_compute(result_t& res, const argument_t& x) const;
   void impl_jacobian(jacobian_t& jac, const argument_t& x) const;
@@ -93,6 +102,8 @@ private:
   int Naxis_, Taxis_, Baxis_;
   mutable rbd::Jacobian jac_;
   mutable Eigen::MatrixXd dotCache_;
+  mutable SparsePattern pattern_;
+  int block_;
 };
 
 
@@ -111,6 +122,8 @@ public:
       const std::vector<Eigen::Vector2d>& surfacePoints);
   ~PlanarInclusionConstr();
 
+  void targetFrame(const sva::PTransformd& targetFrame);
+
 
   void impl_compute(result_t& res, const argument_t& x) const;
   void impl_jacobian(jacobian_t& jac, const argument_t& x) const;
@@ -134,6 +147,8 @@ private:
   mutable Eigen::MatrixXd bJac_;
   mutable Eigen::MatrixXd sumJac_;
   mutable Eigen::MatrixXd fullJac_;
+  mutable SparsePattern pattern_;
+  int block_;
 };
 
 } // namespace pg
@@ -19,7 +19,6 @@
 // include
 // PG
 #include "PGData.h"
-#include "FillSparse.h"
 
 namespace pg
 {
@@ -28,9 +27,11 @@ namespace pg
 PositiveForceConstr::PositiveForceConstr(PGData* pgdata)
   : roboptim::DifferentiableSparseFunction(pgdata->pbSize(), pgdata->nrForcePoints(), "PositiveForce")
   , pgdata_(pgdata)
-  , nrNonZero_(0)
   , jacPoints_(pgdata->nrForcePoints())
   , jacPointsMatTmp_(pgdata->nrForcePoints())
+  , pattern_(pgdata->nrForcePoints(), pgdata->pbSize())
+  , jacBlocks_(pgdata->nrForcePoints())
+  , forceBlocks_(pgdata->nrForcePoints())
 {
   std::size_t index = 0;
   for(const PGData::ForceData& fd: pgdata_->forceDatas())
@@ -39,11 +40,14 @@ PositiveForceConstr::PositiveForceConstr(PGData* pgdata)
     {
       jacPoints_[index] = rbd::Jacobian(pgdata_->mb(), fd.bodyId, fd.points[i].translation());
       jacPointsMatTmp_[index].resize(1, jacPoints_[index].dof());
-      // jacobian dof + force vec
-      nrNonZero_ += jacPoints_[index].dof() + 3;
+      jacBlocks_[index] = pattern_.addJacobian(pgdata_->mb(), jacPoints_[index], 1,
+                                               {int(index), pgdata_->qParamsBegin()});
+      forceBlocks_[index] = pattern_.addDense(1, 3,
+        {int(index), pgdata_->forceParamsBegin() + int(index)*3});
       ++index;
     }
   }
+  pattern_.finalize();
 }
 
 
@@ -72,7 +76,6 @@ void PositiveForceConstr::impl_compute(result_t& res, const argument_t& x) const
 void PositiveForceConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
   pgdata_->x(x);
-  jac.reserve(nrNonZero_);
 
   int index = 0;
   for(const PGData::ForceData& fd: pgdata_->forceDatas())
@@ -87,17 +90,13 @@ void PositiveForceConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) co
                                            fd.points[i].rotation().row(2).transpose())\
           .block(3, 0, 3, jacPoints_[index].dof());
       jacPointsMatTmp_[index].noalias() = fd.forces[i].force().transpose()*jacPointMat;
-      fullJacobianSparse(pgdata_->mb(), jacPoints_[index], jacPointsMatTmp_[index],
-                         jac, {index, pgdata_->qParamsBegin()});
-
-      int indexCols = pgdata_->forceParamsBegin() + index*3;
-      jac.insert(index, indexCols + 0) = X_0_pi.rotation().row(2)(0);
-      jac.insert(index, indexCols + 1) = X_0_pi.rotation().row(2)(1);
-      jac.insert(index, indexCols + 2) = X_0_pi.rotation().row(2)(2);
+      pattern_.set(jacBlocks_[index], jacPointsMatTmp_[index]);
+      pattern_.set(forceBlocks_[index], X_0_pi.rotation().row(2));
 
       ++index;
     }
   }
+  pattern_.copyTo(jac);
 }
 
 } // pg
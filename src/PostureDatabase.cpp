@@ -0,0 +1,602 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "PostureDatabase.h"
+
+// include
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+// posix
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// RBDyn
+#include <RBDyn/MultiBody.h>
+
+
+namespace pg
+{
+
+static const char databaseFileMagic[4] = {'P', 'G', 'D', 'B'};
+static const std::uint32_t databaseFileVersion = 2;
+static const std::size_t databaseHeaderSize = 4 + sizeof(std::uint32_t);
+static const std::size_t entryHeaderSize = sizeof(std::uint64_t) + 2*sizeof(std::uint32_t);
+
+
+/*
+ *   Signature and features
+ */
+
+
+/// FNV-1a hash.
+class SignatureHash
+{
+public:
+  SignatureHash()
+    : hash_(14695981039346656037ULL)
+  {}
+
+  void operator()(int v)
+  {
+    std::uint32_t u = std::uint32_t(v);
+    for(int i = 0; i < 4; ++i)
+    {
+      hash_ ^= (u >> (8*i)) & 0xff;
+      hash_ *= 1099511628211ULL;
+    }
+  }
+
+  /// Hash the tag, the size and the body id of each element.
+  template<typename T>
+  void bodies(int tag, const std::vector<T>& v)
+  {
+    (*this)(tag);
+    (*this)(int(v.size()));
+    for(const T& e: v)
+    {
+      (*this)(e.bodyId);
+    }
+  }
+
+  std::uint64_t hash() const
+  {
+    return hash_;
+  }
+
+private:
+  std::uint64_t hash_;
+};
+
+
+std::uint64_t PostureDatabase::signature(const std::vector<RobotConfig>& robotConfigs,
+                                         const std::vector<RobotLink>& robotLinks)
+{
+  SignatureHash h;
+  h(int(robotConfigs.size()));
+  for(const RobotConfig& rc: robotConfigs)
+  {
+    h(rc.mb.nrParams());
+    h(rc.mb.nrDof());
+    for(const rbd::Joint& j: rc.mb.joints())
+    {
+      h(int(j.type()));
+    }
+
+    h.bodies(0, rc.fixedPosContacts);
+    h.bodies(1, rc.fixedOriContacts);
+    h.bodies(2, rc.planarContacts);
+    for(const PlanarContact& pc: rc.planarContacts)
+    {
+      h(int(pc.targetPoints.size()));
+      h(int(pc.surfacePoints.size()));
+    }
+    h.bodies(3, rc.ellipseContacts);
+    h.bodies(4, rc.gripperContacts);
+    for(const GripperContact& gc: rc.gripperContacts)
+    {
+      h(int(gc.targetPoints.size()));
+      h(int(gc.surfacePoints.size()));
+    }
+    h.bodies(5, rc.cylindricalContacts);
+    h.bodies(6, rc.forceContacts);
+    for(const ForceContact& fc: rc.forceContacts)
+    {
+      h(int(fc.points.size()));
+    }
+    h.bodies(7, rc.envCollisions);
+    h(8);
+    h(int(rc.selfCollisions.size()));
+    for(const SelfCollision& sc: rc.selfCollisions)
+    {
+      h(sc.body1Id);
+      h(sc.body2Id);
+    }
+    h(9);
+    h(int(rc.comHalfSpaces.size()));
+    for(const CoMHalfSpace& cs: rc.comHalfSpaces)
+    {
+      h(int(cs.origins.size()));
+    }
+    h.bodies(10, rc.bodyPosTargets);
+    h.bodies(11, rc.bodyOriTargets);
+    h.bodies(12, rc.forceContactsMin);
+    h.bodies(13, rc.torqueContactsMin);
+    h.bodies(14, rc.normalForceTargets);
+    h.bodies(15, rc.tanForceMin);
+  }
+
+  h(16);
+  h(int(robotLinks.size()));
+  for(const RobotLink& rl: robotLinks)
+  {
+    h(rl.robot1Index);
+    h(rl.robot2Index);
+    h.bodies(17, rl.linkedBodies);
+  }
+  return h.hash();
+}
+
+
+/// Append values to a features vector.
+class Features
+{
+public:
+  void operator()(double v)
+  {
+    values_.push_back(v);
+  }
+
+  template<typename Derived>
+  void operator()(const Eigen::MatrixBase<Derived>& m)
+  {
+    for(int i = 0; i < m.rows(); ++i)
+    {
+      for(int j = 0; j < m.cols(); ++j)
+      {
+        values_.push_back(m(i, j));
+      }
+    }
+  }
+
+  void operator()(const sva::PTransformd& t)
+  {
+    (*this)(t.rotation());
+    (*this)(t.translation());
+  }
+
+  Eigen::VectorXd vector() const
+  {
+    return Eigen::Map<const Eigen::VectorXd>(values_.data(), int(values_.size()));
+  }
+
+private:
+  std::vector<double> values_;
+};
+
+
+Eigen::VectorXd PostureDatabase::features(const std::vector<RobotConfig>& robotConfigs,
+                                          const std::vector<RobotLink>& robotLinks,
+                                          const std::vector<RunConfig>& runConfigs)
+{
+  Features f;
+  for(std::size_t i = 0; i < robotConfigs.size(); ++i)
+  {
+    const RobotConfig& rc = robotConfigs[i];
+    for(const FixedPositionContact& c: rc.fixedPosContacts)
+    {
+      f(c.target);
+    }
+    for(const FixedOrientationContact& c: rc.fixedOriContacts)
+    {
+      f(c.target);
+    }
+    for(const PlanarContact& c: rc.planarContacts)
+    {
+      f(c.targetFrame);
+    }
+    for(const EllipseContact& c: rc.ellipseContacts)
+    {
+      f(c.targetFrame);
+    }
+    for(const GripperContact& c: rc.gripperContacts)
+    {
+      f(c.targetFrame);
+    }
+    for(const CylindricalContact& c: rc.cylindricalContacts)
+    {
+      f(c.targetFrame);
+      f(c.targetRadius);
+      f(c.targetWidth);
+    }
+    for(const EnvCollision& c: rc.envCollisions)
+    {
+      f(c.minDist);
+    }
+    for(const SelfCollision& c: rc.selfCollisions)
+    {
+      f(c.minDist);
+    }
+    for(const CoMHalfSpace& c: rc.comHalfSpaces)
+    {
+      for(const Eigen::Vector3d& o: c.origins)
+      {
+        f(o);
+      }
+      for(const Eigen::Vector3d& n: c.normals)
+      {
+        f(n);
+      }
+    }
+
+    for(const BodyPositionTarget& t: rc.bodyPosTargets)
+    {
+      f(t.target);
+    }
+    for(const BodyOrientationTarget& t: rc.bodyOriTargets)
+    {
+      f(t.target);
+    }
+    for(const TorqueContactMinimization& t: rc.torqueContactsMin)
+    {
+      f(t.origin);
+      f(t.axis);
+    }
+    for(const NormalForceTarget& t: rc.normalForceTargets)
+    {
+      f(t.target);
+    }
+
+    // the posture target is only used with a posture cost
+    if(i < runConfigs.size() && rc.postureScale > 0.)
+    {
+      for(const std::vector<double>& q: runConfigs[i].targetQ)
+      {
+        for(double v: q)
+        {
+          f(v);
+        }
+      }
+    }
+  }
+
+  for(const RobotLink& rl: robotLinks)
+  {
+    for(const BodyLink& bl: rl.linkedBodies)
+    {
+      f(bl.body1T);
+      f(bl.body2T);
+    }
+  }
+  return f.vector();
+}
+
+
+/*
+ *   PostureDatabase
+ */
+
+
+PostureDatabase::Group::Group()
+  : entries()
+  , nodes()
+  , nrIndexed(0)
+{}
+
+
+PostureDatabase::PostureDatabase()
+  : entries_()
+  , groups_()
+  , owned_()
+  , fd_(-1)
+  , map_(nullptr)
+  , mapSize_(0)
+  , out_()
+{}
+
+
+PostureDatabase::PostureDatabase(const std::string& file)
+  : PostureDatabase()
+{
+  map(file);
+}
+
+
+PostureDatabase::~PostureDatabase()
+{
+  if(map_)
+  {
+    munmap(const_cast<char*>(map_), mapSize_);
+  }
+  if(fd_ != -1)
+  {
+    close(fd_);
+  }
+}
+
+
+void PostureDatabase::add(std::uint64_t signature, const Eigen::VectorXd& features,
+                          const Eigen::VectorXd& x)
+{
+  owned_.emplace_back(features.size() + x.size());
+  std::vector<double>& data = owned_.back();
+  std::copy(features.data(), features.data() + features.size(), data.begin());
+  std::copy(x.data(), x.data() + x.size(), data.begin() + features.size());
+  index(insert({signature, data.data(), int(features.size()),
+                data.data() + features.size(), int(x.size())}));
+
+  if(out_.is_open())
+  {
+    std::uint32_t nrFeatures = std::uint32_t(features.size());
+    std::uint32_t xSize = std::uint32_t(x.size());
+    out_.write(reinterpret_cast<const char*>(&signature), sizeof(std::uint64_t));
+    out_.write(reinterpret_cast<const char*>(&nrFeatures), sizeof(std::uint32_t));
+    out_.write(reinterpret_cast<const char*>(&xSize), sizeof(std::uint32_t));
+    out_.write(reinterpret_cast<const char*>(data.data()), sizeof(double)*data.size());
+    out_.flush();
+    if(!out_)
+    {
+      throw std::runtime_error("Can't write posture database entry");
+    }
+  }
+}
+
+
+std::vector<PostureDatabase::Neighbor>
+PostureDatabase::nearest(std::uint64_t signature, const Eigen::VectorXd& features,
+                         int k) const
+{
+  std::vector<Neighbor> heap;
+  auto it = groups_.find(GroupKey(signature, int(features.size())));
+  if(it == groups_.end() || k <= 0)
+  {
+    return heap;
+  }
+  const Group& group = it->second;
+
+  // the entries not indexed yet are searched linearly
+  if(!group.nodes.empty())
+  {
+    search(group, 0, features, std::size_t(k), heap);
+  }
+  for(std::size_t i = std::size_t(group.nrIndexed); i < group.entries.size(); ++i)
+  {
+    int entry = group.entries[i];
+    push(heap, std::size_t(k), {entry, distance(entry, features)});
+  }
+
+  std::sort_heap(heap.begin(), heap.end(),
+    [](const Neighbor& a, const Neighbor& b) {return a.distance < b.distance;});
+  return heap;
+}
+
+
+std::uint64_t PostureDatabase::entrySignature(int entry) const
+{
+  return entries_.at(entry).signature;
+}
+
+
+Eigen::Map<const Eigen::VectorXd> PostureDatabase::entryFeatures(int entry) const
+{
+  const Entry& e = entries_.at(entry);
+  return Eigen::Map<const Eigen::VectorXd>(e.features, e.nrFeatures);
+}
+
+
+Eigen::Map<const Eigen::VectorXd> PostureDatabase::entryX(int entry) const
+{
+  const Entry& e = entries_.at(entry);
+  return Eigen::Map<const Eigen::VectorXd>(e.x, e.xSize);
+}
+
+
+void PostureDatabase::map(const std::string& file)
+{
+  fd_ = open(file.c_str(), O_RDONLY);
+  struct stat st;
+  if(fd_ != -1 && fstat(fd_, &st) == 0 && st.st_size > 0)
+  {
+    mapSize_ = std::size_t(st.st_size);
+    void* m = mmap(nullptr, mapSize_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if(m == MAP_FAILED)
+    {
+      throw std::runtime_error("Can't map posture database " + file);
+    }
+    map_ = static_cast<const char*>(m);
+
+    if(mapSize_ < databaseHeaderSize ||
+       std::memcmp(map_, databaseFileMagic, 4) != 0 ||
+       *reinterpret_cast<const std::uint32_t*>(map_ + 4) != databaseFileVersion)
+    {
+      throw std::runtime_error(file + " is not a posture database");
+    }
+
+    // features and x are used in place, the header sizes keep them aligned
+    std::size_t pos = databaseHeaderSize;
+    while(pos + entryHeaderSize <= mapSize_)
+    {
+      Entry e;
+      std::uint32_t nrFeatures, xSize;
+      std::memcpy(&e.signature, map_ + pos, sizeof(std::uint64_t));
+      std::memcpy(&nrFeatures, map_ + pos + 8, sizeof(std::uint32_t));
+      std::memcpy(&xSize, map_ + pos + 12, sizeof(std::uint32_t));
+      std::size_t end = pos + entryHeaderSize +
+        sizeof(double)*(std::size_t(nrFeatures) + xSize);
+      if(end > mapSize_)
+      {
+        break;
+      }
+      e.features = reinterpret_cast<const double*>(map_ + pos + entryHeaderSize);
+      e.nrFeatures = int(nrFeatures);
+      e.x = e.features + nrFeatures;
+      e.xSize = int(xSize);
+      pos = end;
+      insert(e);
+    }
+    for(auto& g: groups_)
+    {
+      index(g.second);
+    }
+
+    // an interrupted add leave an incomplete entry at the end of the file,
+    // it's removed so the next entries are appended after the complete ones
+    if(pos < mapSize_ && truncate(file.c_str(), off_t(pos)) != 0)
+    {
+      throw std::runtime_error("Can't truncate posture database " + file);
+    }
+
+    out_.open(file, std::ios::binary | std::ios::app);
+  }
+  else
+  {
+    out_.open(file, std::ios::binary | std::ios::trunc);
+    out_.write(databaseFileMagic, 4);
+    out_.write(reinterpret_cast<const char*>(&databaseFileVersion), sizeof(std::uint32_t));
+    out_.flush();
+  }
+
+  if(!out_)
+  {
+    throw std::runtime_error("Can't open posture database " + file);
+  }
+}
+
+
+PostureDatabase::Group& PostureDatabase::insert(const Entry& e)
+{
+  entries_.push_back(e);
+  Group& group = groups_[GroupKey(e.signature, e.nrFeatures)];
+  group.entries.push_back(int(entries_.size()) - 1);
+  return group;
+}
+
+
+void PostureDatabase::index(Group& group)
+{
+  // the entries added since the last build are searched linearly
+  // until they are numerous enough to rebuild the tree
+  int nrPending = int(group.entries.size()) - group.nrIndexed;
+  if(nrPending > std::max(32, group.nrIndexed/8))
+  {
+    group.nodes.clear();
+    std::vector<int> entries(group.entries);
+    build(group, entries, 0, int(entries.size()));
+    group.nrIndexed = int(entries.size());
+  }
+}
+
+
+double PostureDatabase::distance(int entry, const Eigen::VectorXd& features) const
+{
+  const Entry& e = entries_[entry];
+  return (Eigen::Map<const Eigen::VectorXd>(e.features, e.nrFeatures) - features).norm();
+}
+
+
+int PostureDatabase::build(Group& group, std::vector<int>& entries,
+                           int begin, int end) const
+{
+  if(begin >= end)
+  {
+    return -1;
+  }
+
+  // split on the dimension with the largest spread
+  int nrFeatures = entries_[entries[begin]].nrFeatures;
+  int dim = 0;
+  double bestSpread = -1.;
+  for(int d = 0; d < nrFeatures; ++d)
+  {
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -lo;
+    for(int i = begin; i < end; ++i)
+    {
+      double v = entries_[entries[i]].features[d];
+      lo = std::min(lo, v);
+      hi = std::max(hi, v);
+    }
+    if(hi - lo > bestSpread)
+    {
+      bestSpread = hi - lo;
+      dim = d;
+    }
+  }
+
+  int mid = begin + (end - begin)/2;
+  std::nth_element(entries.begin() + begin, entries.begin() + mid, entries.begin() + end,
+    [this, dim](int a, int b) {return entries_[a].features[dim] < entries_[b].features[dim];});
+
+  int node = int(group.nodes.size());
+  group.nodes.push_back({entries[mid], dim, -1, -1});
+  int left = build(group, entries, begin, mid);
+  int right = build(group, entries, mid + 1, end);
+  group.nodes[node].left = left;
+  group.nodes[node].right = right;
+  return node;
+}
+
+
+void PostureDatabase::search(const Group& group, int node,
+                             const Eigen::VectorXd& features, std::size_t k,
+                             std::vector<Neighbor>& heap) const
+{
+  if(node == -1)
+  {
+    return;
+  }
+
+  const Node& n = group.nodes[node];
+  push(heap, k, {n.entry, distance(n.entry, features)});
+
+  double diff = features[n.dim] - entries_[n.entry].features[n.dim];
+  int near = diff < 0. ? n.left : n.right;
+  int far = diff < 0. ? n.right : n.left;
+  search(group, near, features, k, heap);
+  // the far side can only contain nearer entries if the splitting plane
+  // is nearer than the current k-th neighbor
+  if(heap.size() < k || std::abs(diff) < heap.front().distance)
+  {
+    search(group, far, features, k, heap);
+  }
+}
+
+
+void PostureDatabase::push(std::vector<Neighbor>& heap, std::size_t k, const Neighbor& n)
+{
+  // max-heap on the distance, front is the farthest neighbor
+  auto cmp = [](const Neighbor& a, const Neighbor& b) {return a.distance < b.distance;};
+  if(heap.size() < k)
+  {
+    heap.push_back(n);
+    std::push_heap(heap.begin(), heap.end(), cmp);
+  }
+  else if(n.distance < heap.front().distance)
+  {
+    std::pop_heap(heap.begin(), heap.end(), cmp);
+    heap.back() = n;
+    std::push_heap(heap.begin(), heap.end(), cmp);
+  }
+}
+
+
+} // pg
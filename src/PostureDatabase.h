@@ -0,0 +1,162 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// PG
+#include "ConfigStruct.h"
+
+
+namespace pg
+{
+
+/**
+  * Solved problems indexed by their contact layout signature and their
+  * features (targets and posture targets), queried for the solutions
+  * of the nearest problems to warm start a new run.
+  * Each signature has its own KD-tree on the features, updated by add.
+  * nearest can be called concurrently, but not during an add.
+  *
+  * A database can be persistent: its file is memory-mapped when opened and
+  * the new entries are appended to it.
+  * File format (native endianness): "PGDB", uint32 version, then for each
+  * entry: uint64 signature, uint32 features size, uint32 x size,
+  * features and x doubles.
+  * An incomplete last entry, left by an interrupted add, is removed
+  * from the file when it is opened.
+  */
+class PostureDatabase
+{
+public:
+  struct Neighbor
+  {
+    int entry;
+    double distance;
+  };
+
+public:
+  /// Database in memory only.
+  PostureDatabase();
+  /**
+    * Open or create a persistent database.
+    * @throw std::runtime_error if file can't be opened or is not a database.
+    */
+  PostureDatabase(const std::string& file);
+  ~PostureDatabase();
+
+  PostureDatabase(const PostureDatabase&) = delete;
+  PostureDatabase& operator=(const PostureDatabase&) = delete;
+
+  /// Hash of the robots structure, constraints and costs kind and bodies.
+  /// Problems with the same signature have the same variables and features.
+  static std::uint64_t signature(const std::vector<RobotConfig>& robotConfigs,
+                                 const std::vector<RobotLink>& robotLinks);
+  /**
+    * Contacts and links targets, costs targets and posture targets.
+    * Costs scales are not features, they would dominate the distance.
+    */
+  static Eigen::VectorXd features(const std::vector<RobotConfig>& robotConfigs,
+                                  const std::vector<RobotLink>& robotLinks,
+                                  const std::vector<RunConfig>& runConfigs);
+
+  /// Add a solution x (PostureGenerator variables).
+  /// @throw std::runtime_error if the entry can't be written in the file.
+  void add(std::uint64_t signature, const Eigen::VectorXd& features,
+           const Eigen::VectorXd& x);
+
+  /// At most k entries of signature, from the nearest to the farthest.
+  std::vector<Neighbor> nearest(std::uint64_t signature,
+                                const Eigen::VectorXd& features, int k) const;
+
+  int size() const
+  {
+    return int(entries_.size());
+  }
+
+  std::uint64_t entrySignature(int entry) const;
+  Eigen::Map<const Eigen::VectorXd> entryFeatures(int entry) const;
+  Eigen::Map<const Eigen::VectorXd> entryX(int entry) const;
+
+private:
+  /// Features and x point in the mapped file or in owned_.
+  struct Entry
+  {
+    std::uint64_t signature;
+    const double* features;
+    int nrFeatures;
+    const double* x;
+    int xSize;
+  };
+
+  struct Node
+  {
+    int entry;
+    int dim;
+    int left, right;
+  };
+
+  /// Entries of a signature.
+  struct Group
+  {
+    Group();
+
+    std::vector<int> entries;
+    /// KD-tree on the nrIndexed first entries, root is nodes[0].
+    std::vector<Node> nodes;
+    int nrIndexed;
+  };
+
+  typedef std::pair<std::uint64_t, int> GroupKey;
+
+private:
+  void map(const std::string& file);
+  /// @return Group of e.
+  Group& insert(const Entry& e);
+  /// Rebuild the KD-tree of group if too many entries are not indexed.
+  void index(Group& group);
+  double distance(int entry, const Eigen::VectorXd& features) const;
+  /// Build the KD-tree of group on entries[begin, end), @return root node.
+  int build(Group& group, std::vector<int>& entries, int begin, int end) const;
+  void search(const Group& group, int node, const Eigen::VectorXd& features,
+              std::size_t k, std::vector<Neighbor>& heap) const;
+  static void push(std::vector<Neighbor>& heap, std::size_t k, const Neighbor& n);
+
+private:
+  std::vector<Entry> entries_;
+  /// Groups are keyed by signature and features size.
+  std::map<GroupKey, Group> groups_;
+  /// Memory of the entries added since the file opening.
+  std::deque<std::vector<double>> owned_;
+
+  int fd_;
+  const char* map_;
+  std::size_t mapSize_;
+  std::ofstream out_;
+};
+
+} // namespace pg
@@ -17,6 +17,16 @@
 #include "PostureGenerator.h"
 
 // include
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
 // roboptim
 #include <roboptim/core/solver-factory.hh>
 
@@ -27,6 +37,7 @@
 // PG
 #include "ConfigStruct.h"
 #include "PGData.h"
+#include "PGDataGroup.h"
 #include "StdCostFunc.h"
 #include "FixedContactConstr.h"
 #include "StaticStabilityConstr.h"
@@ -40,44 +51,62 @@
 #include "CylindricalSurfaceConstr.h"
 #include "IterationCallback.h"
 #include "CoMHalfSpaceConstr.h"
+#include "ModelReduction.h"
+#include "EquilibriumForces.h"
+#include "LevenbergMarquardt.h"
+#include "LeastSquaresCostFunc.h"
+#include "SolverBackend.h"
+#include "Profiler.h"
+#include "Tracer.h"
+#include "ProblemCapture.h"
+#include "PostureDatabase.h"
+#include "Sensitivity.h"
 
 namespace pg
 {
 
-/// Visitor to take the x component of the result
-struct ResultVisitor : public boost::static_visitor<>
-{
-  void operator()(const roboptim::Result& res)
-  {
-    x = res.x;
-  }
-
-  void operator()(const roboptim::ResultWithWarnings& res)
-  {
-    x = res.x;
-  }
-
-  template <typename T>
-  void operator()(const T& /* res */)
-  {
-    throw std::runtime_error("This result type is not handled !");
-  }
-
-  Eigen::VectorXd x;
-};
-
+PostureGenerator::Options::Options()
+  : params()
+  , parallelUpdate(false)
+  , modelReduction(false)
+  , contactProjection(0)
+  , engine(IpoptEngine)
+  , backend()
+  , deadline(0.)
+  , maxIter(0)
+  , recording()
+  , profiling(false)
+  , tracing(false)
+{}
 
 
 PostureGenerator::PostureGenerator()
   : pgdatas_()
   , robotConfigs_()
+  , options_()
+  , usedEngine_(IpoptEngine)
+  , selection_(NoResult)
+  , profile_()
+  , tracer_()
+  , database_()
+  , nrNeighbors_(1)
+  , databaseAdd_(true)
+  , warmStartEntry_(-1)
+  , reachabilityMaps_()
+  , rejectUnreachable_(false)
+  , unreachable_()
+  , sensitivityParams_()
+  , sensitivity_()
+  , trackProblem_()
   , iters_(new iteration_callback_t)
+  , asyncRun_()
 {}
 
 
 void PostureGenerator::robotConfigs(std::vector<RobotConfig> robotConfigs,
   const Eigen::Vector3d& gravity)
 {
+  trackProblem_.reset();
   robotConfigs_.clear();
   pgdatas_.clear();
   robotConfigs_.reserve(robotConfigs.size());
@@ -126,6 +155,7 @@ const std::vector<RobotConfig>& PostureGenerator::robotConfigs() const
 void PostureGenerator::robotLinks(std::vector<RobotLink> robotLinks)
 {
   robotLinks_ = std::move(robotLinks);
+  trackProblem_.reset();
 }
 
 
@@ -137,75 +167,475 @@ const std::vector<RobotLink>& PostureGenerator::robotLinks() const
 
 void PostureGenerator::param(const std::string& name, const std::string& value)
 {
-  params_[name].value = value;
+  options_.params[name].value = value;
 }
 
 
 void PostureGenerator::param(const std::string& name, double value)
 {
-  params_[name].value = value;
+  options_.params[name].value = value;
 }
 
 
 void PostureGenerator::param(const std::string& name, int value)
 {
-  params_[name].value = value;
+  options_.params[name].value = value;
 }
 
 
-bool PostureGenerator::run(const std::vector<RunConfig>& configs)
+void PostureGenerator::options(Options o)
 {
-  StdCostFunc cost(pgdatas_, robotConfigs_, configs);
+  if(o.engine == CustomEngine && !o.backend)
+  {
+    throw std::domain_error("CustomEngine needs a backend");
+  }
+  options_ = std::move(o);
+}
 
-  solver_t::problem_t problem(cost);
-  problem.startingPoint() = Eigen::VectorXd::Zero(pgdatas_[0].pbSize());
 
-  for(std::size_t robotIndex = 0; robotIndex < robotConfigs_.size(); ++robotIndex)
+const PostureGenerator::Options& PostureGenerator::options() const
+{
+  return options_;
+}
+
+
+void PostureGenerator::parallelUpdate(bool parallel)
+{
+  options_.parallelUpdate = parallel;
+}
+
+
+bool PostureGenerator::parallelUpdate() const
+{
+  return options_.parallelUpdate;
+}
+
+
+void PostureGenerator::modelReduction(bool reduce)
+{
+  options_.modelReduction = reduce;
+}
+
+
+bool PostureGenerator::modelReduction() const
+{
+  return options_.modelReduction;
+}
+
+
+void PostureGenerator::contactProjection(int nrIter)
+{
+  options_.contactProjection = nrIter;
+}
+
+
+int PostureGenerator::contactProjection() const
+{
+  return options_.contactProjection;
+}
+
+
+void PostureGenerator::engine(Engine e)
+{
+  if(e == CustomEngine && !options_.backend)
   {
-    const RobotConfig& robotConfig = robotConfigs_[robotIndex];
-    const RunConfig& config = configs[robotIndex];
-    PGData& pgdata = pgdatas_[robotIndex];
+    throw std::domain_error("CustomEngine needs a backend");
+  }
+  options_.engine = e;
+}
 
-    problem.startingPoint()->segment(pgdata.qParamsBegin(), pgdata.mb().nrParams()) =
-      rbd::paramToVector(pgdata.multibody(), config.initQ);
-    // run forward kinematics to compute initial force
-    pgdata.updateKinematics(config.initQ);
 
-    // if init force is not well sized we compute it
-    if(int(config.initForces.size()) != pgdata.nrForcePoints())
+PostureGenerator::Engine PostureGenerator::engine() const
+{
+  return options_.engine;
+}
+
+
+void PostureGenerator::backend(boost::shared_ptr<SolverBackend> backend)
+{
+  options_.backend = std::move(backend);
+  options_.engine = options_.backend ? CustomEngine : IpoptEngine;
+}
+
+
+boost::shared_ptr<SolverBackend> PostureGenerator::backend() const
+{
+  return options_.backend;
+}
+
+
+PostureGenerator::Engine PostureGenerator::usedEngine() const
+{
+  return usedEngine_;
+}
+
+
+void PostureGenerator::deadline(double seconds)
+{
+  options_.deadline = seconds;
+}
+
+
+double PostureGenerator::deadline() const
+{
+  return options_.deadline;
+}
+
+
+void PostureGenerator::maxIterations(int nrIter)
+{
+  options_.maxIter = nrIter;
+}
+
+
+int PostureGenerator::maxIterations() const
+{
+  return options_.maxIter;
+}
+
+
+PostureGenerator::ResultSelection PostureGenerator::resultSelection() const
+{
+  return selection_;
+}
+
+
+void PostureGenerator::iterateRecording(IterateRecording recording)
+{
+  options_.recording = std::move(recording);
+}
+
+
+const IterateRecording& PostureGenerator::iterateRecording() const
+{
+  return options_.recording;
+}
+
+
+void PostureGenerator::profiling(bool profile)
+{
+  options_.profiling = profile;
+}
+
+
+bool PostureGenerator::profiling() const
+{
+  return options_.profiling;
+}
+
+
+const Profile& PostureGenerator::profile() const
+{
+  return profile_;
+}
+
+
+void PostureGenerator::tracing(bool trace)
+{
+  options_.tracing = trace;
+}
+
+
+bool PostureGenerator::tracing() const
+{
+  return options_.tracing;
+}
+
+
+void PostureGenerator::traceCapacity(int capacity)
+{
+  tracer_.laneCapacity(capacity);
+}
+
+
+int PostureGenerator::traceCapacity() const
+{
+  return tracer_.laneCapacity();
+}
+
+
+const Tracer& PostureGenerator::tracer() const
+{
+  return tracer_;
+}
+
+
+void PostureGenerator::postureDatabase(boost::shared_ptr<PostureDatabase> db,
+                                       int nrNeighbors, bool add)
+{
+  database_ = db;
+  nrNeighbors_ = nrNeighbors;
+  databaseAdd_ = add;
+}
+
+
+boost::shared_ptr<PostureDatabase> PostureGenerator::postureDatabase() const
+{
+  return database_;
+}
+
+
+int PostureGenerator::warmStartEntry() const
+{
+  return warmStartEntry_;
+}
+
+
+void PostureGenerator::reachabilityMaps(std::vector<std::vector<ReachabilityMap>> maps,
+                                        bool reject)
+{
+  reachabilityMaps_ = std::move(maps);
+  rejectUnreachable_ = reject;
+}
+
+
+const std::vector<std::vector<ReachabilityMap>>&
+PostureGenerator::reachabilityMaps() const
+{
+  return reachabilityMaps_;
+}
+
+
+const std::vector<UnreachableContact>& PostureGenerator::unreachableContacts() const
+{
+  return unreachable_;
+}
+
+
+void PostureGenerator::sensitivityParameters(std::vector<TargetParameter> params)
+{
+  for(const TargetParameter& param: params)
+  {
+    parameterSize(robotConfigs_, param);
+  }
+  sensitivityParams_ = std::move(params);
+}
+
+
+const std::vector<TargetParameter>& PostureGenerator::sensitivityParameters() const
+{
+  return sensitivityParams_;
+}
+
+
+const Eigen::MatrixXd& PostureGenerator::sensitivity() const
+{
+  return sensitivity_;
+}
+
+
+Eigen::MatrixXd PostureGenerator::qSensitivity(int robot) const
+{
+  const PGData& pgdata = pgdatas_.at(robot);
+  if(sensitivity_.size() == 0)
+  {
+    return Eigen::MatrixXd();
+  }
+  return sensitivity_.middleRows(pgdata.qParamsBegin(), pgdata.mb().nrParams());
+}
+
+
+/// Functions, solver problem and IPOPT solver of a run, see buildProblem.
+struct PostureGenerator::Problem
+{
+  Problem(std::vector<PGData>& pgdatas, bool parallelUpdate,
+          const std::vector<RobotConfig>& robotConfigs,
+          const std::vector<RunConfig>& configs)
+    : group(pgdatas, parallelUpdate)
+    , cost(pgdatas, robotConfigs, configs)
+    , profiledCost()
+    , problem()
+    , constraints()
+    , projection()
+    , targetRows()
+    , targetSetters()
+    , description()
+    , ipoptFactory()
+  {}
+
+  // must outlive the functions since PGData hooks are bound to the constraints
+  PGDataGroup group;
+  StdCostFunc cost;
+  boost::shared_ptr<roboptim::DifferentiableSparseFunction> profiledCost;
+  boost::shared_ptr<solver_t::problem_t> problem;
+  // constraints are also minimized by the Levenberg-Marquardt engine
+  // and contact constraints are used to project the starting point
+  LevenbergMarquardt constraints, projection;
+  // constraints rows that depend on the sensitivity parameters
+  std::vector<TargetConstraintRow> targetRows;
+  // copy the robotConfigs_ targets in the contact constraints
+  std::vector<std::function<void()>> targetSetters;
+  SolverBackend::Description description;
+  // IPOPT solver of the last solve, it copied problem so it's rebuilt at
+  // each solve but the next one is built first to keep the plugin loaded
+  boost::shared_ptr<roboptim::SolverFactory<solver_t>> ipoptFactory;
+};
+
+
+bool PostureGenerator::track(std::vector<RunConfig>& configs, const Eigen::VectorXd& dp,
+                             int nrCorrectorIter)
+{
+  if(!trackProblem_ || sensitivity_.size() == 0 || sensitivity_.rows() != x_.size())
+  {
+    throw std::logic_error("No sensitivity of the last run");
+  }
+  if(dp.size() != sensitivity_.cols())
+  {
+    throw std::domain_error("Wrong number of target parameters");
+  }
+
+  int col = 0;
+  for(const TargetParameter& param: sensitivityParams_)
+  {
+    int size = parameterSize(robotConfigs_, param);
+    moveTarget(robotConfigs_, configs, param, dp.segment(col, size));
+    col += size;
+  }
+
+  // predictor
+  Eigen::VectorXd x(x_);
+  x.noalias() += sensitivity_*dp;
+  normalizeFreeJoints(x);
+  sensitivity_.resize(0, 0);
+  Problem& pb = *trackProblem_;
+  *pb.problem->startingPoint() = x;
+
+  // corrector on the last run problem, a full run from its result on
+  // failure with the time left on the deadline
+  typedef std::chrono::steady_clock clock;
+  const Options options(options_);
+  clock::time_point start = clock::now();
+  bool success = false;
+  try
+  {
+    options_.maxIter = nrCorrectorIter;
+    success = resolve(pb, configs, false);
+    options_.maxIter = options.maxIter;
+    if(selection_ == Converged)
+    {
+      sensitivity_ = targetSensitivity(pgdatas_, robotConfigs_, configs,
+                                       sensitivityParams_, pb.constraints, pb.targetRows,
+                                       pb.problem->argumentBounds(), x_);
+    }
+    else if(!iters_->deadlineReached)
     {
-      // compute initial force value
-      // this is not really smart but work well
-      // for contacts with N vector against gravity vector
-      double robotMass = pgdata.robotMass();
+      // selected corrector iterate, or the predicted point without one
+      const Eigen::VectorXd& x0 = selection_ != NoResult ? x_ : x;
+      std::vector<RunConfig> corrected(configs);
+      for(std::size_t robotIndex = 0; robotIndex < pgdatas_.size(); ++robotIndex)
+      {
+        corrected[robotIndex].initQ = q(int(robotIndex), x0);
+        corrected[robotIndex].initForces = forces(int(robotIndex), x0);
+      }
 
-      double initialForce = (pgdata.gravity().norm()*robotMass)/pgdata.nrForcePoints();
-      int pos = pgdata.forceParamsBegin();
-      for(const PGData::ForceData& fd: pgdata.forceDatas())
+      double left = options.deadline -
+        std::chrono::duration<double>(clock::now() - start).count();
+      if(options.deadline <= 0. || left > 0.)
       {
-        for(std::size_t i = 0; i < fd.points.size(); ++i)
-        {
-          sva::PTransformd point = fd.points[i]*pgdata.mbc().bodyPosW[fd.bodyIndex];
-          Eigen::Vector3d force(point.rotation().row(2).transpose()*initialForce);
-          (*problem.startingPoint())[pos + 0] = force(0);
-          (*problem.startingPoint())[pos + 1] = force(1);
-          (*problem.startingPoint())[pos + 2] = force(2);
-          pos += 3;
-        }
+        // run release pb when it build its problem
+        options_.deadline = options.deadline > 0. ? left : 0.;
+        success = run(corrected);
       }
-    }
-    else
-    {
-      int pos = pgdata.forceParamsBegin();
-      for(int i = 0; i < pgdata.nrForcePoints(); ++i)
+      else
       {
-        (*problem.startingPoint())[pos + 0] = config.initForces[i].force()[0];
-        (*problem.startingPoint())[pos + 1] = config.initForces[i].force()[1];
-        (*problem.startingPoint())[pos + 2] = config.initForces[i].force()[2];
-        pos += 3;
+        iters_->deadlineReached = true;
       }
     }
+  }
+  catch(...)
+  {
+    options_ = options;
+    throw;
+  }
+  options_ = options;
+  return success;
+}
+
+
+boost::shared_ptr<PostureGenerator::Problem>
+PostureGenerator::buildProblem(const std::vector<RunConfig>& configs)
+{
+  // destroying a problem unbind pgdatas_, only one can exist
+  trackProblem_.reset();
+  boost::shared_ptr<Problem> pbPtr(
+    new Problem(pgdatas_, options_.parallelUpdate, robotConfigs_, configs));
+  Problem& pb = *pbPtr;
+
+  if(options_.profiling)
+  {
+    profile_.robots.resize(pgdatas_.size());
+  }
+  // functions are evaluated on the solver thread (lane 0) and robots
+  // are updated on their own thread with parallelUpdate
+  TraceBuffer* solverTrace = options_.tracing ? tracer_.lane(0) : nullptr;
+  auto robotTrace = [this](std::size_t robotIndex) -> TraceBuffer*
+  {
+    return options_.tracing ? tracer_.lane(options_.parallelUpdate ? int(robotIndex) : 0) : nullptr;
+  };
+  for(std::size_t robotIndex = 0; robotIndex < pgdatas_.size(); ++robotIndex)
+  {
+    pgdatas_[robotIndex].profile(options_.profiling ? &profile_.robots[robotIndex].fk : nullptr,
+                                 robotTrace(robotIndex));
+  }
+
+  // wrap a function to profile and trace its evaluations
+  Profile* functionsProfile = options_.profiling ? &profile_ : nullptr;
+  auto instrument = [this, functionsProfile, solverTrace](
+    boost::shared_ptr<roboptim::DifferentiableSparseFunction> f)
+  {
+    int name = solverTrace ? tracer_.name(f->getName()) : 0;
+    return boost::shared_ptr<roboptim::DifferentiableSparseFunction>(
+      new ProfiledFunction(f, functionsProfile, solverTrace, name));
+  };
+
+  if(options_.profiling || options_.tracing)
+  {
+    pb.profiledCost = instrument(boost::shared_ptr<roboptim::DifferentiableSparseFunction>(
+        &pb.cost, [](roboptim::DifferentiableSparseFunction*){}));
+  }
+
+  pb.problem.reset(new solver_t::problem_t(pb.profiledCost ? *pb.profiledCost :
+    static_cast<const roboptim::DifferentiableSparseFunction&>(pb.cost)));
+  solver_t::problem_t& problem = *pb.problem;
+  problem.startingPoint() = Eigen::VectorXd::Zero(pgdatas_[0].pbSize());
+
+  LevenbergMarquardt& constraints = pb.constraints;
+  LevenbergMarquardt& projection = pb.projection;
+  std::vector<TargetConstraintRow>& targetRows = pb.targetRows;
+  auto targetRow = [&targetRows, &constraints](TargetParameter::Kind kind,
+    std::size_t robot, std::size_t index, int part)
+  {
+    targetRows.push_back({TargetParameter(kind, int(robot), int(index)), part,
+                          constraints.nrResiduals()});
+  };
+  auto addConstraint = [this, &problem, &constraints, &instrument](
+    boost::shared_ptr<roboptim::DifferentiableSparseFunction> constr,
+    const typename solver_t::problem_t::intervals_t& limits,
+    const typename solver_t::problem_t::scales_t& scales)
+  {
+    if(options_.profiling || options_.tracing)
+    {
+      constr = instrument(constr);
+    }
+    problem.addConstraint(constr, limits, scales);
+    constraints.addFunction(constr, limits);
+  };
+  auto addContactConstraint = [&addConstraint, &projection](
+    boost::shared_ptr<roboptim::DifferentiableSparseFunction> constr,
+    const typename solver_t::problem_t::intervals_t& limits,
+    const typename solver_t::problem_t::scales_t& scales)
+  {
+    addConstraint(constr, limits, scales);
+    projection.addFunction(constr, limits);
+  };
 
+  for(std::size_t robotIndex = 0; robotIndex < robotConfigs_.size(); ++robotIndex)
+  {
+    const RobotConfig& robotConfig = robotConfigs_[robotIndex];
+    PGData& pgdata = pgdatas_[robotIndex];
+    ProfileCounter* collisionProf =
+      options_.profiling ? &profile_.robots[robotIndex].collision : nullptr;
+    TraceBuffer* collisionTrace = robotTrace(robotIndex);
 
     for(std::size_t i = 0; i < robotConfig.ql.size(); ++i)
     {
@@ -217,8 +647,9 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
       }
     }
 
-    for(const FixedPositionContact& fc: robotConfig.fixedPosContacts)
+    for(std::size_t i = 0; i < robotConfig.fixedPosContacts.size(); ++i)
     {
+      const FixedPositionContact& fc = robotConfig.fixedPosContacts[i];
       int bodyIndex = pgdata.mb().bodyIndexById(fc.bodyId);
       // if the root body is a fixed contact and the root joint is fixed
       // this constraint is useless
@@ -226,13 +657,17 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
       {
         boost::shared_ptr<FixedPositionContactConstr> fcc(
             new FixedPositionContactConstr(&pgdata, fc.bodyId, fc.target, fc.surfaceFrame));
-        problem.addConstraint(fcc, {{0., 0.}, {0., 0.}, {0., 0.}},
+        targetRow(TargetParameter::FixedPosition, robotIndex, i, 0);
+        addContactConstraint(fcc, {{0., 0.}, {0., 0.}, {0., 0.}},
             {{1.}, {1.}, {1.}});
+        pb.targetSetters.push_back([this, fcc, robotIndex, i]()
+          {fcc->target(robotConfigs_[robotIndex].fixedPosContacts[i].target);});
       }
     }
 
-    for(const FixedOrientationContact& fc: robotConfig.fixedOriContacts)
+    for(std::size_t i = 0; i < robotConfig.fixedOriContacts.size(); ++i)
     {
+      const FixedOrientationContact& fc = robotConfig.fixedOriContacts[i];
       int bodyIndex = pgdata.mb().bodyIndexById(fc.bodyId);
       // if the root body is a fixed contact and the root joint is fixed
       // this constraint is useless
@@ -240,13 +675,17 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
       {
         boost::shared_ptr<FixedOrientationContactConstr> fcc(
             new FixedOrientationContactConstr(&pgdata, fc.bodyId, fc.target, fc.surfaceFrame));
-        problem.addConstraint(fcc, {{1., 1.}, {1., 1.}, {1., 1.}},
+        targetRow(TargetParameter::FixedOrientation, robotIndex, i, 0);
+        addContactConstraint(fcc, {{1., 1.}, {1., 1.}, {1., 1.}},
             {{1e+1}, {1e+1}, {1e+1}});
+        pb.targetSetters.push_back([this, fcc, robotIndex, i]()
+          {fcc->target(robotConfigs_[robotIndex].fixedOriContacts[i].target);});
       }
     }
 
-    for(const PlanarContact& pc: robotConfig.planarContacts)
+    for(std::size_t i = 0; i < robotConfig.planarContacts.size(); ++i)
     {
+      const PlanarContact& pc = robotConfig.planarContacts[i];
       int bodyIndex = pgdata.mb().bodyIndexById(pc.bodyId);
       // if the root body is a planar contact and the root joint is a planar joint
       // we don't need to add planar position and orientation constraint
@@ -254,16 +693,24 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
       {
         boost::shared_ptr<PlanarPositionContactConstr> ppc(
             new PlanarPositionContactConstr(&pgdata, pc.bodyId, pc.targetFrame, pc.surfaceFrame));
-        problem.addConstraint(ppc, {{0., 0.}}, {{1.}});
+        targetRow(TargetParameter::PlanarFrame, robotIndex, i, 0);
+        addContactConstraint(ppc, {{0., 0.}}, {{1.}});
 
         // N axis must be aligned between target and surface frame.
         boost::shared_ptr<PlanarOrientationContactConstr> poc(
             new PlanarOrientationContactConstr(&pgdata, pc.bodyId,
                                                pc.targetFrame, pc.surfaceFrame,
                                                2));
-        problem.addConstraint(poc, {{0., std::numeric_limits<double>::infinity()},
-                                    {0., 0.}, {0., 0.}},
-                                   {{1.}, {1.}, {1.}});
+        targetRow(TargetParameter::PlanarFrame, robotIndex, i, 1);
+        addContactConstraint(poc, {{0., std::numeric_limits<double>::infinity()},
+                                   {0., 0.}, {0., 0.}},
+                                  {{1.}, {1.}, {1.}});
+        pb.targetSetters.push_back([this, ppc, poc, robotIndex, i]()
+        {
+          const sva::PTransformd& frame = robotConfigs_[robotIndex].planarContacts[i].targetFrame;
+          ppc->targetFrame(frame);
+          poc->targetFrame(frame);
+        });
       }
 
       // add planar inclusion only if there is points in both surfaces
@@ -276,7 +723,9 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
         typename PlanarInclusionConstr::intervals_t limInc(
               pic->outputSize(), {0., std::numeric_limits<double>::infinity()});
         typename solver_t::problem_t::scales_t scalInc(pic->outputSize(), 1.);
-        problem.addConstraint(pic, limInc, scalInc);
+        addConstraint(pic, limInc, scalInc);
+        pb.targetSetters.push_back([this, pic, robotIndex, i]()
+          {pic->targetFrame(robotConfigs_[robotIndex].planarContacts[i].targetFrame);});
       }
     }
 
@@ -323,12 +772,12 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
     {
       boost::shared_ptr<PlanarPositionContactConstr> ppc(
           new PlanarPositionContactConstr(&pgdata, gc.bodyId, gc.targetFrame, gc.surfaceFrame));
-      problem.addConstraint(ppc, {{0., 0.}}, {{1.}});
+      addContactConstraint(ppc, {{0., 0.}}, {{1.}});
 
       boost::shared_ptr<FixedOrientationContactConstr> focc(
           new FixedOrientationContactConstr(&pgdata, gc.bodyId,
                                             gc.targetFrame.rotation(), gc.surfaceFrame));
-      problem.addConstraint(focc, {{1., 1.}, {1., 1.}, {1., 1.}},
+      addContactConstraint(focc, {{1., 1.}, {1., 1.}, {1., 1.}},
           {{1e+1}, {1e+1}, {1e+1}});
 
       boost::shared_ptr<PlanarInclusionConstr> pic(
@@ -338,7 +787,7 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
       typename PlanarInclusionConstr::intervals_t limInc(
             pic->outputSize(), {0., std::numeric_limits<double>::infinity()});
       typename solver_t::problem_t::scales_t scalInc(pic->outputSize(), 1.);
-      problem.addConstraint(pic, limInc, scalInc);
+      addConstraint(pic, limInc, scalInc);
     }
 
     for(const CylindricalContact& pc: robotConfig.cylindricalContacts)
@@ -353,18 +802,18 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
         boost::shared_ptr<CylindricalPositionConstr> fgpc(
             new CylindricalPositionConstr(&pgdata, pc.bodyId, pc.targetFrame,
                                           radiusX*pc.surfaceFrame));
-        problem.addConstraint(fgpc, {{-pc.targetWidth/2., pc.targetWidth/2.},
-                                     {0., 0.}, {0., 0.}},
-                                     {{1.}, {1.}, {1.}});
+        addContactConstraint(fgpc, {{-pc.targetWidth/2., pc.targetWidth/2.},
+                                    {0., 0.}, {0., 0.}},
+                                    {{1.}, {1.}, {1.}});
 
         // T axis must be aligned between target and surface frame.
         boost::shared_ptr<PlanarOrientationContactConstr> poc(
             new PlanarOrientationContactConstr(&pgdata, pc.bodyId,
                                                pc.targetFrame, pc.surfaceFrame,
                                                0));
-        problem.addConstraint(poc, {{0., std::numeric_limits<double>::infinity()},
-                                    {0., 0.}, {0., 0.}},
-                                    {{1.}, {1.}, {1.}});
+        addContactConstraint(poc, {{0., std::numeric_limits<double>::infinity()},
+                                   {0., 0.}, {0., 0.}},
+                                   {{1.}, {1.}, {1.}});
       }
     }
 
@@ -372,7 +821,9 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
     {
       boost::shared_ptr<StaticStabilityConstr> stab(
           new StaticStabilityConstr(&pgdata));
-      problem.addConstraint(stab, {{0., 0.}, {0., 0.}, {0., 0.}, {0., 0.}, {0., 0.}, {0., 0.}},
+      StaticStabilityConstr* stabPtr = stab.get();
+      pgdata.addUpdateHook([stabPtr](){stabPtr->computeCoM();});
+      addConstraint(stab, {{0., 0.}, {0., 0.}, {0., 0.}, {0., 0.}, {0., 0.}, {0., 0.}},
           {{1e-2}, {1e-2}, {1e-2}, {1e-2}, {1e-2}, {1e-2}});
 
       boost::shared_ptr<PositiveForceConstr> positiveForce(
@@ -380,20 +831,27 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
       typename PositiveForceConstr::intervals_t limPositive(
             pgdata.nrForcePoints(), {0., std::numeric_limits<double>::infinity()});
       typename solver_t::problem_t::scales_t scalPositive(pgdata.nrForcePoints(), 1.);
-      problem.addConstraint(positiveForce, limPositive, scalPositive);
+      addConstraint(positiveForce, limPositive, scalPositive);
 
       boost::shared_ptr<FrictionConeConstr> frictionCone(
           new FrictionConeConstr(&pgdata));
       typename FrictionConeConstr::intervals_t limFriction(
             pgdata.nrForcePoints(), {-std::numeric_limits<double>::infinity(), 0.});
       typename solver_t::problem_t::scales_t scalFriction(pgdata.nrForcePoints(), 1.);
-      problem.addConstraint(frictionCone, limFriction, scalFriction);
+      addConstraint(frictionCone, limFriction, scalFriction);
     }
 
     if(!robotConfig.envCollisions.empty())
     {
       boost::shared_ptr<EnvCollisionConstr> ec(
           new EnvCollisionConstr(&pgdata, robotConfig.envCollisions));
+      EnvCollisionConstr* ecPtr = ec.get();
+      pgdata.addUpdateHook([ecPtr, collisionProf, collisionTrace]()
+      {
+        ScopedProfile prof(collisionProf);
+        ScopedTrace trace(collisionTrace, Tracer::Collision, Tracer::Robot);
+        ecPtr->updateCollisionData();
+      });
       typename EnvCollisionConstr::intervals_t limCol(ec->outputSize());
       for(std::size_t i = 0; i < limCol.size(); ++i)
       {
@@ -401,13 +859,20 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
                      std::numeric_limits<double>::infinity()};
       }
       typename solver_t::problem_t::scales_t scalCol(ec->outputSize(), 1.);
-      problem.addConstraint(ec, limCol, scalCol);
+      addConstraint(ec, limCol, scalCol);
     }
 
     if(!robotConfig.selfCollisions.empty())
     {
       boost::shared_ptr<SelfCollisionConstr> sc(
           new SelfCollisionConstr(&pgdata, robotConfig.selfCollisions));
+      SelfCollisionConstr* scPtr = sc.get();
+      pgdata.addUpdateHook([scPtr, collisionProf, collisionTrace]()
+      {
+        ScopedProfile prof(collisionProf);
+        ScopedTrace trace(collisionTrace, Tracer::Collision, Tracer::Robot);
+        scPtr->updateCollisionData();
+      });
       typename EnvCollisionConstr::intervals_t limCol(sc->outputSize());
       for(std::size_t i = 0; i < limCol.size(); ++i)
       {
@@ -415,7 +880,7 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
                      std::numeric_limits<double>::infinity()};
       }
       typename solver_t::problem_t::scales_t scalCol(sc->outputSize(), 1.);
-      problem.addConstraint(sc, limCol, scalCol);
+      addConstraint(sc, limCol, scalCol);
     }
 
     for(const CoMHalfSpace& fc: robotConfig.comHalfSpaces)
@@ -425,7 +890,7 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
         typename EnvCollisionConstr::intervals_t limCom(
           fcc->outputSize(), {0., std::numeric_limits<double>::infinity()});
         typename solver_t::problem_t::scales_t scalCom(fcc->outputSize(), 1.);
-        problem.addConstraint(fcc, limCom, scalCom);
+        addConstraint(fcc, limCom, scalCom);
     }
 
     /*
@@ -475,12 +940,7 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
       }
     }
     */
-
-    // force PGData to make an update
-    // this avoid that a first call with a x identical to PGData::{xq_,xf_}
-    // don't update PGData
-    pgdata.update();
-  }
+  }
 
   for(const RobotLink& rl: robotLinks_)
   {
@@ -491,44 +951,733 @@ bool PostureGenerator::run(const std::vector<RunConfig>& configs)
     typename solver_t::problem_t::scales_t scale(rlc->outputSize(), 1.);
     for(std::size_t i = 0; i < rl.linkedBodies.size(); ++i)
     {
-      interval[i*6 + 0] = {1., 1.};
-      interval[i*6 + 1] = {1., 1.};
-      interval[i*6 + 2] = {1., 1.};
       scale[i*6 + 0] = 1e+1;
       scale[i*6 + 1] = 1e+1;
       scale[i*6 + 2] = 1e+1;
     }
 
-    problem.addConstraint(rlc, interval, scale);
+    addContactConstraint(rlc, interval, scale);
+  }
+
+  pb.description.problem = &problem;
+  pb.description.constraints = &constraints;
+  if(options_.engine != IpoptEngine && LeastSquaresCostFunc::nrResiduals(robotConfigs_) > 0)
+  {
+    pb.description.cost.reset(new LeastSquaresCostFunc(pgdatas_, robotConfigs_, configs));
+  }
+  pb.description.normalize = [this](Eigen::VectorXd& x) {normalizeFreeJoints(x);};
+
+  return pbPtr;
+}
+
+
+bool PostureGenerator::startingPoint(Problem& pb, const std::vector<RunConfig>& configs)
+{
+  solver_t::problem_t& problem = *pb.problem;
+  for(std::size_t robotIndex = 0; robotIndex < robotConfigs_.size(); ++robotIndex)
+  {
+    const RunConfig& config = configs[robotIndex];
+    PGData& pgdata = pgdatas_[robotIndex];
+
+    problem.startingPoint()->segment(pgdata.qParamsBegin(), pgdata.mb().nrParams()) =
+      rbd::paramToVector(pgdata.multibody(), config.initQ);
+    // run forward kinematics to compute initial force
+    pgdata.updateKinematics(config.initQ);
+
+    // if init force is not well sized we compute it
+    if(int(config.initForces.size()) != pgdata.nrForcePoints())
+    {
+      // start from the forces inside the friction cones that best balance
+      // gravity in the initQ configuration
+      std::vector<Eigen::Vector3d> forces = equilibriumForces(pgdata);
+      int pos = pgdata.forceParamsBegin();
+      for(const Eigen::Vector3d& force: forces)
+      {
+        problem.startingPoint()->segment<3>(pos) = force;
+        pos += 3;
+      }
+      if(iters_->stopRequested())
+      {
+        return false;
+      }
+    }
+    else
+    {
+      int pos = pgdata.forceParamsBegin();
+      for(int i = 0; i < pgdata.nrForcePoints(); ++i)
+      {
+        (*problem.startingPoint())[pos + 0] = config.initForces[i].force()[0];
+        (*problem.startingPoint())[pos + 1] = config.initForces[i].force()[1];
+        (*problem.startingPoint())[pos + 2] = config.initForces[i].force()[2];
+        pos += 3;
+      }
+    }
+
+    // force PGData to make an update
+    // this avoid that a first call with a x identical to PGData::{xq_,xf_}
+    // don't update PGData
+    pgdata.update();
+  }
+  return true;
+}
+
+
+void PostureGenerator::updateTargets(Problem& pb, const std::vector<RunConfig>& configs)
+{
+  for(const std::function<void()>& setTarget: pb.targetSetters)
+  {
+    setTarget();
+  }
+  pb.cost.targets(robotConfigs_, configs);
+  if(pb.description.cost)
+  {
+    pb.description.cost->targets(robotConfigs_, configs);
+  }
+}
+
+
+bool PostureGenerator::run(const std::vector<RunConfig>& configs)
+{
+  warmStartEntry_ = -1;
+  sensitivity_.resize(0, 0);
+  unreachable_ = checkReachability();
+  if(rejectUnreachable_ && !unreachable_.empty())
+  {
+    selection_ = NoResult;
+    return false;
+  }
+
+  iters_->recording = options_.recording;
+  iters_->start();
+  iters_->startDeadline(options_.deadline);
+  profile_ = Profile();
+  Tracer::clock::time_point buildStart = Tracer::clock::now();
+  tracer_.start(options_.tracing ? std::max(int(pgdatas_.size()), 1) : 0);
+
+  bool lockedJoints = std::any_of(configs.begin(), configs.end(),
+    [](const RunConfig& rc) {return !rc.lockedJoints.empty();});
+  if(options_.modelReduction || lockedJoints)
+  {
+    std::vector<ModelReduction> reductions(reduceModels(configs));
+    if(!reductions.empty())
+    {
+      return runReduced(reductions);
+    }
+  }
+
+  boost::shared_ptr<Problem> pb = buildProblem(configs);
+  solver_t::problem_t& problem = *pb->problem;
+  if(!startingPoint(*pb, configs))
+  {
+    return selectIterate();
+  }
+
+  std::uint64_t dbSignature = 0;
+  Eigen::VectorXd dbFeatures;
+  if(database_)
+  {
+    dbSignature = PostureDatabase::signature(robotConfigs_, robotLinks_);
+    dbFeatures = PostureDatabase::features(robotConfigs_, robotLinks_, configs);
+    double bestViol = std::numeric_limits<double>::infinity();
+    Eigen::VectorXd r;
+    for(const PostureDatabase::Neighbor& n:
+        database_->nearest(dbSignature, dbFeatures, nrNeighbors_))
+    {
+      Eigen::VectorXd x0(database_->entryX(n.entry));
+      if(x0.size() != problem.startingPoint()->size())
+      {
+        continue;
+      }
+      pb->constraints.residual(x0, r);
+      if(r.norm() < bestViol)
+      {
+        bestViol = r.norm();
+        warmStartEntry_ = n.entry;
+      }
+    }
+    if(warmStartEntry_ != -1)
+    {
+      problem.startingPoint() = Eigen::VectorXd(database_->entryX(warmStartEntry_));
+    }
+  }
+
+  LevenbergMarquardt& projection = pb->projection;
+  if(options_.contactProjection > 0 && projection.nrResiduals() > 0)
+  {
+    projection.normalizer([this](Eigen::VectorXd& x) {normalizeFreeJoints(x);});
+    projection.iterationCallback([this](const Eigen::VectorXd&, const Eigen::VectorXd&)
+      {iters_->checkDeadline();});
+    Eigen::VectorXd x0(*problem.startingPoint());
+    try
+    {
+      projection.solve(x0, problem.argumentBounds(), options_.contactProjection);
+    }
+    catch(const DeadlineReached&)
+    {
+      return selectIterate();
+    }
+    problem.startingPoint() = x0;
+  }
+
+  if(iters_->stopRequested())
+  {
+    return selectIterate();
+  }
+
+  if(options_.tracing)
+  {
+    tracer_.lane(0)->add(Tracer::Build, Tracer::Run, buildStart, Tracer::clock::now());
+  }
+
+  bool success = solveProblem(*pb);
+  if(selection_ == Converged)
+  {
+    if(!sensitivityParams_.empty())
+    {
+      sensitivity_ = targetSensitivity(pgdatas_, robotConfigs_, configs,
+                                       sensitivityParams_, pb->constraints, pb->targetRows,
+                                       problem.argumentBounds(), x_);
+      trackProblem_ = pb;
+    }
+    if(database_ && databaseAdd_)
+    {
+      database_->add(dbSignature, dbFeatures, x_);
+    }
+  }
+  return success;
+}
+
+
+bool PostureGenerator::resolve(Problem& pb, const std::vector<RunConfig>& configs,
+                               bool warmStart)
+{
+  iters_->recording = options_.recording;
+  iters_->start();
+  iters_->startDeadline(options_.deadline);
+  updateTargets(pb, configs);
+  if(warmStart)
+  {
+    *pb.problem->startingPoint() = x_;
   }
+  return solveProblem(pb);
+}
 
-  roboptim::SolverFactory<solver_t> factory ("ipopt-sparse", problem);
-  solver_t& solver = factory ();
 
-  iters_->datas.clear();
-  solver.setIterationCallback(boost::ref(*iters_));
+bool PostureGenerator::solveProblem(Problem& pb)
+{
+  TraceBuffer* solverTrace = options_.tracing ? tracer_.lane(0) : nullptr;
+  iters_->trace = solverTrace;
+  iters_->lastIteration = Tracer::clock::now();
 
-  for(const auto& p: params_)
+  Eigen::VectorXd x;
+  bool success = false;
+  try
   {
-    solver.parameters()[p.first] = p.second;
+    ScopedProfile prof(options_.profiling ? &profile_.solve : nullptr);
+    ScopedTrace trace(solverTrace, Tracer::Solve, Tracer::Run);
+    success = solve(pb, x);
   }
+  catch(const DeadlineReached&)
+  {}
 
-  solver_t::result_t res = solver.minimum();
-  // Check if the minimization has succeed.
-  if(res.which() != solver_t::SOLVER_VALUE &&
-     res.which() != solver_t::SOLVER_VALUE_WARNINGS)
+  // IPOPT return normally when stopped
+  if(iters_->deadlineReached || (!success && options_.maxIter > 0))
   {
+    return selectIterate();
+  }
+
+  selection_ = success ? Converged : NoResult;
+  if(success)
+  {
+    x_ = x;
+  }
+  return success;
+}
+
+
+bool PostureGenerator::solve(Problem& pb, Eigen::VectorXd& x)
+{
+  const SolverBackend::Description& description = pb.description;
+  if(options_.engine == CustomEngine)
+  {
+    usedEngine_ = CustomEngine;
+    return options_.backend->solve(description, options_.params, *iters_, x);
+  }
+
+  if(options_.engine == LMEngine || (options_.engine == AutoEngine && kinematicOnly()))
+  {
+    usedEngine_ = LMEngine;
+    LMBackend lm(1e3, options_.maxIter > 0 ? options_.maxIter : 200);
+    bool lmSuccess = lm.solve(description, options_.params, *iters_, x);
+    if(lmSuccess || options_.engine == LMEngine)
+    {
+      return lmSuccess;
+    }
+    // IPOPT start from the least violating point found
+    pb.problem->startingPoint() = x;
+  }
+
+  usedEngine_ = IpoptEngine;
+  boost::shared_ptr<roboptim::SolverFactory<solver_t>> factory(
+    new roboptim::SolverFactory<solver_t>("ipopt-sparse", *pb.problem));
+  pb.ipoptFactory = factory;
+  if(options_.maxIter > 0)
+  {
+    solver_t::parameters_t params(options_.params);
+    params["ipopt.max_iter"].value = options_.maxIter;
+    return RoboptimBackend::solve((*factory)(), params, *iters_, x);
+  }
+  return RoboptimBackend::solve((*factory)(), options_.params, *iters_, x);
+}
+
+
+bool PostureGenerator::selectIterate()
+{
+  if(iters_->hasBestFeasible)
+  {
+    selection_ = LowestCostFeasible;
+    x_ = iters_->bestFeasible.x;
+    return true;
+  }
+
+  if(iters_->hasLeastViolating)
+  {
+    selection_ = LeastViolating;
+    x_ = iters_->leastViolating.x;
     return false;
   }
 
-  ResultVisitor resVisitor;
-  boost::apply_visitor(resVisitor, res);
-  x_ = resVisitor.x;
+  selection_ = NoResult;
+  return false;
+}
+
 
+bool PostureGenerator::kinematicOnly() const
+{
+  for(const RobotConfig& rc: robotConfigs_)
+  {
+    if(!rc.forceContacts.empty() || !rc.ellipseContacts.empty() ||
+       !rc.gripperContacts.empty() || !rc.cylindricalContacts.empty() ||
+       !rc.envCollisions.empty() || !rc.selfCollisions.empty() ||
+       !rc.comHalfSpaces.empty())
+    {
+      return false;
+    }
+
+    for(const PlanarContact& pc: rc.planarContacts)
+    {
+      if(!pc.targetPoints.empty() && !pc.surfacePoints.empty())
+      {
+        return false;
+      }
+    }
+  }
   return true;
 }
 
 
+void PostureGenerator::normalizeFreeJoints(Eigen::VectorXd& x) const
+{
+  for(const PGData& pgdata: pgdatas_)
+  {
+    if(pgdata.mb().joint(0).type() == rbd::Joint::Free)
+    {
+      x.segment<4>(pgdata.qParamsBegin()).normalize();
+    }
+  }
+}
+
+
+RunHandle PostureGenerator::runAsync(std::vector<RunConfig> configs,
+                                     std::function<void(bool)> onComplete)
+{
+  if(asyncRun_.valid() &&
+     asyncRun_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+  {
+    throw std::logic_error("A runAsync is already running");
+  }
+
+  RunHandle handle;
+  handle.state_ = std::make_shared<RunHandle::State>();
+  std::shared_ptr<RunHandle::State> state(handle.state_);
+
+  iters_->cancel = state->cancel;
+  iters_->observer = [state](const iteration_callback_t::Data& d)
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    ++state->progress.nrIters;
+    state->progress.obj = d.obj;
+    state->progress.constr_viol = d.constr_viol;
+  };
+
+  handle.result_ = std::async(std::launch::async,
+    [this, configs, onComplete]()
+    {
+      bool success = false;
+      try
+      {
+        success = run(configs);
+      }
+      catch(...)
+      {
+        iters_->cancel.reset();
+        iters_->observer = nullptr;
+        if(onComplete)
+        {
+          onComplete(false);
+        }
+        throw;
+      }
+      iters_->cancel.reset();
+      iters_->observer = nullptr;
+
+      if(onComplete)
+      {
+        onComplete(success);
+      }
+      return success;
+    }).share();
+  asyncRun_ = handle.result_;
+
+  return handle;
+}
+
+
+BatchResult PostureGenerator::runBatch(const std::vector<RunConfig>& configs,
+                                       const Eigen::MatrixXd& initQ,
+                                       const std::vector<TargetParameter>& params,
+                                       const Eigen::MatrixXd& targets,
+                                       int nrThreads) const
+{
+  if(configs.size() != pgdatas_.size())
+  {
+    throw std::domain_error("Wrong number of run configs");
+  }
+
+  int nrQueries = int(initQ.cols());
+  int nrTargets = 0;
+  for(const TargetParameter& param: params)
+  {
+    nrTargets += parameterSize(robotConfigs_, param);
+  }
+  if(initQ.rows() != pgdatas_[0].forceParamsBegin())
+  {
+    throw std::domain_error("Wrong number of joints parameters");
+  }
+  if(targets.rows() != nrTargets || (nrTargets > 0 && targets.cols() != nrQueries))
+  {
+    throw std::domain_error("Wrong number of targets");
+  }
+
+  BatchResult result;
+  int xSize = pgdatas_[0].pbSize();
+  result.x.setConstant(xSize, nrQueries, std::numeric_limits<double>::quiet_NaN());
+  result.success.assign(nrQueries, 0);
+  result.nrIters.assign(nrQueries, 0);
+
+  nrThreads = nrThreads > 0 ? nrThreads :
+    std::max(int(std::thread::hardware_concurrency()), 1);
+  nrThreads = std::max(std::min(nrThreads, nrQueries), 1);
+
+  std::atomic<int> next(0);
+  std::vector<std::exception_ptr> errors(nrThreads);
+  auto solveQueries = [&](int t)
+  {
+    try
+    {
+      PostureGenerator worker;
+      worker.robotConfigs(robotConfigs_, pgdatas_[0].gravity());
+      worker.robotLinks(robotLinks_);
+      worker.options_ = options_;
+      worker.reachabilityMaps_ = reachabilityMaps_;
+      worker.rejectUnreachable_ = rejectUnreachable_;
+      worker.options_.recording = IterateRecording(IterateRecording::Off);
+
+      Eigen::VectorXd x0(Eigen::VectorXd::Zero(xSize));
+      std::vector<RunConfig> queryConfigs;
+      for(int i = next++; i < nrQueries; i = next++)
+      {
+        queryConfigs = configs;
+        if(!params.empty())
+        {
+          worker.robotConfigs_ = robotConfigs_;
+          int row = 0;
+          for(const TargetParameter& param: params)
+          {
+            int size = parameterSize(robotConfigs_, param);
+            moveTarget(worker.robotConfigs_, queryConfigs, param,
+                       targets.col(i).segment(row, size));
+            row += size;
+          }
+        }
+
+        x0.head(initQ.rows()) = initQ.col(i);
+        for(std::size_t r = 0; r < pgdatas_.size(); ++r)
+        {
+          queryConfigs[r].initQ = q(int(r), x0);
+          queryConfigs[r].initForces.clear();
+        }
+
+        result.success[i] = worker.run(queryConfigs) ? 1 : 0;
+        result.nrIters[i] = worker.iters_->nrIterations;
+        if(worker.selection_ != NoResult)
+        {
+          result.x.col(i) = worker.x_;
+        }
+      }
+    }
+    catch(...)
+    {
+      errors[t] = std::current_exception();
+      // stop the other threads
+      next = nrQueries;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for(int t = 1; t < nrThreads; ++t)
+  {
+    threads.emplace_back(solveQueries, t);
+  }
+  solveQueries(0);
+  for(std::thread& t: threads)
+  {
+    t.join();
+  }
+
+  for(const std::exception_ptr& error: errors)
+  {
+    if(error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+  return result;
+}
+
+
+std::vector<ModelReduction>
+PostureGenerator::reduceModels(const std::vector<RunConfig>& configs) const
+{
+  std::vector<ModelReduction> reductions;
+  bool reduced = false;
+  reductions.reserve(robotConfigs_.size());
+  for(std::size_t robotIndex = 0; robotIndex < robotConfigs_.size(); ++robotIndex)
+  {
+    const RobotConfig& robotConfig = robotConfigs_[robotIndex];
+    // ellipse variables position depend on the robot parameters number
+    if(!robotConfig.ellipseContacts.empty())
+    {
+      return {};
+    }
+
+    std::vector<int> linkedBodies;
+    for(const RobotLink& rl: robotLinks_)
+    {
+      for(const BodyLink& bl: rl.linkedBodies)
+      {
+        if(rl.robot1Index == int(robotIndex) || rl.robot2Index == int(robotIndex))
+        {
+          linkedBodies.push_back(bl.bodyId);
+        }
+      }
+    }
+
+    reductions.emplace_back(robotConfig, configs[robotIndex], linkedBodies,
+                            options_.modelReduction);
+    reduced |= reductions.back().reduced();
+  }
+
+  if(!reduced)
+  {
+    return {};
+  }
+  return reductions;
+}
+
+
+bool PostureGenerator::runReduced(const std::vector<ModelReduction>& reductions)
+{
+  std::vector<RobotConfig> robotConfigs;
+  std::vector<RunConfig> configs;
+  robotConfigs.reserve(reductions.size());
+  configs.reserve(reductions.size());
+  for(const ModelReduction& mr: reductions)
+  {
+    robotConfigs.push_back(mr.robotConfig());
+    configs.push_back(mr.runConfig());
+  }
+
+  PostureGenerator reducedPb;
+  reducedPb.robotConfigs(std::move(robotConfigs), pgdatas_[0].gravity());
+  reducedPb.robotLinks(robotLinks_);
+  reducedPb.options_ = options_;
+  // the reduced problem can't be reduced again
+  reducedPb.options_.modelReduction = false;
+  reducedPb.iters_->cancel = iters_->cancel;
+  // the reduced iterates are expanded and recorded here,
+  // the reduced problem only keep its best iterates
+  reducedPb.options_.recording = IterateRecording(IterateRecording::Off);
+  iteration_callback_t& iters = *iters_;
+  const PostureGenerator& rPb = reducedPb;
+  reducedPb.iters_->observer =
+    [this, &iters, &reductions, &rPb](const iteration_callback_t::Data& d)
+  {
+    if(iters.recordX())
+    {
+      iters.record(expandX(reductions, rPb, d.x), d.obj, d.constr_viol);
+    }
+    else
+    {
+      iters.record(Eigen::VectorXd(), d.obj, d.constr_viol);
+    }
+  };
+
+  bool success = reducedPb.run(configs);
+  usedEngine_ = reducedPb.usedEngine_;
+  selection_ = reducedPb.selection_;
+  profile_ = reducedPb.profile_;
+  tracer_ = reducedPb.tracer_;
+
+  if(selection_ != NoResult)
+  {
+    x_ = expandX(reductions, reducedPb, reducedPb.x_);
+  }
+  return success;
+}
+
+
+std::vector<UnreachableContact> PostureGenerator::checkReachability() const
+{
+  std::vector<UnreachableContact> unreachable;
+  for(std::size_t robot = 0;
+      robot < std::min(robotConfigs_.size(), reachabilityMaps_.size()); ++robot)
+  {
+    const RobotConfig& rc = robotConfigs_[robot];
+    if(rc.mb.nrJoints() == 0 || rc.mb.joint(0).type() == rbd::Joint::Free)
+    {
+      continue;
+    }
+    auto findMap = [this, robot](int bodyId) -> const ReachabilityMap*
+    {
+      for(const ReachabilityMap& map: reachabilityMaps_[robot])
+      {
+        if(map.bodyId() == bodyId)
+        {
+          return &map;
+        }
+      }
+      return nullptr;
+    };
+    auto maxNorm = [](const std::vector<Eigen::Vector2d>& points)
+    {
+      double n = 0.;
+      for(const Eigen::Vector2d& p: points)
+      {
+        n = std::max(n, p.norm());
+      }
+      return n;
+    };
+
+    // the body origin is at most the surface frame offset from the target,
+    // a one voxel margin keep the unsampled border of the workspace
+    for(const FixedPositionContact& fpc: rc.fixedPosContacts)
+    {
+      const ReachabilityMap* map = findMap(fpc.bodyId);
+      if(map && !map->reachable(fpc.target, fpc.surfaceFrame.translation().norm() +
+                                map->voxelSize()))
+      {
+        unreachable.push_back({int(robot), fpc.bodyId, fpc.target});
+      }
+    }
+
+    // the surface can be anywhere on the target polygon
+    for(const PlanarContact& pc: rc.planarContacts)
+    {
+      const ReachabilityMap* map = findMap(pc.bodyId);
+      if(!map || pc.targetPoints.empty())
+      {
+        continue;
+      }
+      double radius = maxNorm(pc.targetPoints) + maxNorm(pc.surfacePoints) +
+        pc.surfaceFrame.translation().norm() + map->voxelSize();
+      const Eigen::Vector3d& target = pc.targetFrame.translation();
+      // the body surface normal must be the target one
+      Eigen::Vector3d normal(pc.surfaceFrame.rotation().row(2));
+      bool reachable = normal.dot(map->axis()) > 1. - 1e-6 ?
+        map->reachable(target, radius,
+                       Eigen::Vector3d(pc.targetFrame.rotation().row(2))) :
+        map->reachable(target, radius);
+      if(!reachable)
+      {
+        unreachable.push_back({int(robot), pc.bodyId, target});
+      }
+    }
+  }
+  return unreachable;
+}
+
+
+const Eigen::VectorXd& PostureGenerator::xIter(int i) const
+{
+  const Eigen::VectorXd& x = iters_->at(i).x;
+  if(x.size() == 0)
+  {
+    throw std::out_of_range("Iterate " + std::to_string(i) + " x is not recorded");
+  }
+  return x;
+}
+
+
+Eigen::VectorXd PostureGenerator::expandX(const std::vector<ModelReduction>& reductions,
+                                          const PostureGenerator& reducedPb,
+                                          const Eigen::VectorXd& x) const
+{
+  Eigen::VectorXd fullX(pgdatas_[0].pbSize());
+  for(std::size_t robotIndex = 0; robotIndex < pgdatas_.size(); ++robotIndex)
+  {
+    const PGData& pgdata = pgdatas_[robotIndex];
+    const PGData& reducedPGData = reducedPb.pgdatas_[robotIndex];
+    reductions[robotIndex].expandQ(
+      x.segment(reducedPGData.qParamsBegin(), reducedPGData.mb().nrParams()),
+      fullX.segment(pgdata.qParamsBegin(), pgdata.mb().nrParams()));
+    fullX.segment(pgdata.forceParamsBegin(), pgdata.nrForcePoints()*3) =
+      x.segment(reducedPGData.forceParamsBegin(), reducedPGData.nrForcePoints()*3);
+  }
+  return fullX;
+}
+
+
+const Eigen::VectorXd& PostureGenerator::x() const
+{
+  return x_;
+}
+
+
+int PostureGenerator::qParamsBegin(int robot) const
+{
+  return pgdatas_.at(robot).qParamsBegin();
+}
+
+
+int PostureGenerator::nrParams(int robot) const
+{
+  return pgdatas_.at(robot).mb().nrParams();
+}
+
+
+int PostureGenerator::forceParamsBegin(int robot) const
+{
+  return pgdatas_.at(robot).forceParamsBegin();
+}
+
+
+int PostureGenerator::nrForcePoints(int robot) const
+{
+  return pgdatas_.at(robot).nrForcePoints();
+}
+
+
 std::vector<std::vector<double> > PostureGenerator::q() const
 {
   return q(0, x_);
@@ -579,67 +1728,96 @@ std::vector<EllipseResult> PostureGenerator::ellipses(int robot) const
 
 int PostureGenerator::nrIters() const
 {
-  return int(iters_->datas.size());
+  return iters_->size();
 }
 
 
 std::vector<std::vector<double> > PostureGenerator::qIter(int i) const
 {
-  return q(0, iters_->datas.at(i).x);
+  return q(0, xIter(i));
 }
 
 
 
 std::vector<sva::ForceVecd> PostureGenerator::forcesIter(int i) const
 {
-  return forces(0, iters_->datas.at(i).x);
+  return forces(0, xIter(i));
 }
 
 
 
 std::vector<std::vector<double> > PostureGenerator::torqueIter(int i)
 {
-  return torque(0, iters_->datas.at(i).x);
+  return torque(0, xIter(i));
 }
 
 
 std::vector<EllipseResult> PostureGenerator::ellipsesIter(int i) const
 {
-  return ellipses(0, iters_->datas.at(i).x);
+  return ellipses(0, xIter(i));
 }
 
 
 std::vector<std::vector<double> > PostureGenerator::qIter(int robot, int i) const
 {
-  return q(robot, iters_->datas.at(i).x);
+  return q(robot, xIter(i));
 }
 
 
 std::vector<sva::ForceVecd> PostureGenerator::forcesIter(int robot, int i) const
 {
-  return forces(robot, iters_->datas.at(i).x);
+  return forces(robot, xIter(i));
 }
 
 
 std::vector<std::vector<double> > PostureGenerator::torqueIter(int robot, int i)
 {
-  return torque(robot, iters_->datas.at(i).x);
+  return torque(robot, xIter(i));
 }
 
 
 std::vector<EllipseResult> PostureGenerator::ellipsesIter(int robot, int i) const
 {
-  return ellipses(robot, iters_->datas.at(i).x);
+  return ellipses(robot, xIter(i));
 }
 
 
 IterateQuantities PostureGenerator::quantitiesIter(int i) const
 {
-  const iteration_callback_t::Data& d = iters_->datas.at(i);
+  const iteration_callback_t::Data& d = iters_->at(i);
   return IterateQuantities{d.obj,  d.constr_viol};
 }
 
 
+CapturedProblem PostureGenerator::capture(const std::vector<RunConfig>& configs,
+                                          bool withResult) const
+{
+  CapturedProblem pb;
+  pb.robotConfigs = robotConfigs_;
+  pb.gravity = pgdatas_.empty() ? Eigen::Vector3d::Zero() : pgdatas_[0].gravity();
+  pb.robotLinks = robotLinks_;
+  pb.runConfigs = configs;
+  pb.options = options_;
+  if(options_.backend)
+  {
+    pb.backendName = options_.backend->name();
+  }
+
+  if(withResult)
+  {
+    pb.hasResult = true;
+    pb.resultSelection = selection_;
+    pb.x = x_;
+    pb.iterates.reserve(iters_->size());
+    for(int i = 0; i < iters_->size(); ++i)
+    {
+      pb.iterates.push_back(iters_->at(i));
+    }
+  }
+  return pb;
+}
+
+
 std::vector<std::vector<double> >
 PostureGenerator::q(int robot, const Eigen::VectorXd& x) const
 {
@@ -16,6 +16,10 @@
 #pragma once
 
 // include
+// std
+#include <functional>
+#include <future>
+
 // boost
 #include <boost/math/constants/constants.hpp>
 #include <boost/bind.hpp>
@@ -28,30 +32,79 @@
 // PG
 #include "ConfigStruct.h"
 #include "PGData.h"
+#include "SolverBackend.h"
+#include "RunHandle.h"
+#include "Profiler.h"
+#include "Tracer.h"
+#include "ReachabilityMap.h"
+#include "Sensitivity.h"
 
 
 namespace pg
 {
 class MultiBody;
-template <class problem_t, class solverState_t>
-struct IterationCallback;
+class ModelReduction;
+struct CapturedProblem;
+class PostureDatabase;
+class StreamingSolver;
 
 class PostureGenerator
 {
 public:
   typedef roboptim::EigenMatrixSparse functionType_t;
 
-  typedef boost::mpl::vector<
-    roboptim::LinearSparseFunction,
-    roboptim::DifferentiableSparseFunction> constraints_t;
+  typedef SolverBackend::constraints_t constraints_t;
+  typedef SolverBackend::solver_t solver_t;
+  typedef SolverBackend::iteration_callback_t iteration_callback_t;
+
+  enum Engine
+  {
+    /// LMEngine for kinematics only problems, IpoptEngine otherwise.
+    AutoEngine,
+    /// Default.
+    IpoptEngine,
+    /// Levenberg-Marquardt on the costs and the weighted constraints.
+    LMEngine,
+    /// Backend given to backend().
+    CustomEngine
+  };
+
+  /// How the last run result was chosen.
+  enum ResultSelection
+  {
+    /// No result.
+    NoResult,
+    /// Solver solution.
+    Converged,
+    /// Deadline or iterations limit reached, feasible iterate with the
+    /// lowest cost.
+    LowestCostFeasible,
+    /// Deadline or iterations limit reached without feasible iterate,
+    /// least violating iterate.
+    LeastViolating
+  };
 
-  //define the solver
-  typedef roboptim::Solver<
-      roboptim::DifferentiableSparseFunction,
-      constraints_t> solver_t;
+  /**
+    * Solver options, set by the option methods below.
+    * Problems derived from a PostureGenerator (reduced problem, batch
+    * workers, captures) copy them as a whole.
+    */
+  struct Options
+  {
+    Options();
 
-  typedef IterationCallback < solver_t::problem_t,
-    solver_t::solverState_t > iteration_callback_t;
+    solver_t::parameters_t params;
+    bool parallelUpdate;
+    bool modelReduction;
+    int contactProjection;
+    Engine engine;
+    boost::shared_ptr<SolverBackend> backend;
+    double deadline;
+    int maxIter;
+    IterateRecording recording;
+    bool profiling;
+    bool tracing;
+  };
 
 public:
   PostureGenerator();
@@ -66,7 +119,186 @@ public:
   void param(const std::string& name, double value);
   void param(const std::string& name, int value);
 
+  /// Set all the solver options.
+  /// @throw std::domain_error if o.engine is CustomEngine without backend.
+  void options(Options o);
+  const Options& options() const;
+
+  /// Update the robots of a multi-robot problem on separate threads.
+  void parallelUpdate(bool parallel);
+  bool parallelUpdate() const;
+
+  /// Solve the problem on the robots kinematic subtrees used by the
+  /// constraints and costs, other joints are locked at their initQ value.
+  /// RunConfig::lockedJoints are always removed from the problem.
+  void modelReduction(bool reduce);
+  bool modelReduction() const;
+
+  /// Move the starting point toward the contact constraints manifold with
+  /// at most nrIter Levenberg-Marquardt iterations before running IPOPT.
+  /// 0 (default) disable the projection.
+  void contactProjection(int nrIter);
+  int contactProjection() const;
+
+  /**
+    * Select the solver, IpoptEngine by default. Kinematics only problems
+    * (no force, collision, CoM half-space and inclusion constraints) can be
+    * solved by the Levenberg-Marquardt engine, much faster than IPOPT.
+    * The constraints are then a penalty followed by a feasibility step:
+    * the result is feasible but only close to the constrained optimum
+    * and the ipopt.* parameters are ignored.
+    * With AutoEngine IPOPT is run from the Levenberg-Marquardt solution
+    * when this one doesn't satisfy the constraints.
+    */
+  void engine(Engine e);
+  Engine engine() const;
+  /// Solve with backend (CustomEngine), a null backend restore IpoptEngine.
+  void backend(boost::shared_ptr<SolverBackend> backend);
+  boost::shared_ptr<SolverBackend> backend() const;
+  /// Engine that solved the last run.
+  Engine usedEngine() const;
+
+  /**
+    * Stop run after seconds of wall-clock time (0, the default, disable it).
+    * When the deadline is reached the result is the feasible iterate
+    * (constraints violation below 1e-4) with the lowest cost. If there is
+    * none run return false and the result is the least violating iterate.
+    */
+  void deadline(double seconds);
+  double deadline() const;
+  /// Limit the solver iterations of the next runs (0, the default, disable
+  /// it). The result is then chosen like when the deadline is reached.
+  void maxIterations(int nrIter);
+  int maxIterations() const;
+  ResultSelection resultSelection() const;
+
+  /**
+    * Choose how the iterates of the next runs are recorded (All by default).
+    * The deadline result selection don't depend on it.
+    */
+  void iterateRecording(IterateRecording recording);
+  const IterateRecording& iterateRecording() const;
+
+  /// Count and time the cost and constraints evaluations, the forward
+  /// kinematics, the collision queries and the solver of the next runs.
+  void profiling(bool profile);
+  bool profiling() const;
+  /// Profile of the last run (empty if profiling was disabled).
+  const Profile& profile() const;
+
+  /// Record the spans (problem build, solver iterations, functions
+  /// evaluations, forward kinematics, collision queries) of the next runs.
+  void tracing(bool trace);
+  bool tracing() const;
+  /// Number of spans recorded by each thread in a run, the next ones are dropped.
+  /// @throw std::domain_error if capacity is negative.
+  void traceCapacity(int capacity);
+  int traceCapacity() const;
+  /// Spans of the last run, Tracer::write export them in Chrome trace format.
+  const Tracer& tracer() const;
+
+  /**
+    * Warm start the next runs from db: the starting point is replaced by the
+    * least constraints violating solution of the nrNeighbors problems of db
+    * nearest to the run one (same signature).
+    * Converged solutions are added to db if add is true.
+    * A null db disable it. The database is not used with model reduction.
+    */
+  void postureDatabase(boost::shared_ptr<PostureDatabase> db, int nrNeighbors=1,
+                       bool add=true);
+  boost::shared_ptr<PostureDatabase> postureDatabase() const;
+  /// Database entry used as starting point by the last run, -1 if none.
+  int warmStartEntry() const;
+
+  /**
+    * Check the FixedPositionContact and PlanarContact targets of the next
+    * runs with the reachability maps of each robot (maps[robot], a robot
+    * without maps or with a free root joint is not checked).
+    * Planar contacts without target points are not checked.
+    * Maps are sampled, so a target is only unreachable when it is more than
+    * one voxel away from the reached voxels. A sparse map can still flag
+    * reachable targets.
+    * @param reject Make run return false without solving when a target is
+    * unreachable, by default unreachable targets are only reported.
+    */
+  void reachabilityMaps(std::vector<std::vector<ReachabilityMap>> maps,
+                        bool reject=false);
+  const std::vector<std::vector<ReachabilityMap>>& reachabilityMaps() const;
+  /// Unreachable contacts found by the last run.
+  const std::vector<UnreachableContact>& unreachableContacts() const;
+
+  /**
+    * Compute the derivative of the solution by the params targets after
+    * each converged run (see targetSensitivity), parameters are stacked
+    * in params order. Not computed with model reduction.
+    * An empty params disable it.
+    * @throw std::out_of_range if a parameter don't exist in robotConfigs.
+    */
+  void sensitivityParameters(std::vector<TargetParameter> params);
+  const std::vector<TargetParameter>& sensitivityParameters() const;
+  /// dx/dp of the last run, empty if it was not computed.
+  const Eigen::MatrixXd& sensitivity() const;
+  /// Rows of sensitivity() of the robot joints parameters (paramToVector order).
+  Eigen::MatrixXd qSensitivity(int robot) const;
+
+  /**
+    * Predictor-corrector run for a small change dp of the sensitivity
+    * parameters targets: the targets are moved by dp (see moveTarget), the
+    * last solution is moved by sensitivity()*dp and corrected with at most
+    * nrCorrectorIter iterations of the LM or IPOPT engine on the problem of
+    * the last run.
+    * A full run from the corrector result is done if the corrector fail,
+    * both share the deadline.
+    * The new sensitivity is computed like after run.
+    * @param configs Configs of the last run, their targetQ are moved.
+    * @throw std::logic_error if the last run sensitivity was not computed.
+    */
+  bool track(std::vector<RunConfig>& configs, const Eigen::VectorXd& dp,
+             int nrCorrectorIter=10);
+
   bool run(const std::vector<RunConfig>& configs);
+  /**
+    * Call run on a new thread.
+    * @param onComplete Called on the run thread with the run result
+    * (false if run throw).
+    * @throw std::logic_error if a previous runAsync is not done.
+    */
+  RunHandle runAsync(std::vector<RunConfig> configs,
+                     std::function<void(bool)> onComplete=std::function<void(bool)>());
+
+  /**
+    * Solve a batch of queries on nrThreads threads (one by core if <= 0).
+    * Each thread solve with its own PostureGenerator that use the options
+    * and reachability maps of this one (the posture database is not used
+    * and iterates are not recorded). A CustomEngine backend must be
+    * thread-safe.
+    * @param configs Configs of every query.
+    * @param initQ Joints parameters of all robots (x head) of the starting
+    * point of query i in column i, initForces are computed.
+    * @param params Target parameters moved in each query.
+    * @param targets Displacement of the params targets (see moveTarget)
+    * of query i in column i, stacked in params order.
+    * @throw std::domain_error if configs, initQ or targets is not well sized.
+    */
+  BatchResult runBatch(const std::vector<RunConfig>& configs,
+                       const Eigen::MatrixXd& initQ,
+                       const std::vector<TargetParameter>& params,
+                       const Eigen::MatrixXd& targets,
+                       int nrThreads=0) const;
+
+  /**
+    * Solution of the last run, empty if none: joints parameters of each
+    * robot (free joint quaternion not normalized) then 3 force components
+    * by force point of each robot.
+    */
+  const Eigen::VectorXd& x() const;
+  /// Index of the robot joints parameters in x.
+  /// @throw std::out_of_range if robot don't exist.
+  int qParamsBegin(int robot) const;
+  int nrParams(int robot) const;
+  /// Index of the robot forces in x.
+  int forceParamsBegin(int robot) const;
+  int nrForcePoints(int robot) const;
 
   // robot 0
   std::vector<std::vector<double>> q() const;
@@ -79,9 +311,12 @@ public:
   std::vector<std::vector<double>> torque(int robot);
   std::vector<EllipseResult> ellipses(int robot) const;
 
+  /// Number of stored iterates (0 in Off and File mode).
   int nrIters() const;
 
   // robot 0
+  // Iter methods throw std::out_of_range if the iterate is not stored
+  // or if its x is not recorded (Quantities mode).
   std::vector<std::vector<double>> qIter(int i) const;
   std::vector<sva::ForceVecd> forcesIter(int i) const;
   std::vector<std::vector<double>> torqueIter(int i);
@@ -93,8 +328,55 @@ public:
   std::vector<EllipseResult> ellipsesIter(int robot, int i) const;
 
   IterateQuantities quantitiesIter(int i) const;
+  /// x of iterate i.
+  /// @throw std::out_of_range if iterate i x is not stored.
+  const Eigen::VectorXd& xIter(int i) const;
+
+  /**
+    * Capture robots, links, solver options and configs in a CapturedProblem
+    * that saveProblem can write.
+    * @param withResult Also capture the last run solution and stored iterates.
+    */
+  CapturedProblem capture(const std::vector<RunConfig>& configs,
+                          bool withResult=false) const;
 
 private:
+  friend struct CapturedProblem;
+  friend class StreamingSolver;
+
+  struct Problem;
+
+  /// Build the functions and the solver problem of configs.
+  /// The problem PGDataGroup is bound to pgdatas_ until its destruction.
+  boost::shared_ptr<Problem> buildProblem(const std::vector<RunConfig>& configs);
+  /// Set pb starting point from configs initQ and initForces.
+  /// @return false if the deadline is reached.
+  bool startingPoint(Problem& pb, const std::vector<RunConfig>& configs);
+  /// Copy the targets of robotConfigs_ and configs in pb functions.
+  void updateTargets(Problem& pb, const std::vector<RunConfig>& configs);
+  /// Solve pb again with the current targets, from the last solution
+  /// if warmStart or from the pb starting point.
+  bool resolve(Problem& pb, const std::vector<RunConfig>& configs, bool warmStart);
+  /// Solve pb from its starting point and set the result.
+  bool solveProblem(Problem& pb);
+  /// Run the engine selected by options_.engine.
+  bool solve(Problem& pb, Eigen::VectorXd& x);
+  /// Choose the result between the iterates after the deadline.
+  bool selectIterate();
+  /// @return true if the problem has no force or non contact constraint.
+  bool kinematicOnly() const;
+  void normalizeFreeJoints(Eigen::VectorXd& x) const;
+
+  /// @return Robots reduced model, empty if no robot can be reduced.
+  std::vector<ModelReduction> reduceModels(const std::vector<RunConfig>& configs) const;
+  bool runReduced(const std::vector<ModelReduction>& reductions);
+  Eigen::VectorXd expandX(const std::vector<ModelReduction>& reductions,
+                          const PostureGenerator& reducedPb,
+                          const Eigen::VectorXd& x) const;
+
+  /// @return Contacts of robotConfigs_ out of their body reachability map.
+  std::vector<UnreachableContact> checkReachability() const;
+
   std::vector<std::vector<double>> q(int robot, const Eigen::VectorXd& x) const;
   std::vector<sva::ForceVecd> forces(int robot, const Eigen::VectorXd& x) const;
   std::vector<std::vector<double>> torque(int robot, const Eigen::VectorXd& x);
@@ -104,10 +386,28 @@ private:
   std::vector<PGData> pgdatas_;
   std::vector<RobotConfig> robotConfigs_;
   std::vector<RobotLink> robotLinks_;
-  solver_t::parameters_t params_;
+  Options options_;
+  Engine usedEngine_;
+  ResultSelection selection_;
+  Profile profile_;
+  Tracer tracer_;
+  boost::shared_ptr<PostureDatabase> database_;
+  int nrNeighbors_;
+  bool databaseAdd_;
+  int warmStartEntry_;
+  std::vector<std::vector<ReachabilityMap>> reachabilityMaps_;
+  bool rejectUnreachable_;
+  std::vector<UnreachableContact> unreachable_;
+  std::vector<TargetParameter> sensitivityParams_;
+  Eigen::MatrixXd sensitivity_;
+  /// Problem of the last run with a sensitivity, corrected by track.
+  /// Its PGDataGroup keep pgdatas_ bound, it's released by buildProblem.
+  boost::shared_ptr<Problem> trackProblem_;
 
   Eigen::VectorXd x_;
   boost::shared_ptr<iteration_callback_t> iters_;
+  /// Last runAsync, destroyed first to wait the end of the run.
+  std::shared_future<bool> asyncRun_;
 };
 
 
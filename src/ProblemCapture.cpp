@@ -0,0 +1,894 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "ProblemCapture.h"
+
+// include
+// std
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+// boost
+#include <boost/variant/get.hpp>
+
+// RBDyn
+#include <RBDyn/MultiBody.h>
+
+// sch
+#include <sch/S_Object/S_Object.h>
+#include <sch/S_Object/S_Sphere.h>
+#include <sch/S_Object/S_Box.h>
+#include <sch/S_Polyhedron/S_Polyhedron.h>
+
+
+namespace pg
+{
+
+static const char problemFileMagic[4] = {'P', 'G', 'P', 'B'};
+static const std::uint32_t problemFileVersion = 2;
+
+
+/*
+ *   Archives
+ */
+
+
+/// Write values in a binary stream.
+/// Hull pointers are written as their index in the hulls table.
+class ProblemWriter
+{
+public:
+  static const bool loading = false;
+
+  ProblemWriter(std::ostream& out, std::map<const sch::S_Object*, int> hulls)
+    : out_(out)
+    , hulls_(std::move(hulls))
+  {}
+
+  void operator()(const int& v)
+  {
+    std::int32_t i = std::int32_t(v);
+    raw(&i, sizeof(std::int32_t));
+  }
+
+  void operator()(const double& v)
+  {
+    raw(&v, sizeof(double));
+  }
+
+  void operator()(const bool& v)
+  {
+    std::uint8_t b = v ? 1 : 0;
+    raw(&b, sizeof(std::uint8_t));
+  }
+
+  void operator()(const std::string& v)
+  {
+    (*this)(int(v.size()));
+    raw(v.data(), v.size());
+  }
+
+  template<int Rows, int Cols, int Options, int MaxRows, int MaxCols>
+  void operator()(const Eigen::Matrix<double, Rows, Cols, Options, MaxRows, MaxCols>& v)
+  {
+    (*this)(int(v.rows()));
+    (*this)(int(v.cols()));
+    raw(v.data(), sizeof(double)*v.size());
+  }
+
+  void operator()(sch::S_Object* const& v)
+  {
+    (*this)(hulls_.at(v));
+  }
+
+  template<typename T>
+  void operator()(const std::vector<T>& v)
+  {
+    (*this)(int(v.size()));
+    for(const T& e: v)
+    {
+      (*this)(e);
+    }
+  }
+
+  /// Structures use the same serialize function than ProblemReader,
+  /// v is not modified when writing.
+  template<typename T>
+  void operator()(const T& v)
+  {
+    serialize(*this, const_cast<T&>(v));
+  }
+
+private:
+  void raw(const void* data, std::size_t size)
+  {
+    out_.write(reinterpret_cast<const char*>(data), std::streamsize(size));
+  }
+
+private:
+  std::ostream& out_;
+  std::map<const sch::S_Object*, int> hulls_;
+};
+
+
+/// Read values written by ProblemWriter.
+class ProblemReader
+{
+public:
+  static const bool loading = true;
+
+  ProblemReader(std::istream& in, const std::vector<boost::shared_ptr<sch::S_Object>>& hulls)
+    : in_(in)
+    , hulls_(hulls)
+  {}
+
+  void operator()(int& v)
+  {
+    std::int32_t i;
+    raw(&i, sizeof(std::int32_t));
+    v = int(i);
+  }
+
+  void operator()(double& v)
+  {
+    raw(&v, sizeof(double));
+  }
+
+  void operator()(bool& v)
+  {
+    std::uint8_t b;
+    raw(&b, sizeof(std::uint8_t));
+    v = b != 0;
+  }
+
+  void operator()(std::string& v)
+  {
+    v.resize(size());
+    raw(&v[0], v.size());
+  }
+
+  template<int Rows, int Cols, int Options, int MaxRows, int MaxCols>
+  void operator()(Eigen::Matrix<double, Rows, Cols, Options, MaxRows, MaxCols>& v)
+  {
+    int rows = size();
+    int cols = size();
+    if((Rows != Eigen::Dynamic && rows != Rows) ||
+       (Cols != Eigen::Dynamic && cols != Cols))
+    {
+      throw std::runtime_error("Matrix size mismatch");
+    }
+    v.resize(rows, cols);
+    raw(v.data(), sizeof(double)*v.size());
+  }
+
+  void operator()(sch::S_Object*& v)
+  {
+    int index = size();
+    if(index >= int(hulls_.size()))
+    {
+      throw std::runtime_error("Unknown hull " + std::to_string(index));
+    }
+    v = hulls_[index].get();
+  }
+
+  template<typename T>
+  void operator()(std::vector<T>& v)
+  {
+    v.resize(size());
+    for(T& e: v)
+    {
+      (*this)(e);
+    }
+  }
+
+  template<typename T>
+  void operator()(T& v)
+  {
+    serialize(*this, v);
+  }
+
+  /// Read a non negative int.
+  int size()
+  {
+    int s;
+    (*this)(s);
+    if(s < 0)
+    {
+      throw std::runtime_error("Negative size");
+    }
+    return s;
+  }
+
+private:
+  void raw(void* data, std::size_t size)
+  {
+    in_.read(reinterpret_cast<char*>(data), std::streamsize(size));
+    if(!in_)
+    {
+      throw std::runtime_error("Truncated problem file");
+    }
+  }
+
+private:
+  std::istream& in_;
+  const std::vector<boost::shared_ptr<sch::S_Object>>& hulls_;
+};
+
+
+/*
+ *   Structures
+ */
+
+// Types without public fields are copied, serialized
+// and then rebuilt when loading.
+
+
+template<typename Archive>
+void serialize(Archive& ar, sva::PTransformd& v)
+{
+  Eigen::Matrix3d E = v.rotation();
+  Eigen::Vector3d r = v.translation();
+  ar(E);
+  ar(r);
+  if(Archive::loading)
+  {
+    v = sva::PTransformd(E, r);
+  }
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, sva::ForceVecd& v)
+{
+  Eigen::Vector3d couple = v.couple();
+  Eigen::Vector3d force = v.force();
+  ar(couple);
+  ar(force);
+  if(Archive::loading)
+  {
+    v = sva::ForceVecd(couple, force);
+  }
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, FixedPositionContact& v)
+{
+  ar(v.bodyId); ar(v.target); ar(v.surfaceFrame);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, FixedOrientationContact& v)
+{
+  ar(v.bodyId); ar(v.target); ar(v.surfaceFrame);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, PlanarContact& v)
+{
+  ar(v.bodyId);
+  ar(v.targetFrame); ar(v.targetPoints);
+  ar(v.surfaceFrame); ar(v.surfacePoints);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, EllipseContact& v)
+{
+  ar(v.bodyId); ar(v.radiusMin1); ar(v.radiusMin2);
+  ar(v.targetFrame); ar(v.targetPoints);
+  ar(v.surfaceFrame); ar(v.surfacePoints);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, GripperContact& v)
+{
+  ar(v.bodyId);
+  ar(v.targetFrame); ar(v.targetPoints);
+  ar(v.surfaceFrame); ar(v.surfacePoints);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, CylindricalContact& v)
+{
+  ar(v.bodyId); ar(v.targetRadius); ar(v.targetWidth);
+  ar(v.targetFrame); ar(v.surfaceFrame);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, ForceContact& v)
+{
+  ar(v.bodyId); ar(v.points); ar(v.mu);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, EnvCollision& v)
+{
+  ar(v.bodyId); ar(v.bodyHull); ar(v.bodyT); ar(v.envHull); ar(v.minDist);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, SelfCollision& v)
+{
+  ar(v.body1Id); ar(v.body1Hull); ar(v.body1T);
+  ar(v.body2Id); ar(v.body2Hull); ar(v.body2T);
+  ar(v.minDist);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, CoMHalfSpace& v)
+{
+  ar(v.origins); ar(v.normals);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, BodyPositionTarget& v)
+{
+  ar(v.bodyId); ar(v.target); ar(v.scale);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, BodyOrientationTarget& v)
+{
+  ar(v.bodyId); ar(v.target); ar(v.scale);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, ForceContactMinimization& v)
+{
+  ar(v.bodyId); ar(v.scale);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, TorqueContactMinimization& v)
+{
+  ar(v.bodyId); ar(v.origin); ar(v.axis); ar(v.scale);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, NormalForceTarget& v)
+{
+  ar(v.bodyId); ar(v.target); ar(v.scale);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, TangentialForceMinimization& v)
+{
+  ar(v.bodyId); ar(v.scale);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, BodyLink& v)
+{
+  ar(v.bodyId); ar(v.body1T); ar(v.body2T);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, RobotLink& v)
+{
+  ar(v.robot1Index); ar(v.robot2Index); ar(v.linkedBodies);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, RunConfig& v)
+{
+  ar(v.initQ); ar(v.initForces); ar(v.targetQ); ar(v.lockedJoints);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, IterateData& v)
+{
+  ar(v.x); ar(v.obj); ar(v.constr_viol);
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, rbd::Body& v)
+{
+  double mass = v.inertia().mass();
+  Eigen::Vector3d momentum = v.inertia().momentum();
+  Eigen::Matrix3d inertia = v.inertia().inertia();
+  int id = v.id();
+  std::string name = v.name();
+  ar(mass); ar(momentum); ar(inertia); ar(id); ar(name);
+  if(Archive::loading)
+  {
+    v = rbd::Body(sva::RBInertiad(mass, momentum, inertia), id, name);
+  }
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, rbd::Joint& v)
+{
+  int type = int(v.type());
+  // the joint axis is only kept in its motion subspace
+  Eigen::Vector3d axis = Eigen::Vector3d::UnitZ();
+  if(v.type() == rbd::Joint::Rev || v.type() == rbd::Joint::Cylindrical)
+  {
+    axis = v.motionSubspace().col(0).head<3>()*v.direction();
+  }
+  else if(v.type() == rbd::Joint::Prism)
+  {
+    axis = v.motionSubspace().col(0).tail<3>()*v.direction();
+  }
+  bool forward = v.forward();
+  int id = v.id();
+  std::string name = v.name();
+  ar(type); ar(axis); ar(forward); ar(id); ar(name);
+  if(Archive::loading)
+  {
+    v = rbd::Joint(rbd::Joint::Type(type), axis, forward, id, name);
+  }
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, rbd::MultiBody& v)
+{
+  std::vector<rbd::Body> bodies = v.bodies();
+  std::vector<rbd::Joint> joints = v.joints();
+  std::vector<int> pred = v.predecessors();
+  std::vector<int> succ = v.successors();
+  std::vector<int> parent = v.parents();
+  std::vector<sva::PTransformd> Xt = v.transforms();
+  ar(bodies); ar(joints); ar(pred); ar(succ); ar(parent); ar(Xt);
+  if(Archive::loading)
+  {
+    v = rbd::MultiBody(std::move(bodies), std::move(joints),
+                       std::move(pred), std::move(succ), std::move(parent),
+                       std::move(Xt));
+  }
+}
+
+
+template<typename Archive>
+void serialize(Archive& ar, RobotConfig& v)
+{
+  ar(v.mb);
+  ar(v.fixedPosContacts); ar(v.fixedOriContacts);
+  ar(v.planarContacts); ar(v.ellipseContacts);
+  ar(v.gripperContacts); ar(v.cylindricalContacts);
+  ar(v.forceContacts);
+  ar(v.envCollisions); ar(v.selfCollisions);
+  ar(v.comHalfSpaces);
+  ar(v.ql); ar(v.qu);
+  ar(v.tl); ar(v.tu);
+  ar(v.tlPoly); ar(v.tuPoly);
+  ar(v.postureScale); ar(v.torqueScale); ar(v.forceScale);
+  ar(v.ellipseCostScale);
+  ar(v.bodyPosTargets); ar(v.bodyOriTargets);
+  ar(v.forceContactsMin); ar(v.torqueContactsMin);
+  ar(v.normalForceTargets); ar(v.tanForceMin);
+}
+
+
+/*
+ *   Solver parameters
+ */
+
+
+enum ParameterType
+{
+  StringParameter,
+  IntParameter,
+  DoubleParameter,
+  BoolParameter
+};
+
+
+static void write(ProblemWriter& ar, const SolverBackend::parameters_t& params)
+{
+  ar(int(params.size()));
+  for(const auto& p: params)
+  {
+    ar(p.first);
+    ar(p.second.description);
+    if(const std::string* s = boost::get<std::string>(&p.second.value))
+    {
+      ar(int(StringParameter)); ar(*s);
+    }
+    else if(const int* i = boost::get<int>(&p.second.value))
+    {
+      ar(int(IntParameter)); ar(*i);
+    }
+    else if(const double* d = boost::get<double>(&p.second.value))
+    {
+      ar(int(DoubleParameter)); ar(*d);
+    }
+    else if(const bool* b = boost::get<bool>(&p.second.value))
+    {
+      ar(int(BoolParameter)); ar(*b);
+    }
+    else
+    {
+      throw std::domain_error("Parameter " + p.first + " type is not supported");
+    }
+  }
+}
+
+
+static void read(ProblemReader& ar, SolverBackend::parameters_t& params);
+
+
+static void write(ProblemWriter& ar, const PostureGenerator::Options& o)
+{
+  write(ar, o.params);
+  ar(o.parallelUpdate);
+  ar(o.modelReduction);
+  ar(o.contactProjection);
+  ar(int(o.engine));
+  ar(o.deadline);
+  ar(o.maxIter);
+  ar(int(o.recording.mode));
+  ar(o.recording.ringSize);
+  ar(o.recording.file);
+  ar(o.profiling);
+  ar(o.tracing);
+}
+
+
+static void read(ProblemReader& ar, PostureGenerator::Options& o)
+{
+  int engine, mode;
+  read(ar, o.params);
+  ar(o.parallelUpdate);
+  ar(o.modelReduction);
+  ar(o.contactProjection);
+  ar(engine);
+  o.engine = PostureGenerator::Engine(engine);
+  ar(o.deadline);
+  ar(o.maxIter);
+  ar(mode);
+  o.recording.mode = IterateRecording::Mode(mode);
+  ar(o.recording.ringSize);
+  ar(o.recording.file);
+  ar(o.profiling);
+  ar(o.tracing);
+}
+
+
+static void read(ProblemReader& ar, SolverBackend::parameters_t& params)
+{
+  params.clear();
+  int nrParams = ar.size();
+  for(int i = 0; i < nrParams; ++i)
+  {
+    std::string name;
+    ar(name);
+    auto& param = params[name];
+    ar(param.description);
+    int type;
+    ar(type);
+    switch(type)
+    {
+      case StringParameter: { std::string v; ar(v); param.value = v; break; }
+      case IntParameter: { int v; ar(v); param.value = v; break; }
+      case DoubleParameter: { double v; ar(v); param.value = v; break; }
+      case BoolParameter: { bool v; ar(v); param.value = v; break; }
+      default:
+        throw std::runtime_error("Unknown parameter type " + std::to_string(type));
+    }
+  }
+}
+
+
+/*
+ *   Hulls
+ */
+
+
+static void addHull(std::vector<sch::S_Object*>& hulls, sch::S_Object* hull)
+{
+  if(std::find(hulls.begin(), hulls.end(), hull) == hulls.end())
+  {
+    hulls.push_back(hull);
+  }
+}
+
+
+static std::vector<sch::S_Object*> problemHulls(const CapturedProblem& problem)
+{
+  std::vector<sch::S_Object*> hulls;
+  for(const RobotConfig& rc: problem.robotConfigs)
+  {
+    for(const EnvCollision& ec: rc.envCollisions)
+    {
+      addHull(hulls, ec.bodyHull);
+      addHull(hulls, ec.envHull);
+    }
+    for(const SelfCollision& sc: rc.selfCollisions)
+    {
+      addHull(hulls, sc.body1Hull);
+      addHull(hulls, sc.body2Hull);
+    }
+  }
+  return hulls;
+}
+
+
+static void writeHull(ProblemWriter& ar, sch::S_Object* hull)
+{
+  int type = int(hull->getType());
+  ar(type);
+  if(hull->getType() == sch::S_Object::TSphere)
+  {
+    ar(static_cast<const sch::S_Sphere*>(hull)->getRadius());
+  }
+  else if(hull->getType() == sch::S_Object::TBox)
+  {
+    sch::Scalar a, b, c;
+    static_cast<const sch::S_Box*>(hull)->getBoxParameters(a, b, c);
+    ar(double(a)); ar(double(b)); ar(double(c));
+  }
+  else if(hull->getType() == sch::S_Object::TPolyhedron)
+  {
+    // vertices and triangles, the neighbors are rebuilt on load
+    const sch::Polyhedron_algorithms& poly =
+      *static_cast<sch::S_Polyhedron*>(hull)->getPolyhedronAlgorithm();
+    ar(int(poly.vertexes_.size()));
+    for(const sch::S_PolyhedronVertex* v: poly.vertexes_)
+    {
+      const sch::Vector3& p = v->getCoordinates();
+      ar(double(p[0])); ar(double(p[1])); ar(double(p[2]));
+    }
+    ar(int(poly.triangles_.size()));
+    for(const sch::PolyhedronTriangle& t: poly.triangles_)
+    {
+      ar(int(t.a)); ar(int(t.b)); ar(int(t.c));
+      ar(double(t.normal[0])); ar(double(t.normal[1])); ar(double(t.normal[2]));
+    }
+  }
+  else
+  {
+    throw std::domain_error("Hull type " + std::to_string(type) + " is not supported");
+  }
+
+  sch::Matrix4x4 T;
+  hull->getTransformationMatrix(T);
+  for(int i = 0; i < 4; ++i)
+  {
+    for(int j = 0; j < 4; ++j)
+    {
+      ar(double(T(i, j)));
+    }
+  }
+}
+
+
+static boost::shared_ptr<sch::S_Object> readHull(ProblemReader& ar)
+{
+  boost::shared_ptr<sch::S_Object> hull;
+  int type;
+  ar(type);
+  if(type == sch::S_Object::TSphere)
+  {
+    double radius;
+    ar(radius);
+    hull.reset(new sch::S_Sphere(radius));
+  }
+  else if(type == sch::S_Object::TBox)
+  {
+    double a, b, c;
+    ar(a); ar(b); ar(c);
+    hull.reset(new sch::S_Box(a, b, c));
+  }
+  else if(type == sch::S_Object::TPolyhedron)
+  {
+    boost::shared_ptr<sch::S_Polyhedron> polyHull(new sch::S_Polyhedron);
+    sch::Polyhedron_algorithms& poly = *polyHull->getPolyhedronAlgorithm();
+    int nrVertices = ar.size();
+    for(int i = 0; i < nrVertices; ++i)
+    {
+      double x, y, z;
+      ar(x); ar(y); ar(z);
+      sch::S_PolyhedronVertex* v = new sch::S_PolyhedronVertex;
+      v->setCoordinates(x, y, z);
+      v->setNumber(unsigned(i));
+      poly.vertexes_.push_back(v);
+    }
+    int nrTriangles = ar.size();
+    for(int i = 0; i < nrTriangles; ++i)
+    {
+      int a, b, c;
+      double nx, ny, nz;
+      ar(a); ar(b); ar(c);
+      ar(nx); ar(ny); ar(nz);
+      if(a < 0 || a >= nrVertices || b < 0 || b >= nrVertices ||
+         c < 0 || c >= nrVertices)
+      {
+        throw std::runtime_error("Polyhedron triangle " + std::to_string(i) +
+                                 " has an unknown vertex");
+      }
+      sch::PolyhedronTriangle t;
+      t.a = unsigned(a); t.b = unsigned(b); t.c = unsigned(c);
+      t.normal = sch::Vector3(nx, ny, nz);
+      poly.triangles_.push_back(t);
+    }
+    poly.updateVertexNeighbors();
+    polyHull->updateFastArrays();
+    hull = polyHull;
+  }
+  else
+  {
+    throw std::runtime_error("Unknown hull type " + std::to_string(type));
+  }
+
+  sch::Matrix4x4 T;
+  for(int i = 0; i < 4; ++i)
+  {
+    for(int j = 0; j < 4; ++j)
+    {
+      double v;
+      ar(v);
+      T(i, j) = v;
+    }
+  }
+  hull->setTransformation(T);
+  return hull;
+}
+
+
+/*
+ *   CapturedProblem
+ */
+
+
+CapturedProblem::CapturedProblem()
+  : gravity(Eigen::Vector3d::Zero())
+  , options()
+  , backendName()
+  , hasResult(false)
+  , resultSelection(PostureGenerator::NoResult)
+{}
+
+
+void CapturedProblem::setup(PostureGenerator& pg) const
+{
+  pg.robotConfigs(robotConfigs, gravity);
+  pg.robotLinks(robotLinks);
+  PostureGenerator::Options o(options);
+  if(o.engine == PostureGenerator::CustomEngine && !o.backend)
+  {
+    if(backendName == LMBackend().name())
+    {
+      o.backend.reset(new LMBackend);
+    }
+    else
+    {
+      o.backend.reset(new RoboptimBackend(backendName));
+    }
+  }
+  pg.options(o);
+}
+
+
+/*
+ *   File
+ */
+
+
+void saveProblem(const std::string& file, const CapturedProblem& problem)
+{
+  std::vector<sch::S_Object*> hulls = problemHulls(problem);
+  std::map<const sch::S_Object*, int> hullsIndex;
+  for(std::size_t i = 0; i < hulls.size(); ++i)
+  {
+    hullsIndex[hulls[i]] = int(i);
+  }
+
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  if(!out)
+  {
+    throw std::runtime_error("Can't open problem file " + file);
+  }
+  out.write(problemFileMagic, 4);
+  out.write(reinterpret_cast<const char*>(&problemFileVersion), sizeof(std::uint32_t));
+
+  ProblemWriter ar(out, std::move(hullsIndex));
+  ar(int(hulls.size()));
+  for(sch::S_Object* hull: hulls)
+  {
+    writeHull(ar, hull);
+  }
+
+  ar(problem.gravity);
+  ar(problem.robotConfigs);
+  ar(problem.robotLinks);
+  ar(problem.runConfigs);
+  write(ar, problem.options);
+  ar(problem.backendName);
+
+  ar(problem.hasResult);
+  if(problem.hasResult)
+  {
+    ar(int(problem.resultSelection));
+    ar(problem.x);
+    ar(problem.iterates);
+  }
+
+  if(!out)
+  {
+    throw std::runtime_error("Can't write problem file " + file);
+  }
+}
+
+
+CapturedProblem loadProblem(const std::string& file)
+{
+  std::ifstream in(file, std::ios::binary);
+  char magic[4];
+  std::uint32_t version = 0;
+  in.read(magic, 4);
+  in.read(reinterpret_cast<char*>(&version), sizeof(std::uint32_t));
+  if(!in || std::memcmp(magic, problemFileMagic, 4) != 0 ||
+     version != problemFileVersion)
+  {
+    throw std::runtime_error(file + " is not a problem file");
+  }
+
+  CapturedProblem problem;
+  ProblemReader ar(in, problem.hulls);
+  int nrHulls = ar.size();
+  for(int i = 0; i < nrHulls; ++i)
+  {
+    problem.hulls.push_back(readHull(ar));
+  }
+
+  ar(problem.gravity);
+  ar(problem.robotConfigs);
+  ar(problem.robotLinks);
+  ar(problem.runConfigs);
+  read(ar, problem.options);
+  ar(problem.backendName);
+
+  ar(problem.hasResult);
+  if(problem.hasResult)
+  {
+    int selection;
+    ar(selection);
+    problem.resultSelection = PostureGenerator::ResultSelection(selection);
+    ar(problem.x);
+    ar(problem.iterates);
+  }
+
+  return problem;
+}
+
+
+} // pg
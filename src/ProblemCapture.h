@@ -0,0 +1,94 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <string>
+#include <vector>
+
+// boost
+#include <boost/shared_ptr.hpp>
+
+// Eigen
+#include <Eigen/Core>
+
+// PG
+#include "ConfigStruct.h"
+#include "PostureGenerator.h"
+
+// forward declarations
+namespace sch
+{
+class S_Object;
+}
+
+namespace pg
+{
+
+/**
+  * Complete PostureGenerator problem, built by PostureGenerator::capture
+  * or loadProblem.
+  * A loaded problem own its hulls, it must outlive the PostureGenerator
+  * it has been set up on.
+  */
+struct CapturedProblem
+{
+  CapturedProblem();
+
+  /// Set robots, links and solver options of pg.
+  /// A loaded CustomEngine problem use a new backend named backendName
+  /// (LMBackend or a RoboptimBackend plugin).
+  void setup(PostureGenerator& pg) const;
+
+  std::vector<RobotConfig> robotConfigs;
+  Eigen::Vector3d gravity;
+  std::vector<RobotLink> robotLinks;
+  std::vector<RunConfig> runConfigs;
+
+  /// Solver parameters and options, the backend is not saved.
+  PostureGenerator::Options options;
+  /// Name of the backend used by a CustomEngine problem.
+  std::string backendName;
+
+  /// True if the solution and the stored iterates have been captured.
+  bool hasResult;
+  PostureGenerator::ResultSelection resultSelection;
+  Eigen::VectorXd x;
+  std::vector<IterateData> iterates;
+
+  /// Hulls created by loadProblem.
+  std::vector<boost::shared_ptr<sch::S_Object>> hulls;
+};
+
+
+/**
+  * Write problem in a binary file.
+  * Format (native endianness): "PGPB", uint32 version, then hulls table,
+  * robots, links, run configs, solver options and optional result.
+  * Only S_Sphere, S_Box and S_Polyhedron hulls are supported.
+  * @throw std::domain_error if a hull type is not supported.
+  * @throw std::runtime_error if file can't be written.
+  */
+void saveProblem(const std::string& file, const CapturedProblem& problem);
+
+/**
+  * Read a file written by saveProblem.
+  * @throw std::runtime_error if the file is not a problem file or is truncated.
+  */
+CapturedProblem loadProblem(const std::string& file);
+
+} // namespace pg
@@ -0,0 +1,139 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "Profiler.h"
+
+// include
+// std
+#include <iomanip>
+#include <sstream>
+
+
+namespace pg
+{
+
+
+/*
+ *                                 Profile
+ */
+
+
+double Profile::functionsTime() const
+{
+  double time = 0.;
+  for(const FunctionProfile& fp: functions)
+  {
+    time += fp.compute.time + fp.jacobian.time + fp.gradient.time;
+  }
+  return time;
+}
+
+
+double Profile::solverTime() const
+{
+  return solve.time - functionsTime();
+}
+
+
+std::string Profile::report() const
+{
+  std::ostringstream out;
+  out << std::left << std::setw(32) << "function"
+      << std::right << std::setw(10) << "compute" << std::setw(12) << "time (ms)"
+      << std::setw(10) << "jacobian" << std::setw(12) << "time (ms)"
+      << std::setw(10) << "nnz" << std::endl;
+  for(const FunctionProfile& fp: functions)
+  {
+    out << std::left << std::setw(32) << fp.name.substr(0, 31)
+        << std::right << std::setw(10) << fp.compute.calls
+        << std::setw(12) << std::fixed << std::setprecision(3) << fp.compute.time*1e3
+        << std::setw(10) << fp.jacobian.calls + fp.gradient.calls
+        << std::setw(12) << (fp.jacobian.time + fp.gradient.time)*1e3
+        << std::setw(10) << fp.jacobianNnz << std::endl;
+  }
+
+  for(std::size_t i = 0; i < robots.size(); ++i)
+  {
+    out << "robot " << i << ": fk " << robots[i].fk.calls << " calls "
+        << robots[i].fk.time*1e3 << " ms, collision "
+        << robots[i].collision.calls << " calls "
+        << robots[i].collision.time*1e3 << " ms" << std::endl;
+  }
+
+  out << "solve: " << solve.time*1e3 << " ms, functions: "
+      << functionsTime()*1e3 << " ms, solver: " << solverTime()*1e3 << " ms"
+      << std::endl;
+  return out.str();
+}
+
+
+/*
+ *                             ProfiledFunction
+ */
+
+
+ProfiledFunction::ProfiledFunction(
+    boost::shared_ptr<roboptim::DifferentiableSparseFunction> function,
+    Profile* profile, TraceBuffer* trace, int traceName)
+  : roboptim::DifferentiableSparseFunction(function->inputSize(),
+                                           function->outputSize(),
+                                           function->getName())
+  , function_(std::move(function))
+  , profile_(profile)
+  , index_(0)
+  , trace_(trace)
+  , traceName_(traceName)
+{
+  if(profile_)
+  {
+    index_ = profile_->functions.size();
+    profile_->functions.push_back({getName(), {}, {}, {}, 0});
+  }
+}
+
+
+void ProfiledFunction::impl_compute(result_t& res, const argument_t& x) const
+{
+  ScopedProfile prof(counter(&FunctionProfile::compute));
+  ScopedTrace trace(trace_, traceName_, Tracer::Compute);
+  (*function_)(res, x);
+}
+
+
+void ProfiledFunction::impl_jacobian(jacobian_t& jac, const argument_t& x) const
+{
+  {
+    ScopedProfile prof(counter(&FunctionProfile::jacobian));
+    ScopedTrace trace(trace_, traceName_, Tracer::Jacobian);
+    function_->jacobian(jac, x);
+  }
+  if(profile_)
+  {
+    profile_->functions[index_].jacobianNnz = int(jac.nonZeros());
+  }
+}
+
+
+void ProfiledFunction::impl_gradient(gradient_t& gradient,
+    const argument_t& x, size_type functionId) const
+{
+  ScopedProfile prof(counter(&FunctionProfile::gradient));
+  ScopedTrace trace(trace_, traceName_, Tracer::Gradient);
+  function_->gradient(gradient, x, functionId);
+}
+
+
+} // pg
@@ -0,0 +1,152 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <chrono>
+#include <string>
+#include <vector>
+
+// roboptim
+#include <roboptim/core/differentiable-function.hh>
+
+// PG
+#include "Tracer.h"
+
+
+namespace pg
+{
+
+/// Number of calls and accumulated time (in seconds) of a profiled code.
+struct ProfileCounter
+{
+  ProfileCounter()
+    : calls(0)
+    , time(0.)
+  {}
+
+  int calls;
+  double time;
+};
+
+
+/// Evaluations of a cost or constraint function.
+struct FunctionProfile
+{
+  std::string name;
+  ProfileCounter compute, jacobian, gradient;
+  /// Non zeros of the last computed jacobian.
+  int jacobianNnz;
+};
+
+
+/// Robot update, each robot can be updated on its own thread.
+struct RobotProfile
+{
+  /// Forward kinematics.
+  ProfileCounter fk;
+  /// Collision queries of the collision constraints.
+  ProfileCounter collision;
+};
+
+
+/// Counters of a PostureGenerator::run.
+struct Profile
+{
+  std::vector<FunctionProfile> functions;
+  std::vector<RobotProfile> robots;
+  /// Solver call (functions evaluations included).
+  ProfileCounter solve;
+
+  /// Time spent in functions evaluation.
+  double functionsTime() const;
+  /// Time spent inside the solver (solve time minus functions evaluation).
+  double solverTime() const;
+  /// Human readable report.
+  std::string report() const;
+};
+
+
+/// Add the lifetime of this object to counter, do nothing if counter is null.
+class ScopedProfile
+{
+public:
+  typedef std::chrono::steady_clock clock;
+
+public:
+  ScopedProfile(ProfileCounter* counter)
+    : counter_(counter)
+  {
+    if(counter_)
+    {
+      start_ = clock::now();
+    }
+  }
+
+  ~ScopedProfile()
+  {
+    if(counter_)
+    {
+      ++counter_->calls;
+      counter_->time += std::chrono::duration<double>(clock::now() - start_).count();
+    }
+  }
+
+  ScopedProfile(const ScopedProfile&) = delete;
+  ScopedProfile& operator=(const ScopedProfile&) = delete;
+
+private:
+  ProfileCounter* counter_;
+  clock::time_point start_;
+};
+
+
+/**
+  * Forward evaluations to a function and record them in a new
+  * Profile::functions entry and as traceName spans in trace.
+  * profile and trace can be null, otherwise they must outlive this function
+  * and profile functions must not be resized by others during this function life.
+  */
+class ProfiledFunction : public roboptim::DifferentiableSparseFunction
+{
+public:
+  typedef typename parent_t::argument_t argument_t;
+
+public:
+  ProfiledFunction(boost::shared_ptr<roboptim::DifferentiableSparseFunction> function,
+                   Profile* profile, TraceBuffer* trace=nullptr, int traceName=0);
+
+  void impl_compute(result_t& res, const argument_t& x) const;
+  void impl_jacobian(jacobian_t& jac, const argument_t& x) const;
+  void impl_gradient(gradient_t& gradient,
+      const argument_t& x, size_type functionId) const;
+
+private:
+  ProfileCounter* counter(ProfileCounter FunctionProfile::* c) const
+  {
+    return profile_ ? &(profile_->functions[index_].*c) : nullptr;
+  }
+
+private:
+  boost::shared_ptr<roboptim::DifferentiableSparseFunction> function_;
+  Profile* profile_;
+  std::size_t index_;
+  TraceBuffer* trace_;
+  int traceName_;
+};
+
+} // namespace pg
@@ -0,0 +1,510 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "ReachabilityMap.h"
+
+// include
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+// boost
+#include <boost/math/constants/constants.hpp>
+
+// RBDyn
+#include <RBDyn/FK.h>
+#include <RBDyn/MultiBody.h>
+#include <RBDyn/MultiBodyConfig.h>
+
+
+namespace pg
+{
+
+static const char reachabilityFileMagic[4] = {'P', 'G', 'R', 'M'};
+static const std::uint32_t reachabilityFileVersion = 1;
+
+const int ReachabilityMap::nrBands;
+const int ReachabilityMap::nrSectors;
+
+
+/*
+ *   ReachabilityMap
+ */
+
+
+ReachabilityMap::ReachabilityMap()
+  : bodyId_(-1)
+  , axis_(Eigen::Vector3d::UnitZ())
+  , origin_(Eigen::Vector3d::Zero())
+  , voxelSize_(1.)
+  , size_(0)
+  , voxels_()
+{}
+
+
+ReachabilityMap::ReachabilityMap(int bodyId, const Eigen::Vector3d& axis,
+                                 double voxelSize, double halfSize)
+  : bodyId_(bodyId)
+  , axis_(axis.normalized())
+  , origin_()
+  , voxelSize_(voxelSize)
+  , size_(2*int(std::ceil(halfSize/voxelSize)) + 1)
+  , voxels_(std::size_t(size_)*size_*size_, 0)
+{
+  origin_.setConstant(-voxelSize_*(size_ - 1)/2.);
+}
+
+
+int ReachabilityMap::nrReached() const
+{
+  return int(std::count_if(voxels_.begin(), voxels_.end(),
+                           [](std::uint64_t v) {return v != 0;}));
+}
+
+
+void ReachabilityMap::add(const Eigen::Vector3d& pos, const Eigen::Vector3d& dir)
+{
+  std::ptrdiff_t index = voxel(pos);
+  if(index >= 0)
+  {
+    voxels_[std::size_t(index)] |= std::uint64_t(1) << bin(dir);
+  }
+}
+
+
+void ReachabilityMap::merge(const ReachabilityMap& other)
+{
+  if(other.size_ != size_ || other.voxelSize_ != voxelSize_ ||
+     other.origin_ != origin_)
+  {
+    throw std::domain_error("Reachability maps don't have the same grid");
+  }
+  for(std::size_t i = 0; i < voxels_.size(); ++i)
+  {
+    voxels_[i] |= other.voxels_[i];
+  }
+}
+
+
+bool ReachabilityMap::reachable(const Eigen::Vector3d& pos, double radius) const
+{
+  return reachable(pos, radius, ~std::uint64_t(0));
+}
+
+
+bool ReachabilityMap::reachable(const Eigen::Vector3d& pos, double radius,
+                                const Eigen::Vector3d& dir) const
+{
+  return reachable(pos, radius, neighborBins(dir));
+}
+
+
+int ReachabilityMap::bin(const Eigen::Vector3d& dir)
+{
+  namespace cst = boost::math::constants;
+
+  // bands of equal height on the z axis have the same area on the sphere
+  Eigen::Vector3d d(dir.normalized());
+  int band = std::min(int((d.z() + 1.)/2.*nrBands), nrBands - 1);
+  double angle = std::atan2(d.y(), d.x()) + cst::pi<double>();
+  int sector = std::min(int(angle/(2.*cst::pi<double>())*nrSectors), nrSectors - 1);
+  return std::max(band, 0)*nrSectors + std::max(sector, 0);
+}
+
+
+std::ptrdiff_t ReachabilityMap::voxel(const Eigen::Vector3d& pos) const
+{
+  Eigen::Vector3d index((pos - origin_)/voxelSize_);
+  int i = int(std::round(index.x()));
+  int j = int(std::round(index.y()));
+  int k = int(std::round(index.z()));
+  if(i < 0 || j < 0 || k < 0 || i >= size_ || j >= size_ || k >= size_)
+  {
+    return -1;
+  }
+  return std::ptrdiff_t((std::size_t(i)*size_ + j)*size_ + k);
+}
+
+
+std::uint64_t ReachabilityMap::neighborBins(const Eigen::Vector3d& dir)
+{
+  int b = bin(dir);
+  int band = b/nrSectors;
+  int sector = b%nrSectors;
+  std::uint64_t bins = 0;
+  for(int i = std::max(band - 1, 0); i <= std::min(band + 1, nrBands - 1); ++i)
+  {
+    // the polar bands sectors meet at the pole
+    bool polar = i == 0 || i == nrBands - 1;
+    for(int j = -1; j <= 1; ++j)
+    {
+      for(int s = 0; s < nrSectors; ++s)
+      {
+        if(polar || s == (sector + j + nrSectors)%nrSectors)
+        {
+          bins |= std::uint64_t(1) << (i*nrSectors + s);
+        }
+      }
+    }
+  }
+  return bins;
+}
+
+
+bool ReachabilityMap::reachable(const Eigen::Vector3d& pos, double radius,
+                                std::uint64_t bins) const
+{
+  if(size_ == 0)
+  {
+    return false;
+  }
+
+  // voxels whose cube can intersect the ball
+  double half = voxelSize_/2.;
+  Eigen::Vector3d lo((pos.array() - radius - half - origin_.array())/voxelSize_);
+  Eigen::Vector3d hi((pos.array() + radius + half - origin_.array())/voxelSize_);
+  int lower[3], upper[3];
+  for(int a = 0; a < 3; ++a)
+  {
+    lower[a] = std::max(int(std::ceil(lo[a])), 0);
+    upper[a] = std::min(int(std::floor(hi[a])), size_ - 1);
+  }
+
+  for(int i = lower[0]; i <= upper[0]; ++i)
+  {
+    for(int j = lower[1]; j <= upper[1]; ++j)
+    {
+      for(int k = lower[2]; k <= upper[2]; ++k)
+      {
+        if(!(voxels_[(std::size_t(i)*size_ + j)*size_ + k] & bins))
+        {
+          continue;
+        }
+        // distance between pos and the voxel cube
+        Eigen::Vector3d center(origin_ + voxelSize_*Eigen::Vector3d(i, j, k));
+        Eigen::Vector3d d(((pos - center).cwiseAbs().array() - half).max(0.));
+        if(d.norm() <= radius)
+        {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+
+/*
+ *   Sampling
+ */
+
+
+/// Sample the parameters of joint between its limits.
+template<typename Gen>
+static void sampleJoint(const rbd::Joint& joint, const std::vector<double>& ql,
+                 const std::vector<double>& qu, Gen& gen, std::vector<double>& q)
+{
+  namespace cst = boost::math::constants;
+
+  std::uniform_real_distribution<double> unit(0., 1.);
+  switch(joint.type())
+  {
+    case rbd::Joint::Free:
+    case rbd::Joint::Fixed:
+      q = joint.zeroParam();
+      return;
+    case rbd::Joint::Spherical:
+    {
+      // normalized gaussian vector is an uniform unit quaternion
+      std::normal_distribution<double> normal;
+      Eigen::Vector4d quat(normal(gen), normal(gen), normal(gen), normal(gen));
+      quat.normalize();
+      q = {quat[0], quat[1], quat[2], quat[3]};
+      return;
+    }
+    default:
+      break;
+  }
+
+  q.resize(joint.params());
+  for(int i = 0; i < joint.params(); ++i)
+  {
+    // Rev, Cylindrical first and Planar first parameters are rotations
+    bool rotation = joint.type() == rbd::Joint::Rev ||
+      (i == 0 && (joint.type() == rbd::Joint::Cylindrical ||
+                  joint.type() == rbd::Joint::Planar));
+    double lo = rotation ? -cst::pi<double>() : 0.;
+    double hi = rotation ? cst::pi<double>() : 0.;
+    if(std::size_t(i) < ql.size() && std::isfinite(ql[i]))
+    {
+      lo = ql[i];
+    }
+    if(std::size_t(i) < qu.size() && std::isfinite(qu[i]))
+    {
+      hi = qu[i];
+    }
+    q[i] = lo + (hi - lo)*unit(gen);
+  }
+}
+
+
+/// @return Translation range of joint between its limits.
+static double translationRange(const rbd::Joint& joint, const std::vector<double>& ql,
+                               const std::vector<double>& qu)
+{
+  int begin = 0;
+  if(joint.type() == rbd::Joint::Cylindrical || joint.type() == rbd::Joint::Planar)
+  {
+    begin = 1;
+  }
+  else if(joint.type() != rbd::Joint::Prism)
+  {
+    return 0.;
+  }
+
+  double range = 0.;
+  for(int i = begin; i < joint.params(); ++i)
+  {
+    double lo = std::size_t(i) < ql.size() && std::isfinite(ql[i]) ? ql[i] : 0.;
+    double hi = std::size_t(i) < qu.size() && std::isfinite(qu[i]) ? qu[i] : 0.;
+    range += std::max(std::abs(lo), std::abs(hi));
+  }
+  return range;
+}
+
+
+std::vector<ReachabilityMap> buildReachabilityMaps(
+  const rbd::MultiBody& mb,
+  const std::vector<std::vector<double>>& ql,
+  const std::vector<std::vector<double>>& qu,
+  const std::vector<int>& bodyIds,
+  const std::vector<Eigen::Vector3d>& axes,
+  const ReachabilityConfig& config)
+{
+  if(bodyIds.size() != axes.size())
+  {
+    throw std::domain_error("bodyIds and axes must have the same size");
+  }
+
+  static const std::vector<double> noLimit;
+  auto limit = [](const std::vector<std::vector<double>>& l, int i)
+    -> const std::vector<double>&
+  {
+    return std::size_t(i) < l.size() ? l[i] : noLimit;
+  };
+
+  // upper bound of the distance between the root and each body
+  std::vector<double> reach(mb.nrBodies(), 0.);
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    int parent = mb.parent(i);
+    reach[i] = (parent == -1 ? 0. : reach[parent]) +
+      mb.transform(i).translation().norm() +
+      translationRange(mb.joint(i), limit(ql, i), limit(qu, i));
+  }
+
+  std::vector<ReachabilityMap> maps;
+  std::vector<int> bodyIndex;
+  for(std::size_t i = 0; i < bodyIds.size(); ++i)
+  {
+    bodyIndex.push_back(mb.bodyIndexById(bodyIds[i]));
+    maps.emplace_back(bodyIds[i], axes[i], config.voxelSize,
+                      reach[bodyIndex.back()] + config.voxelSize);
+  }
+
+  int nrThreads = config.nrThreads > 0 ? config.nrThreads :
+    std::max(int(std::thread::hardware_concurrency()), 1);
+  // the reached voxels are a thin shell of the grid, each thread only keep
+  // its reached voxels bins instead of a full grid copy
+  typedef std::unordered_map<std::size_t, std::uint64_t> ReachedVoxels;
+  std::vector<std::vector<ReachedVoxels>> threadReached(
+    nrThreads, std::vector<ReachedVoxels>(maps.size()));
+  auto sample = [&](int t)
+  {
+    std::mt19937 gen(config.seed + unsigned(t));
+    rbd::MultiBodyConfig mbc(mb);
+    mbc.zero(mb);
+    int nrSamples = config.nrSamples/nrThreads + (t < config.nrSamples%nrThreads ? 1 : 0);
+    for(int s = 0; s < nrSamples; ++s)
+    {
+      for(int i = 0; i < mb.nrJoints(); ++i)
+      {
+        sampleJoint(mb.joint(i), limit(ql, i), limit(qu, i), gen, mbc.q[i]);
+      }
+      rbd::forwardKinematics(mb, mbc);
+      for(std::size_t m = 0; m < maps.size(); ++m)
+      {
+        const ReachabilityMap& map = maps[m];
+        const sva::PTransformd& X = mbc.bodyPosW[bodyIndex[m]];
+        std::ptrdiff_t index = map.voxel(X.translation());
+        if(index >= 0)
+        {
+          threadReached[t][m][std::size_t(index)] |=
+            std::uint64_t(1) << ReachabilityMap::bin(X.rotation().transpose()*map.axis());
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for(int t = 1; t < nrThreads; ++t)
+  {
+    threads.emplace_back(sample, t);
+  }
+  sample(0);
+  for(std::thread& t: threads)
+  {
+    t.join();
+  }
+
+  for(int t = 0; t < nrThreads; ++t)
+  {
+    for(std::size_t m = 0; m < maps.size(); ++m)
+    {
+      for(const auto& v: threadReached[t][m])
+      {
+        maps[m].voxels_[v.first] |= v.second;
+      }
+    }
+  }
+  return maps;
+}
+
+
+/*
+ *   File
+ */
+
+
+template<typename T>
+static void writeValue(std::ostream& out, const T& v)
+{
+  out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+
+template<typename T>
+static T readValue(std::istream& in)
+{
+  T v;
+  in.read(reinterpret_cast<char*>(&v), sizeof(T));
+  if(!in)
+  {
+    throw std::runtime_error("Truncated reachability maps file");
+  }
+  return v;
+}
+
+
+void saveReachabilityMaps(const std::string& file,
+                          const std::vector<ReachabilityMap>& maps)
+{
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  if(!out)
+  {
+    throw std::runtime_error("Can't open reachability maps file " + file);
+  }
+
+  out.write(reachabilityFileMagic, 4);
+  writeValue(out, reachabilityFileVersion);
+  writeValue(out, std::uint32_t(maps.size()));
+  for(const ReachabilityMap& map: maps)
+  {
+    writeValue(out, std::int32_t(map.bodyId_));
+    for(int i = 0; i < 3; ++i)
+    {
+      writeValue(out, map.axis_[i]);
+    }
+    for(int i = 0; i < 3; ++i)
+    {
+      writeValue(out, map.origin_[i]);
+    }
+    writeValue(out, map.voxelSize_);
+    writeValue(out, std::int32_t(map.size_));
+    // only reached voxels are written
+    writeValue(out, std::uint32_t(map.nrReached()));
+    for(std::size_t i = 0; i < map.voxels_.size(); ++i)
+    {
+      if(map.voxels_[i])
+      {
+        writeValue(out, std::uint32_t(i));
+        writeValue(out, map.voxels_[i]);
+      }
+    }
+  }
+
+  if(!out)
+  {
+    throw std::runtime_error("Can't write reachability maps file " + file);
+  }
+}
+
+
+std::vector<ReachabilityMap> loadReachabilityMaps(const std::string& file)
+{
+  std::ifstream in(file, std::ios::binary);
+  char magic[4];
+  in.read(magic, 4);
+  if(!in || std::memcmp(magic, reachabilityFileMagic, 4) != 0 ||
+     readValue<std::uint32_t>(in) != reachabilityFileVersion)
+  {
+    throw std::runtime_error(file + " is not a reachability maps file");
+  }
+
+  std::vector<ReachabilityMap> maps(readValue<std::uint32_t>(in));
+  for(ReachabilityMap& map: maps)
+  {
+    map.bodyId_ = readValue<std::int32_t>(in);
+    for(int i = 0; i < 3; ++i)
+    {
+      map.axis_[i] = readValue<double>(in);
+    }
+    for(int i = 0; i < 3; ++i)
+    {
+      map.origin_[i] = readValue<double>(in);
+    }
+    map.voxelSize_ = readValue<double>(in);
+    map.size_ = readValue<std::int32_t>(in);
+    if(map.size_ < 0 || map.voxelSize_ <= 0.)
+    {
+      throw std::runtime_error(file + " is not a reachability maps file");
+    }
+    map.voxels_.assign(std::size_t(map.size_)*map.size_*map.size_, 0);
+
+    std::uint32_t nrReached = readValue<std::uint32_t>(in);
+    for(std::uint32_t i = 0; i < nrReached; ++i)
+    {
+      std::uint32_t index = readValue<std::uint32_t>(in);
+      std::uint64_t bins = readValue<std::uint64_t>(in);
+      if(index >= map.voxels_.size())
+      {
+        throw std::runtime_error(file + " is not a reachability maps file");
+      }
+      map.voxels_[index] = bins;
+    }
+  }
+  return maps;
+}
+
+
+} // pg
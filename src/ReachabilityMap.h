@@ -0,0 +1,178 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// forward declarations
+namespace rbd
+{
+class MultiBody;
+}
+
+namespace pg
+{
+
+struct ReachabilityConfig
+{
+  ReachabilityConfig(double vSize=0.05, int nrS=1000000, int nrT=0, unsigned s=0)
+    : voxelSize(vSize)
+    , nrSamples(nrS)
+    , nrThreads(nrT)
+    , seed(s)
+  {}
+
+  double voxelSize;
+  int nrSamples;
+  /// 0 use one thread per hardware thread.
+  int nrThreads;
+  unsigned seed;
+};
+
+
+/**
+  * Voxels reached by a body origin in robot root frame, with the
+  * discretized directions of a body axis in each voxel.
+  * Directions are binned in 6 equal area bands of 10 sectors.
+  */
+class ReachabilityMap
+{
+public:
+  static const int nrBands = 6;
+  static const int nrSectors = 10;
+
+public:
+  ReachabilityMap();
+  /// Empty map of the cube of half size halfSize centered on the root.
+  ReachabilityMap(int bodyId, const Eigen::Vector3d& axis,
+                  double voxelSize, double halfSize);
+
+  int bodyId() const
+  {
+    return bodyId_;
+  }
+
+  /// Body axis (body coordinate) of the directions bins.
+  const Eigen::Vector3d& axis() const
+  {
+    return axis_;
+  }
+
+  double voxelSize() const
+  {
+    return voxelSize_;
+  }
+
+  /// Number of reached voxels.
+  int nrReached() const;
+
+  /// Mark the voxel of pos as reached with the body axis direction dir (world).
+  void add(const Eigen::Vector3d& pos, const Eigen::Vector3d& dir);
+  /// Reached voxels and directions of both maps.
+  /// @throw std::domain_error if the maps don't have the same grid.
+  void merge(const ReachabilityMap& other);
+
+  /**
+    * @return true if a reached voxel is at most radius from pos.
+    * Positions outside the map are unreachable.
+    */
+  bool reachable(const Eigen::Vector3d& pos, double radius) const;
+  /// Same as above with a direction of the body axis in the bin of dir
+  /// or in one of its neighbours.
+  bool reachable(const Eigen::Vector3d& pos, double radius,
+                 const Eigen::Vector3d& dir) const;
+
+  /// Direction bin of dir.
+  static int bin(const Eigen::Vector3d& dir);
+
+private:
+  friend void saveReachabilityMaps(const std::string& file,
+                                   const std::vector<ReachabilityMap>& maps);
+  friend std::vector<ReachabilityMap> loadReachabilityMaps(const std::string& file);
+  friend std::vector<ReachabilityMap> buildReachabilityMaps(
+    const rbd::MultiBody& mb,
+    const std::vector<std::vector<double>>& ql,
+    const std::vector<std::vector<double>>& qu,
+    const std::vector<int>& bodyIds,
+    const std::vector<Eigen::Vector3d>& axes,
+    const ReachabilityConfig& config);
+
+  /// Index in voxels_ of the voxel of pos, -1 if pos is out of the map.
+  std::ptrdiff_t voxel(const Eigen::Vector3d& pos) const;
+  /// Bins of dir and its neighbours.
+  static std::uint64_t neighborBins(const Eigen::Vector3d& dir);
+  bool reachable(const Eigen::Vector3d& pos, double radius, std::uint64_t bins) const;
+
+private:
+  int bodyId_;
+  Eigen::Vector3d axis_;
+  /// Center of the voxel (0, 0, 0).
+  Eigen::Vector3d origin_;
+  double voxelSize_;
+  int size_;
+  /// Directions bins of each voxel, 0 if not reached.
+  std::vector<std::uint64_t> voxels_;
+};
+
+
+/// Contact of a robot whose target is out of its body reachability map.
+struct UnreachableContact
+{
+  int robot;
+  int bodyId;
+  Eigen::Vector3d target;
+};
+
+
+/**
+  * Sample the configurations of mb between ql and qu (joint limits by
+  * joints, missing or infinite limits are [-pi, pi] for rotations and 0 for
+  * translations) on config.nrThreads threads and build the map of each
+  * body of bodyIds with its axis of the same index.
+  * A free root joint stay at its zero configuration, maps are then in the
+  * root body frame.
+  */
+std::vector<ReachabilityMap> buildReachabilityMaps(
+  const rbd::MultiBody& mb,
+  const std::vector<std::vector<double>>& ql,
+  const std::vector<std::vector<double>>& qu,
+  const std::vector<int>& bodyIds,
+  const std::vector<Eigen::Vector3d>& axes,
+  const ReachabilityConfig& config=ReachabilityConfig());
+
+/**
+  * Write maps in a binary file.
+  * Format (native endianness): "PGRM", uint32 version, uint32 number of maps,
+  * then for each map: int32 body id, 3 doubles axis, 3 doubles origin,
+  * double voxel size, int32 grid size, uint32 number of reached voxels and
+  * for each reached voxel its uint32 index and uint64 directions bins.
+  * @throw std::runtime_error if file can't be written.
+  */
+void saveReachabilityMaps(const std::string& file,
+                          const std::vector<ReachabilityMap>& maps);
+
+/// @throw std::runtime_error if the file is not a reachability maps file.
+std::vector<ReachabilityMap> loadReachabilityMaps(const std::string& file);
+
+} // namespace pg
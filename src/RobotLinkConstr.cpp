@@ -17,16 +17,46 @@
 #include "RobotLinkConstr.h"
 
 // include
+// std
+#include <algorithm>
+#include <cmath>
+
+// SpaceVecAlg
+#include <SpaceVecAlg/SpaceVecAlg>
+
 // PG
 #include "ConfigStruct.h"
 #include "PGData.h"
-#include "FillSparse.h"
 
 
 namespace pg
 {
 
 
+/// @return log(E1^T E2), rotation vector in world frame from the second
+/// body frame to the first one.
+static Eigen::Vector3d rotationLinkError(const Eigen::Matrix3d& E1, const Eigen::Matrix3d& E2)
+{
+  return sva::rotationVelocity<double>(E2.transpose()*E1);
+}
+
+
+/// Derivative of rotationLinkError relative to the first body angular velocity,
+/// the inverse of the SO(3) left jacobian of the error e.
+/// The derivative relative to the second body angular velocity is -L^T.
+static Eigen::Matrix3d rotationLinkErrorJac(const Eigen::Vector3d& e)
+{
+  double theta = e.norm();
+  // 1/theta^2 - (1 + cos(theta))/(2 theta sin(theta)) tend to 1/12 at 0
+  // and diverge at pi where the log is not differentiable
+  double c = theta < 1e-4 ? 1./12. + theta*theta/720. :
+    1./(theta*theta) -
+    (1. + std::cos(theta))/(2.*theta*std::max(std::sin(theta), 1e-8));
+  Eigen::Matrix3d S(sva::vector3ToCrossMatrix<double>(e));
+  return Eigen::Matrix3d::Identity() - 0.5*S + c*S*S;
+}
+
+
 /*
  *                 RobotLinkConstr
  */
@@ -39,20 +69,26 @@ RobotLinkConstr::RobotLinkConstr(PGData* pgdata1, PGData* pgdata2,
                                            "RobotLink")
   , pgdata1_(pgdata1)
   , pgdata2_(pgdata2)
-  , nrNonZero_(0)
   , links_()
+  , pattern_(int(6*linkedBodies.size()), pgdata1->pbSize())
 {
-  for(const BodyLink& link: linkedBodies)
+  for(std::size_t i = 0; i < linkedBodies.size(); ++i)
   {
+    const BodyLink& link = linkedBodies[i];
     rbd::Jacobian jac1(pgdata1_->mb(), link.bodyId, link.body1T.translation());
     rbd::Jacobian jac2(pgdata2_->mb(), link.bodyId, link.body2T.translation());
     Eigen::MatrixXd jacMat1(6, jac1.dof());
     Eigen::MatrixXd jacMat2(6, jac2.dof());
 
-    links_.push_back({link.body1T, link.body2T, jac1, jac2, jacMat1, jacMat2});
+    int block1 = pattern_.addJacobian(pgdata1_->mb(), jac1, 6,
+                                      {int(i*6), pgdata1_->qParamsBegin()});
+    int block2 = pattern_.addJacobian(pgdata2_->mb(), jac2, 6,
+                                      {int(i*6), pgdata2_->qParamsBegin()});
 
-    nrNonZero_ += jac1.dof()*6 + jac2.dof()*6;
+    links_.push_back({link.body1T, link.body2T, jac1, jac2, jacMat1, jacMat2,
+                      block1, block2});
   }
+  pattern_.finalize();
 }
 
 
@@ -74,27 +110,18 @@ void RobotLinkConstr::impl_compute(result_t& res, const argument_t& x) const
     sva::PTransformd body1 = link.body1T*pgdata1_->mbc().bodyPosW[index1];
     sva::PTransformd body2 = link.body2T*pgdata2_->mbc().bodyPosW[index2];
 
-    Eigen::Vector3d posErr = body1.translation() - body2.translation();
-    /// @todo try to use rotation error
-    Eigen::Vector3d rotErr;
-    rotErr(0) = body1.rotation().row(0).dot(body2.rotation().row(0));
-    rotErr(1) = body1.rotation().row(1).dot(body2.rotation().row(1));
-    rotErr(2) = body1.rotation().row(2).dot(body2.rotation().row(2));
-
-    res.segment<3>(i*6) = rotErr;
-    res.segment<3>(i*6 + 3) = posErr;
+    res.segment<3>(i*6) = rotationLinkError(body1.rotation(), body2.rotation());
+    res.segment<3>(i*6 + 3) = body1.translation() - body2.translation();
   }
 }
 
 
 void RobotLinkConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
 {
-  jac.reserve(nrNonZero_);
-  jac.setZero();
-
   pgdata1_->x(x);
   pgdata2_->x(x);
 
+  pattern_.setZero();
   for(std::size_t i = 0; i < links_.size(); ++i)
   {
     LinkData& link = links_[i];
@@ -104,33 +131,22 @@ void RobotLinkConstr::impl_jacobian(jacobian_t& jac, const argument_t& x) const
     sva::PTransformd body1 = link.body1T*pgdata1_->mbc().bodyPosW[index1];
     sva::PTransformd body2 = link.body2T*pgdata2_->mbc().bodyPosW[index2];
 
-    link.jacMat1.block(3, 0, 3, link.jac1.dof()).noalias() =
-      link.jac1.jacobian(pgdata1_->mb(), pgdata1_->mbc()).block(3, 0, 3, link.jac1.dof());
-    link.jacMat2.block(3, 0, 3, link.jac2.dof()).noalias() =
-      -link.jac2.jacobian(pgdata2_->mb(), pgdata2_->mbc()).block(3, 0, 3, link.jac2.dof());
-
-    for(int j = 0; j < 3; ++j)
-    {
-      Eigen::Vector3d axis(Eigen::Vector3d::Zero());
-      axis(j) = 1.;
-
-      const Eigen::MatrixXd& mat1 =
-          link.jac1.vectorJacobian(pgdata1_->multibody(), pgdata1_->mbc(),
-                                   link.body1T.rotation().row(j).transpose());
-      link.jacMat1.row(j).noalias() = body2.rotation().row(j)*mat1.block(3, 0, 3, mat1.cols());
-      const Eigen::MatrixXd& mat2 =
-          link.jac2.vectorJacobian(pgdata2_->multibody(), pgdata2_->mbc(),
-                                   link.body2T.rotation().row(j).transpose());
-      link.jacMat2.row(j).noalias() = body1.rotation().row(j)*mat2.block(3, 0, 3, mat2.cols());
-    }
-
-    incrementFullJacobianSparse(pgdata1_->mb(), link.jac1, link.jacMat1, jac,
-                             {i*6, pgdata1_->qParamsBegin()});
-    incrementFullJacobianSparse(pgdata2_->mb(), link.jac2, link.jacMat2, jac,
-                             {i*6, pgdata2_->qParamsBegin()});
+    // angular velocity rows are in world frame
+    const Eigen::MatrixXd& jacMat1 = link.jac1.jacobian(pgdata1_->mb(), pgdata1_->mbc());
+    const Eigen::MatrixXd& jacMat2 = link.jac2.jacobian(pgdata2_->mb(), pgdata2_->mbc());
+    Eigen::Matrix3d L =
+      rotationLinkErrorJac(rotationLinkError(body1.rotation(), body2.rotation()));
+
+    link.jacMat1.topRows<3>().noalias() = L*jacMat1.topRows<3>();
+    link.jacMat1.bottomRows<3>() = jacMat1.bottomRows<3>();
+    link.jacMat2.topRows<3>().noalias() = -L.transpose()*jacMat2.topRows<3>();
+    link.jacMat2.bottomRows<3>() = -jacMat2.bottomRows<3>();
+
+    pattern_.add(link.block1, link.jacMat1);
+    pattern_.add(link.block2, link.jacMat2);
   }
+  pattern_.copyTo(jac);
 }
 
 
 } // pg
-
@@ -22,12 +22,22 @@
 // RBDyn
 #include <RBDyn/Jacobian.h>
 
+// PG
+#include "FillSparse.h"
+
 
 namespace pg
 {
 class PGData;
 class BodyLink;
 
+/**
+  * Link a body of a robot to a body of another robot.
+  * For each link the constraint is 6 dimensional:
+  * the rotation error e = log(R1 R2^T) where R are the body frames
+  * orientations in world frame, and the position error.
+  * Both are 0 only when the two bodies frames match.
+  */
 class RobotLinkConstr : public roboptim::DifferentiableSparseFunction
 {
 public:
@@ -52,12 +62,13 @@ private:
     sva::PTransformd body1T, body2T;
     rbd::Jacobian jac1, jac2;
     Eigen::MatrixXd jacMat1, jacMat2;
+    int block1, block2;
   };
 
 private:
   PGData* pgdata1_, *pgdata2_;
-  int nrNonZero_;
   mutable std::vector<LinkData> links_;
+  mutable SparsePattern pattern_;
 };
 
 
@@ -0,0 +1,97 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "RunHandle.h"
+
+// include
+// std
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+
+namespace pg
+{
+
+
+RunHandle::State::State()
+  : cancel(std::make_shared<std::atomic<bool>>(false))
+  , mutex()
+  , progress{0, std::numeric_limits<double>::quiet_NaN(),
+             std::numeric_limits<double>::quiet_NaN()}
+{}
+
+
+RunHandle::RunHandle()
+  : state_()
+  , result_()
+{}
+
+
+bool RunHandle::valid() const
+{
+  return result_.valid();
+}
+
+
+void RunHandle::cancel()
+{
+  if(state_)
+  {
+    *state_->cancel = true;
+  }
+}
+
+
+bool RunHandle::done() const
+{
+  return wait(0.);
+}
+
+
+bool RunHandle::wait(double seconds) const
+{
+  if(!valid())
+  {
+    throw std::logic_error("Invalid RunHandle");
+  }
+  return result_.wait_for(std::chrono::duration<double>(seconds)) ==
+    std::future_status::ready;
+}
+
+
+bool RunHandle::get() const
+{
+  if(!valid())
+  {
+    throw std::logic_error("Invalid RunHandle");
+  }
+  return result_.get();
+}
+
+
+RunHandle::Progress RunHandle::progress() const
+{
+  if(!state_)
+  {
+    return State().progress;
+  }
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->progress;
+}
+
+
+} // pg
@@ -0,0 +1,86 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+
+
+namespace pg
+{
+class PostureGenerator;
+
+/**
+  * Handle on a PostureGenerator::runAsync call.
+  * The PostureGenerator must not be used until the run is done,
+  * results are then read from it as after run.
+  * Copies share the same run. Destroying the last copy wait the end of the run.
+  */
+class RunHandle
+{
+public:
+  struct Progress
+  {
+    int nrIters;
+    double obj, constr_viol;
+  };
+
+public:
+  /// Invalid handle.
+  RunHandle();
+
+  bool valid() const;
+
+  /// Ask the solver to stop at its next iteration, the run then behave
+  /// like if its deadline was reached. Do nothing on an invalid handle.
+  void cancel();
+
+  /// @throw std::logic_error on an invalid handle.
+  bool done() const;
+  /// Wait at most seconds.
+  /// @return true if the run is done.
+  /// @throw std::logic_error on an invalid handle.
+  bool wait(double seconds) const;
+  /// Wait the end of the run.
+  /// @return run result, rethrow the run exception if any.
+  /// @throw std::logic_error on an invalid handle.
+  bool get() const;
+
+  /// Last recorded iterate, no iterate on an invalid handle.
+  Progress progress() const;
+
+private:
+  friend class PostureGenerator;
+
+  struct State
+  {
+    State();
+
+    std::shared_ptr<std::atomic<bool>> cancel;
+    mutable std::mutex mutex;
+    Progress progress;
+  };
+
+private:
+  std::shared_ptr<State> state_;
+  std::shared_future<bool> result_;
+};
+
+} // namespace pg
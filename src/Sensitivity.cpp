@@ -0,0 +1,324 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "Sensitivity.h"
+
+// include
+// std
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+// Eigen
+#include <Eigen/Geometry>
+#include <Eigen/LU>
+
+// PG
+#include "FixedContactConstr.h"
+#include "LeastSquaresCostFunc.h"
+#include "LevenbergMarquardt.h"
+#include "PGData.h"
+#include "PlanarSurfaceConstr.h"
+
+
+namespace pg
+{
+
+
+static void checkIndex(int index, std::size_t size)
+{
+  if(index < 0 || index >= int(size))
+  {
+    throw std::out_of_range("No target " + std::to_string(index));
+  }
+}
+
+
+/// Rotate the orientation E (world to frame) by the world rotation vector w.
+static Eigen::Matrix3d rotate(const Eigen::Matrix3d& E, const Eigen::Vector3d& w)
+{
+  double angle = w.norm();
+  if(angle == 0.)
+  {
+    return E;
+  }
+  return E*Eigen::AngleAxisd(angle, w/angle).toRotationMatrix().transpose();
+}
+
+
+/// @return true if param is a target of LeastSquaresCostFunc.
+static bool costParameter(const TargetParameter& param)
+{
+  return param.kind == TargetParameter::BodyPosition ||
+    param.kind == TargetParameter::BodyOrientation ||
+    param.kind == TargetParameter::TargetQ;
+}
+
+
+static bool sameParameter(const TargetParameter& p1, const TargetParameter& p2)
+{
+  return p1.kind == p2.kind && p1.robot == p2.robot && p1.index == p2.index;
+}
+
+
+static Eigen::MatrixXd denseJacobian(const roboptim::DifferentiableSparseFunction& f,
+                                     const Eigen::VectorXd& x)
+{
+  roboptim::DifferentiableSparseFunction::jacobian_t jac(f.outputSize(), f.inputSize());
+  f.jacobian(jac, x);
+  return Eigen::MatrixXd(jac);
+}
+
+
+int parameterSize(const std::vector<RobotConfig>& robotConfigs,
+                  const TargetParameter& param)
+{
+  const RobotConfig& rc = robotConfigs.at(param.robot);
+  switch(param.kind)
+  {
+    case TargetParameter::BodyPosition:
+      checkIndex(param.index, rc.bodyPosTargets.size());
+      return 3;
+    case TargetParameter::BodyOrientation:
+      checkIndex(param.index, rc.bodyOriTargets.size());
+      return 3;
+    case TargetParameter::FixedPosition:
+      checkIndex(param.index, rc.fixedPosContacts.size());
+      return 3;
+    case TargetParameter::FixedOrientation:
+      checkIndex(param.index, rc.fixedOriContacts.size());
+      return 3;
+    case TargetParameter::PlanarFrame:
+      checkIndex(param.index, rc.planarContacts.size());
+      return 6;
+    case TargetParameter::TargetQ:
+      checkIndex(param.index, std::size_t(rc.mb.nrJoints()));
+      return rc.mb.joint(param.index).params();
+  }
+  return 0;
+}
+
+
+void moveTarget(std::vector<RobotConfig>& robotConfigs,
+                std::vector<RunConfig>& runConfigs,
+                const TargetParameter& param, const Eigen::VectorXd& delta)
+{
+  if(int(delta.size()) != parameterSize(robotConfigs, param))
+  {
+    throw std::domain_error("Target delta has a wrong size");
+  }
+
+  RobotConfig& rc = robotConfigs[param.robot];
+  switch(param.kind)
+  {
+    case TargetParameter::BodyPosition:
+    {
+      Eigen::Vector3d& target = rc.bodyPosTargets[param.index].target;
+      target += delta.head<3>();
+      break;
+    }
+    case TargetParameter::BodyOrientation:
+    {
+      Eigen::Matrix3d& target = rc.bodyOriTargets[param.index].target;
+      target = rotate(target, delta.head<3>());
+      break;
+    }
+    case TargetParameter::FixedPosition:
+    {
+      Eigen::Vector3d& target = rc.fixedPosContacts[param.index].target;
+      target += delta.head<3>();
+      break;
+    }
+    case TargetParameter::FixedOrientation:
+    {
+      Eigen::Matrix3d& target = rc.fixedOriContacts[param.index].target;
+      target = rotate(target, delta.head<3>());
+      break;
+    }
+    case TargetParameter::PlanarFrame:
+    {
+      sva::PTransformd& frame = rc.planarContacts[param.index].targetFrame;
+      frame = sva::PTransformd(rotate(frame.rotation(), delta.head<3>()),
+                               frame.translation() + delta.tail<3>());
+      break;
+    }
+    case TargetParameter::TargetQ:
+    {
+      std::vector<double>& target = runConfigs.at(param.robot).targetQ.at(param.index);
+      for(int i = 0; i < int(delta.size()); ++i)
+      {
+        target.at(i) += delta(i);
+      }
+      break;
+    }
+  }
+}
+
+
+boost::shared_ptr<roboptim::DifferentiableSparseFunction>
+targetConstraint(PGData* pgdata, const RobotConfig& robotConfig,
+                 const TargetParameter& param, int part)
+{
+  switch(param.kind)
+  {
+    case TargetParameter::FixedPosition:
+    {
+      const FixedPositionContact& fc = robotConfig.fixedPosContacts.at(param.index);
+      return boost::shared_ptr<FixedPositionContactConstr>(
+        new FixedPositionContactConstr(pgdata, fc.bodyId, fc.target, fc.surfaceFrame));
+    }
+    case TargetParameter::FixedOrientation:
+    {
+      const FixedOrientationContact& fc = robotConfig.fixedOriContacts.at(param.index);
+      return boost::shared_ptr<FixedOrientationContactConstr>(
+        new FixedOrientationContactConstr(pgdata, fc.bodyId, fc.target, fc.surfaceFrame));
+    }
+    case TargetParameter::PlanarFrame:
+    {
+      const PlanarContact& pc = robotConfig.planarContacts.at(param.index);
+      if(part == 0)
+      {
+        return boost::shared_ptr<PlanarPositionContactConstr>(
+          new PlanarPositionContactConstr(pgdata, pc.bodyId, pc.targetFrame,
+                                          pc.surfaceFrame));
+      }
+      return boost::shared_ptr<PlanarOrientationContactConstr>(
+        new PlanarOrientationContactConstr(pgdata, pc.bodyId, pc.targetFrame,
+                                           pc.surfaceFrame, 2));
+    }
+    default:
+      throw std::domain_error("Target parameter without constraint");
+  }
+}
+
+
+Eigen::MatrixXd targetSensitivity(std::vector<PGData>& pgdatas,
+                                  const std::vector<RobotConfig>& robotConfigs,
+                                  const std::vector<RunConfig>& runConfigs,
+                                  const std::vector<TargetParameter>& params,
+                                  const LevenbergMarquardt& constraints,
+                                  const std::vector<TargetConstraintRow>& rows,
+                                  const roboptim::DifferentiableSparseFunction::intervals_t& argBounds,
+                                  const Eigen::VectorXd& x,
+                                  double activeTol)
+{
+  // central differences step of the residuals by the parameters
+  const double h = 1e-6;
+  const int n = int(x.size());
+  int nrParams = 0;
+  for(const TargetParameter& param: params)
+  {
+    nrParams += parameterSize(robotConfigs, param);
+  }
+
+  // Gauss-Newton hessian of the kinematic cost, regularized on the
+  // variables that don't appear in it (forces, free joint quaternion norm)
+  Eigen::MatrixXd H(Eigen::MatrixXd::Zero(n, n));
+  Eigen::MatrixXd Jc;
+  bool hasCost = LeastSquaresCostFunc::nrResiduals(robotConfigs) > 0;
+  if(hasCost)
+  {
+    LeastSquaresCostFunc cost(pgdatas, robotConfigs, runConfigs);
+    Jc = denseJacobian(cost, x);
+    H.noalias() = Jc.transpose()*Jc;
+  }
+  H.diagonal().array() += 1e-8*std::max(H.diagonal().maxCoeff(), 1.);
+
+  std::vector<int> activeRows;
+  Eigen::MatrixXd Jg = constraints.activeJacobian(x, activeTol, activeRows);
+  std::vector<int> activeBounds;
+  for(int i = 0; i < int(argBounds.size()); ++i)
+  {
+    if(std::abs(x(i) - argBounds[i].first) <= activeTol ||
+       std::abs(x(i) - argBounds[i].second) <= activeTol)
+    {
+      activeBounds.push_back(i);
+    }
+  }
+
+  // KKT matrix [H A^T; A 0] with A the active constraints and bounds jacobian
+  const int nrActive = int(Jg.rows());
+  const int m = nrActive + int(activeBounds.size());
+  Eigen::MatrixXd K(Eigen::MatrixXd::Zero(n + m, n + m));
+  K.topLeftCorner(n, n) = H;
+  K.block(n, 0, nrActive, n) = Jg;
+  for(int i = 0; i < int(activeBounds.size()); ++i)
+  {
+    K(n + nrActive + i, activeBounds[i]) = 1.;
+  }
+  K.topRightCorner(n, m) = K.bottomLeftCorner(m, n).transpose();
+
+  std::vector<int> activeIndex(constraints.nrResiduals(), -1);
+  for(int i = 0; i < nrActive; ++i)
+  {
+    activeIndex[activeRows[i]] = i;
+  }
+
+  // derivative of the KKT conditions by the parameters,
+  // bounds don't depend on them
+  Eigen::MatrixXd rhs(Eigen::MatrixXd::Zero(n + m, nrParams));
+  int col = 0;
+  for(const TargetParameter& param: params)
+  {
+    int size = parameterSize(robotConfigs, param);
+    for(int i = 0; i < size; ++i, ++col)
+    {
+      std::vector<RobotConfig> rcPlus(robotConfigs), rcMinus(robotConfigs);
+      std::vector<RunConfig> runPlus(runConfigs), runMinus(runConfigs);
+      Eigen::VectorXd delta(Eigen::VectorXd::Zero(size));
+      delta(i) = h;
+      moveTarget(rcPlus, runPlus, param, delta);
+      moveTarget(rcMinus, runMinus, param, -delta);
+
+      if(hasCost && costParameter(param))
+      {
+        LeastSquaresCostFunc costPlus(pgdatas, rcPlus, runPlus);
+        LeastSquaresCostFunc costMinus(pgdatas, rcMinus, runMinus);
+        Eigen::VectorXd dr = (costPlus(x) - costMinus(x))/(2.*h);
+        rhs.col(col).head(n).noalias() = -Jc.transpose()*dr;
+      }
+
+      for(const TargetConstraintRow& tr: rows)
+      {
+        if(!sameParameter(tr.param, param))
+        {
+          continue;
+        }
+        PGData* pgdata = &pgdatas[param.robot];
+        Eigen::VectorXd dg =
+          ((*targetConstraint(pgdata, rcPlus[param.robot], param, tr.part))(x) -
+           (*targetConstraint(pgdata, rcMinus[param.robot], param, tr.part))(x))/(2.*h);
+        for(int k = 0; k < int(dg.size()); ++k)
+        {
+          int row = activeIndex[tr.row + k];
+          if(row != -1)
+          {
+            rhs(n + row, col) = -dg(k);
+          }
+        }
+      }
+    }
+  }
+
+  // redundant active constraints make K singular but the x part
+  // of the solution is unique since H is positive definite
+  Eigen::FullPivLU<Eigen::MatrixXd> lu(K);
+  return lu.solve(rhs).topRows(n);
+}
+
+
+} // pg
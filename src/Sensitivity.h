@@ -0,0 +1,124 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <vector>
+
+// boost
+#include <boost/shared_ptr.hpp>
+
+// Eigen
+#include <Eigen/Core>
+
+// roboptim
+#include <roboptim/core/differentiable-function.hh>
+
+// PG
+#include "ConfigStruct.h"
+
+
+namespace pg
+{
+class LevenbergMarquardt;
+class PGData;
+
+/**
+  * Target of a run that PostureGenerator can differentiate the solution by.
+  * Orientations are moved by a rotation vector in world coordinate.
+  */
+struct TargetParameter
+{
+  enum Kind
+  {
+    /// RobotConfig::bodyPosTargets[index] target (3 parameters).
+    BodyPosition,
+    /// RobotConfig::bodyOriTargets[index] target (3 parameters).
+    BodyOrientation,
+    /// RobotConfig::fixedPosContacts[index] target (3 parameters).
+    FixedPosition,
+    /// RobotConfig::fixedOriContacts[index] target (3 parameters).
+    FixedOrientation,
+    /// RobotConfig::planarContacts[index] target frame, rotation vector
+    /// then translation (6 parameters).
+    PlanarFrame,
+    /// RunConfig::targetQ of the joint index (joint parameters).
+    TargetQ
+  };
+
+  TargetParameter() {}
+  TargetParameter(Kind k, int r, int i)
+    : kind(k)
+    , robot(r)
+    , index(i)
+  {}
+
+  Kind kind;
+  int robot;
+  int index;
+};
+
+
+/// Rows of a PostureGenerator constraint that depend on a target parameter.
+struct TargetConstraintRow
+{
+  TargetParameter param;
+  /// 1 for the orientation constraint of a planar contact, 0 otherwise.
+  int part;
+  /// First residual of the constraint.
+  int row;
+};
+
+
+/**
+  * Number of parameters of param.
+  * @throw std::out_of_range if param don't exist in robotConfigs.
+  */
+int parameterSize(const std::vector<RobotConfig>& robotConfigs,
+                  const TargetParameter& param);
+
+/// Move the target of param by delta (parameterSize(param) values).
+void moveTarget(std::vector<RobotConfig>& robotConfigs,
+                std::vector<RunConfig>& runConfigs,
+                const TargetParameter& param, const Eigen::VectorXd& delta);
+
+/// Contact constraint of robotConfig built by PostureGenerator::run for
+/// a FixedPosition, FixedOrientation or PlanarFrame parameter.
+boost::shared_ptr<roboptim::DifferentiableSparseFunction>
+targetConstraint(PGData* pgdata, const RobotConfig& robotConfig,
+                 const TargetParameter& param, int part);
+
+/**
+  * Derivative of the solution x of a run by params, from the KKT system of
+  * the constraints active at x with the Gauss-Newton hessian of the
+  * LeastSquaresCostFunc cost. Force cost terms are ignored.
+  * @param constraints Run constraints, with unit weights.
+  * @param rows Rows of constraints that depend on a target parameter.
+  * @param argBounds Variables bounds, bounds active at x are kept active.
+  * @return Matrix of x size rows and of the params size sum columns.
+  */
+Eigen::MatrixXd targetSensitivity(std::vector<PGData>& pgdatas,
+                                  const std::vector<RobotConfig>& robotConfigs,
+                                  const std::vector<RunConfig>& runConfigs,
+                                  const std::vector<TargetParameter>& params,
+                                  const LevenbergMarquardt& constraints,
+                                  const std::vector<TargetConstraintRow>& rows,
+                                  const roboptim::DifferentiableSparseFunction::intervals_t& argBounds,
+                                  const Eigen::VectorXd& x,
+                                  double activeTol=1e-6);
+
+} // namespace pg
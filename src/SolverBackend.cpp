@@ -0,0 +1,177 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "SolverBackend.h"
+
+// include
+// roboptim
+#include <roboptim/core/solver-factory.hh>
+
+// PG
+#include "LevenbergMarquardt.h"
+#include "LeastSquaresCostFunc.h"
+
+
+namespace pg
+{
+
+/// Visitor to take the x component of the result
+struct ResultVisitor : public boost::static_visitor<>
+{
+  void operator()(const roboptim::Result& res)
+  {
+    x = res.x;
+  }
+
+  void operator()(const roboptim::ResultWithWarnings& res)
+  {
+    x = res.x;
+  }
+
+  template <typename T>
+  void operator()(const T& /* res */)
+  {
+    throw std::runtime_error("This result type is not handled !");
+  }
+
+  Eigen::VectorXd x;
+};
+
+
+/*
+ *                             RoboptimBackend
+ */
+
+
+RoboptimBackend::RoboptimBackend(std::string plugin)
+  : plugin_(std::move(plugin))
+{}
+
+
+std::string RoboptimBackend::name() const
+{
+  return plugin_;
+}
+
+
+bool RoboptimBackend::solve(const Description& pb, const parameters_t& params,
+                            iteration_callback_t& iters, Eigen::VectorXd& x)
+{
+  roboptim::SolverFactory<solver_t> factory(plugin_, *pb.problem);
+  return solve(factory(), params, iters, x);
+}
+
+
+bool RoboptimBackend::solve(solver_t& solver, const parameters_t& params,
+                            iteration_callback_t& iters, Eigen::VectorXd& x)
+{
+  solver.setIterationCallback(boost::ref(iters));
+
+  for(const auto& p: params)
+  {
+    solver.parameters()[p.first] = p.second;
+  }
+
+  solver_t::result_t res = solver.minimum();
+  // Check if the minimization has succeed.
+  if(res.which() != solver_t::SOLVER_VALUE &&
+     res.which() != solver_t::SOLVER_VALUE_WARNINGS)
+  {
+    return false;
+  }
+
+  ResultVisitor resVisitor;
+  boost::apply_visitor(resVisitor, res);
+  x = resVisitor.x;
+
+  return true;
+}
+
+
+/*
+ *                                LMBackend
+ */
+
+
+LMBackend::LMBackend(double constraintWeight, int maxIter, double feasibilityTol)
+  : constraintWeight_(constraintWeight)
+  , maxIter_(maxIter)
+  , feasibilityTol_(feasibilityTol)
+{}
+
+
+std::string LMBackend::name() const
+{
+  return "levenberg-marquardt";
+}
+
+
+bool LMBackend::solve(const Description& pb, const parameters_t& /* params */,
+                      iteration_callback_t& iters, Eigen::VectorXd& x)
+{
+  // the constraint only pass go far below feasibilityTol_ because
+  // orientation constraints have a null jacobian at the solution
+  // and then converge linearly
+  const double polishTol = 1e-10;
+  const problem_t::intervals_t& argBounds = pb.problem->argumentBounds();
+
+  LevenbergMarquardt lm;
+  lm.addFunctions(*pb.constraints, constraintWeight_);
+  if(pb.cost)
+  {
+    lm.addFunction(pb.cost,
+      LeastSquaresCostFunc::intervals_t(pb.cost->outputSize(), {0., 0.}));
+  }
+  lm.normalizer(pb.normalize);
+
+  const int nrConstr = pb.constraints->nrResiduals();
+  const double weight = constraintWeight_;
+  lm.iterationCallback([&iters, nrConstr, weight](const Eigen::VectorXd& xi,
+                                                  const Eigen::VectorXd& r)
+  {
+    double constrViol = nrConstr > 0 ?
+      r.head(nrConstr).cwiseAbs().maxCoeff()/weight : 0.;
+    iters.push(xi, r.tail(r.size() - nrConstr).squaredNorm(), constrViol);
+  });
+
+  x = *pb.problem->startingPoint();
+  lm.solve(x, argBounds, maxIter_, 0.);
+
+  double violation = 0.;
+  if(nrConstr > 0)
+  {
+    LevenbergMarquardt polish;
+    polish.addFunctions(*pb.constraints);
+    polish.normalizer(pb.normalize);
+    const boost::shared_ptr<LeastSquaresCostFunc>& cost = pb.cost;
+    polish.iterationCallback([&iters, &cost](const Eigen::VectorXd& xi,
+                                             const Eigen::VectorXd& r)
+    {
+      double obj = cost ? (*cost)(xi).squaredNorm() : 0.;
+      iters.push(xi, obj, r.cwiseAbs().maxCoeff());
+    });
+    polish.solve(x, argBounds, maxIter_, polishTol);
+
+    Eigen::VectorXd r;
+    polish.residual(x, r);
+    violation = r.cwiseAbs().maxCoeff();
+  }
+
+  return violation <= feasibilityTol_;
+}
+
+
+} // pg
@@ -0,0 +1,139 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <functional>
+#include <string>
+
+// boost
+#include <boost/shared_ptr.hpp>
+
+// roboptim
+#include <roboptim/core/linear-function.hh>
+#include <roboptim/core/differentiable-function.hh>
+#include <roboptim/core/solver.hh>
+
+// PG
+#include "IterationCallback.h"
+
+
+namespace pg
+{
+class LevenbergMarquardt;
+class LeastSquaresCostFunc;
+
+/**
+  * Numerical engine used by PostureGenerator::run.
+  * A backend receive the problem built by PostureGenerator and return
+  * the solution and its iterates.
+  */
+class SolverBackend
+{
+public:
+  typedef boost::mpl::vector<
+    roboptim::LinearSparseFunction,
+    roboptim::DifferentiableSparseFunction> constraints_t;
+
+  typedef roboptim::Solver<
+      roboptim::DifferentiableSparseFunction,
+      constraints_t> solver_t;
+
+  typedef solver_t::problem_t problem_t;
+  typedef solver_t::parameters_t parameters_t;
+
+  typedef IterationCallback<problem_t,
+    solver_t::solverState_t> iteration_callback_t;
+
+  /// Same problem in its two forms.
+  struct Description
+  {
+    /// Non linear problem: StdCostFunc, all constraints, variables bounds
+    /// and starting point.
+    const problem_t* problem;
+    /// problem constraints as least squares residuals.
+    const LevenbergMarquardt* constraints;
+    /// Kinematic cost terms as least squares residuals, null if there is none.
+    boost::shared_ptr<LeastSquaresCostFunc> cost;
+    /// Bring a point back on the variables manifold.
+    std::function<void(Eigen::VectorXd&)> normalize;
+  };
+
+public:
+  virtual ~SolverBackend() {}
+
+  virtual std::string name() const = 0;
+
+  /**
+    * Solve the problem.
+    * @param pb Problem to solve.
+    * @param params Parameters set with PostureGenerator::param.
+    * @param iters Iterates of the solve, cleared at start. The backend must
+    * call iters (or iters.push or iters.checkDeadline) at each iteration
+    * and let DeadlineReached propagate.
+    * @param x Solution on success.
+    * @return true if the solve succeed.
+    */
+  virtual bool solve(const Description& pb, const parameters_t& params,
+                     iteration_callback_t& iters, Eigen::VectorXd& x) = 0;
+};
+
+
+/// Any roboptim solver plugin of the right problem type.
+class RoboptimBackend : public SolverBackend
+{
+public:
+  /// @param plugin roboptim plugin name.
+  RoboptimBackend(std::string plugin="ipopt-sparse");
+
+  virtual std::string name() const;
+  virtual bool solve(const Description& pb, const parameters_t& params,
+                     iteration_callback_t& iters, Eigen::VectorXd& x);
+
+  /// Solve with a solver already built on the problem.
+  static bool solve(solver_t& solver, const parameters_t& params,
+                    iteration_callback_t& iters, Eigen::VectorXd& x);
+
+private:
+  std::string plugin_;
+};
+
+
+/**
+  * Levenberg-Marquardt on the kinematic cost residuals and the constraints
+  * with a large weight, then on the constraints alone to remove the
+  * remaining violation with minimal norm steps.
+  * Force cost terms are ignored.
+  * On failure x is the least violating point found.
+  */
+class LMBackend : public SolverBackend
+{
+public:
+  LMBackend(double constraintWeight=1e3, int maxIter=200,
+            double feasibilityTol=1e-6);
+
+  virtual std::string name() const;
+  virtual bool solve(const Description& pb, const parameters_t& params,
+                     iteration_callback_t& iters, Eigen::VectorXd& x);
+
+private:
+  double constraintWeight_;
+  int maxIter_;
+  double feasibilityTol_;
+};
+
+} // namespace pg
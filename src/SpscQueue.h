@@ -0,0 +1,98 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+
+namespace pg
+{
+
+/**
+  * Lock-free bounded queue of one producer thread and one consumer thread.
+  * Slots are allocated at construction, push and pop only copy T.
+  */
+template <typename T>
+class SpscQueue
+{
+public:
+  /// Queue of at least capacity elements (rounded to a power of two).
+  SpscQueue(std::size_t capacity)
+    : slots_(roundCapacity(capacity))
+    , mask_(slots_.size() - 1)
+    , head_(0)
+    , pad_()
+    , tail_(0)
+  {}
+
+  std::size_t capacity() const
+  {
+    return slots_.size();
+  }
+
+  /// Producer thread.
+  /// @return false if the queue is full.
+  bool push(const T& value)
+  {
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if(tail - head_.load(std::memory_order_acquire) == slots_.size())
+    {
+      return false;
+    }
+    slots_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer thread.
+  /// @return false if the queue is empty.
+  bool pop(T& value)
+  {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    if(head == tail_.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    value = slots_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  static std::size_t roundCapacity(std::size_t capacity)
+  {
+    std::size_t size = 1;
+    while(size < capacity)
+    {
+      size *= 2;
+    }
+    return size;
+  }
+
+private:
+  std::vector<T> slots_;
+  std::size_t mask_;
+  std::atomic<std::size_t> head_;
+  // keep the consumer and producer indexes on different cache lines
+  char pad_[64];
+  std::atomic<std::size_t> tail_;
+};
+
+} // namespace pg
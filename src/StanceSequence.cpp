@@ -0,0 +1,272 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "StanceSequence.h"
+
+// include
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+// PG
+#include "RunHandle.h"
+
+
+namespace pg
+{
+
+/// Stance solved ahead on another thread.
+struct StanceSequence::Speculation
+{
+  // the handle is destroyed first and wait the end of the run
+  boost::shared_ptr<PostureGenerator> pg;
+  RunHandle handle;
+};
+
+
+StanceSequence::StanceSequence()
+  : setup_()
+  , nrThreads_(1)
+  , maxSpeculativeDistance_(0.1)
+  , configs_()
+  , gravity_(Eigen::Vector3d::Zero())
+  , results_()
+{}
+
+
+void StanceSequence::setup(std::function<void(PostureGenerator&)> setup)
+{
+  setup_ = std::move(setup);
+}
+
+
+void StanceSequence::nrThreads(int nrThreads)
+{
+  nrThreads_ = std::max(nrThreads, 1);
+}
+
+
+int StanceSequence::nrThreads() const
+{
+  return nrThreads_;
+}
+
+
+void StanceSequence::maxSpeculativeDistance(double dist)
+{
+  maxSpeculativeDistance_ = dist;
+}
+
+
+double StanceSequence::maxSpeculativeDistance() const
+{
+  return maxSpeculativeDistance_;
+}
+
+
+bool StanceSequence::run(const std::vector<Stance>& stances,
+                         const std::vector<RunConfig>& configs,
+                         const Eigen::Vector3d& gravity)
+{
+  configs_ = configs;
+  gravity_ = gravity;
+  results_.clear();
+
+  std::map<int, Speculation> speculations;
+  std::size_t nrSpeculations = std::size_t(nrThreads_ - 1);
+  int nextSpeculation = 1;
+  // solve ahead the next stances from the last known solution
+  auto speculate = [&](const Stance* prevStance, const StanceResult* prev)
+  {
+    while(nextSpeculation < int(stances.size()) &&
+          speculations.size() < nrSpeculations)
+    {
+      const Stance& stance = stances[nextSpeculation];
+      Speculation& s = speculations[nextSpeculation];
+      s.pg = makeSolver(stance);
+      s.handle = s.pg->runAsync(startConfigs(stance, prevStance, prev));
+      ++nextSpeculation;
+    }
+  };
+
+  speculate(nullptr, nullptr);
+  for(int k = 0; k < int(stances.size()); ++k)
+  {
+    const Stance* prevStance = k > 0 ? &stances[k - 1] : nullptr;
+    const StanceResult* prev = k > 0 ? &results_.back() : nullptr;
+
+    StanceResult res;
+    bool solved = false;
+    auto it = speculations.find(k);
+    if(it != speculations.end())
+    {
+      bool success = false;
+      try
+      {
+        success = it->second.handle.get();
+      }
+      catch(const std::exception&)
+      {}
+
+      if(success)
+      {
+        res = result(*it->second.pg, stances[k], true);
+        res.speculative = true;
+        solved = distance(res, *prev) <= maxSpeculativeDistance_;
+      }
+      speculations.erase(it);
+    }
+
+    if(!solved)
+    {
+      boost::shared_ptr<PostureGenerator> pg(makeSolver(stances[k]));
+      bool success = pg->run(startConfigs(stances[k], prevStance, prev));
+      res = result(*pg, stances[k], success);
+    }
+
+    results_.push_back(res);
+    if(!res.success)
+    {
+      for(auto& s: speculations)
+      {
+        s.second.handle.cancel();
+      }
+      return false;
+    }
+
+    nextSpeculation = std::max(nextSpeculation, k + 2);
+    speculate(&stances[k], &results_.back());
+  }
+
+  return true;
+}
+
+
+const std::vector<StanceResult>& StanceSequence::results() const
+{
+  return results_;
+}
+
+
+boost::shared_ptr<PostureGenerator> StanceSequence::makeSolver(const Stance& stance) const
+{
+  boost::shared_ptr<PostureGenerator> pg(new PostureGenerator);
+  // iterates x are not used
+  pg->iterateRecording(IterateRecording(IterateRecording::Quantities));
+  if(setup_)
+  {
+    setup_(*pg);
+  }
+  pg->robotConfigs(stance.robotConfigs, gravity_);
+  pg->robotLinks(stance.robotLinks);
+  return pg;
+}
+
+
+std::vector<RunConfig> StanceSequence::startConfigs(const Stance& stance,
+                                                    const Stance* prevStance,
+                                                    const StanceResult* prev) const
+{
+  std::vector<RunConfig> configs(configs_);
+  if(!prev)
+  {
+    return configs;
+  }
+
+  for(std::size_t r = 0; r < configs.size() && r < prev->q.size(); ++r)
+  {
+    configs[r].initQ = prev->q[r];
+
+    // forces of the force contacts with the same body and number of points
+    const std::vector<ForceContact>& prevContacts =
+      prevStance->robotConfigs[r].forceContacts;
+    std::vector<sva::ForceVecd> forces;
+    bool match = true;
+    for(const ForceContact& fc: stance.robotConfigs[r].forceContacts)
+    {
+      std::size_t pos = 0;
+      auto it = prevContacts.begin();
+      for(; it != prevContacts.end() && it->bodyId != fc.bodyId; ++it)
+      {
+        pos += it->points.size();
+      }
+      if(it == prevContacts.end() || it->points.size() != fc.points.size())
+      {
+        match = false;
+        break;
+      }
+      forces.insert(forces.end(), prev->forces[r].begin() + pos,
+                    prev->forces[r].begin() + pos + fc.points.size());
+    }
+    // unmatched forces are computed by PostureGenerator
+    configs[r].initForces = match ? forces : std::vector<sva::ForceVecd>();
+  }
+  return configs;
+}
+
+
+StanceResult StanceSequence::result(PostureGenerator& pg, const Stance& stance,
+                                    bool success) const
+{
+  StanceResult res;
+  res.success = success;
+  res.nrIters = pg.nrIters();
+  if(success)
+  {
+    for(int r = 0; r < int(stance.robotConfigs.size()); ++r)
+    {
+      res.q.push_back(pg.q(r));
+      res.forces.push_back(pg.forces(r));
+    }
+  }
+  return res;
+}
+
+
+double StanceSequence::distance(const StanceResult& r1, const StanceResult& r2)
+{
+  if(r1.q.size() != r2.q.size())
+  {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  double dist = 0.;
+  for(std::size_t r = 0; r < r1.q.size(); ++r)
+  {
+    if(r1.q[r].size() != r2.q[r].size())
+    {
+      return std::numeric_limits<double>::infinity();
+    }
+    for(std::size_t i = 0; i < r1.q[r].size(); ++i)
+    {
+      if(r1.q[r][i].size() != r2.q[r][i].size())
+      {
+        return std::numeric_limits<double>::infinity();
+      }
+      for(std::size_t j = 0; j < r1.q[r][i].size(); ++j)
+      {
+        dist = std::max(dist, std::abs(r1.q[r][i][j] - r2.q[r][i][j]));
+      }
+    }
+  }
+  return dist;
+}
+
+
+} // pg
@@ -0,0 +1,128 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <functional>
+#include <vector>
+
+// boost
+#include <boost/shared_ptr.hpp>
+
+// PG
+#include "ConfigStruct.h"
+#include "PostureGenerator.h"
+
+
+namespace pg
+{
+
+/// Contacts and targets of all the robots at one step of a sequence.
+struct Stance
+{
+  Stance() {}
+  Stance(std::vector<RobotConfig> rcs, std::vector<RobotLink> rls=std::vector<RobotLink>())
+    : robotConfigs(std::move(rcs))
+    , robotLinks(std::move(rls))
+  {}
+
+  std::vector<RobotConfig> robotConfigs;
+  std::vector<RobotLink> robotLinks;
+};
+
+
+struct StanceResult
+{
+  StanceResult()
+    : success(false)
+    , speculative(false)
+    , nrIters(0)
+  {}
+
+  bool success;
+  /// Solved from a predicted starting point on another thread.
+  bool speculative;
+  int nrIters;
+  /// By robot.
+  std::vector<std::vector<std::vector<double>>> q;
+  std::vector<std::vector<sva::ForceVecd>> forces;
+};
+
+
+/**
+  * Solve a sequence of stances in order, each stance starting from the
+  * solution of its predecessor: initQ is the predecessor posture and
+  * initForces its forces when all the force contacts of the stance have the
+  * same body and number of points.
+  *
+  * With more than one thread the next stances are also solved ahead on the
+  * other threads from the last accepted solution. A speculative solution is
+  * kept if it converged and its joints parameters are within
+  * maxSpeculativeDistance of its predecessor solution, otherwise the stance
+  * is solved again from its predecessor.
+  */
+class StanceSequence
+{
+public:
+  StanceSequence();
+
+  /// Called on the PostureGenerator of each stance before running it
+  /// (solver parameters, engine, deadline...).
+  void setup(std::function<void(PostureGenerator&)> setup);
+
+  /// Number of threads, 1 (default) disable the speculative solving.
+  void nrThreads(int nrThreads);
+  int nrThreads() const;
+
+  void maxSpeculativeDistance(double dist);
+  double maxSpeculativeDistance() const;
+
+  /**
+    * @param configs Run configuration of each robot, the first stance start
+    * from it, all the stances use its targetQ and lockedJoints.
+    * @return true if all the stances are solved, the solving stop at the
+    * first failure.
+    */
+  bool run(const std::vector<Stance>& stances, const std::vector<RunConfig>& configs,
+           const Eigen::Vector3d& gravity);
+
+  /// Results of the solved stances of the last run.
+  const std::vector<StanceResult>& results() const;
+
+private:
+  struct Speculation;
+
+private:
+  boost::shared_ptr<PostureGenerator> makeSolver(const Stance& stance) const;
+  /// configs started from prev solution of prevStance, configs_ if prev is null.
+  std::vector<RunConfig> startConfigs(const Stance& stance, const Stance* prevStance,
+                                      const StanceResult* prev) const;
+  StanceResult result(PostureGenerator& pg, const Stance& stance, bool success) const;
+  /// Max joint parameters difference.
+  static double distance(const StanceResult& r1, const StanceResult& r2);
+
+private:
+  std::function<void(PostureGenerator&)> setup_;
+  int nrThreads_;
+  double maxSpeculativeDistance_;
+
+  std::vector<RunConfig> configs_;
+  Eigen::Vector3d gravity_;
+  std::vector<StanceResult> results_;
+};
+
+} // namespace pg
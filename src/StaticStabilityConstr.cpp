@@ -19,7 +19,6 @@
 // include
 // PG
 #include "PGData.h"
-#include "FillSparse.h"
 
 
 namespace pg
@@ -37,16 +36,30 @@ StaticStabilityConstr::StaticStabilityConstr(PGData* pgdata)
   , jacFullMat_(3, pgdata->mb().nrParams())
   , T_com_fi_jac_(3, pgdata->mb().nrParams())
   , couple_jac_(3, pgdata->mb().nrParams())
+  , pattern_(6, pgdata->pbSize())
+  , coupleBlock_(pattern_.addDense(3, pgdata->mb().nrParams(), {0, pgdata->qParamsBegin()}))
+  , forceBlocks_(pgdata->nrForcePoints())
 {
+  std::vector<int> identityBlocks(pgdata->nrForcePoints());
   std::size_t index = 0;
   for(const PGData::ForceData& fd: pgdata_->forceDatas())
   {
     for(std::size_t i = 0; i < fd.forces.size(); ++i)
     {
       jacPoints_[index] = rbd::Jacobian(pgdata_->mb(), fd.bodyId, fd.points[i].translation());
+      int indexCols = pgdata_->forceParamsBegin() + int(index)*3;
+      forceBlocks_[index] = pattern_.addDense(3, 3, {0, indexCols});
+      identityBlocks[index] = pattern_.addDense(3, 3, {3, indexCols});
       ++index;
     }
   }
+  pattern_.finalize();
+
+  // the force part of the force jacobian is constant
+  for(int block: identityBlocks)
+  {
+    pattern_.set(block, Eigen::Matrix3d::Identity());
+  }
 }
 
 
@@ -85,8 +98,6 @@ void StaticStabilityConstr::impl_jacobian(jacobian_t& jac, const argument_t& x)
     computeCoM();
   }
 
-  jac.reserve(pgdata_->mb().nrDof()*3 + pgdata_->nrForcePoints()*(9*2));
-
   couple_jac_.setZero();
   const Eigen::MatrixXd& comJacMat = comJac_.jacobian(pgdata_->mb(), pgdata_->mbc());
 
@@ -114,17 +125,15 @@ void StaticStabilityConstr::impl_jacobian(jacobian_t& jac, const argument_t& x)
 
       // force jacobian
       // couple
-      int indexCols = (pgdata_->forceParamsBegin() + index*3);
-      Eigen::Matrix3d couple_force_jac = sva::vector3ToCrossMatrix(T_com_fi);
-      fillSparse(couple_force_jac, jac, {0, indexCols});
-      // force
-      fillSparse(Eigen::Matrix3d::Identity(), jac, {3, indexCols});
+      pattern_.set(forceBlocks_[index], sva::vector3ToCrossMatrix(T_com_fi));
+      // force (identity set at construction)
 
       ++index;
     }
   }
   // fill couple
-  fillSparse(couple_jac_, jac, {0, pgdata_->qParamsBegin()});
+  pattern_.set(coupleBlock_, couple_jac_);
+  pattern_.copyTo(jac);
 }
 
 
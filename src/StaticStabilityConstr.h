@@ -23,6 +23,9 @@
 #include <RBDyn/CoM.h>
 #include <RBDyn/Jacobian.h>
 
+// PG
+#include "FillSparse.h"
+
 
 namespace pg
 {
@@ -46,7 +49,7 @@ public:
     throw std::runtime_error("NEVER GO HERE");
   }
 
-private:
+  /// Compute the CoM for the current PGData state.
   void computeCoM() const;
 
 private:
@@ -60,6 +63,10 @@ private:
   mutable Eigen::MatrixXd jacFullMat_;
   mutable Eigen::MatrixXd T_com_fi_jac_;
   mutable Eigen::MatrixXd couple_jac_;
+  mutable SparsePattern pattern_;
+  int coupleBlock_;
+  /// Couple block of each force point.
+  std::vector<int> forceBlocks_;
 };
 
 } // namespace pg
@@ -23,7 +23,6 @@
 // PG
 #include "PGData.h"
 #include "ConfigStruct.h"
-#include "FillSparse.h"
 
 
 namespace pg
@@ -36,6 +35,7 @@ StdCostFunc::StdCostFunc(std::vector<PGData>& pgdatas,
   : roboptim::DifferentiableSparseFunction(pgdatas[0].pbSize(), 1, "StdCostFunc")
   , robotDatas_(pgdatas.size())
   , scale_(1./double(robotConfigs.size()))
+  , pattern_(1, pgdatas[0].pbSize())
 {
   for(std::size_t robotIndex = 0; robotIndex < pgdatas.size(); ++robotIndex)
   {
@@ -51,17 +51,34 @@ StdCostFunc::StdCostFunc(std::vector<PGData>& pgdatas,
     data.forceScale = robotConfig.forceScale;
     data.ellipseScale = robotConfig.ellipseCostScale;
 
+    if(data.postureScale > 0.)
+    {
+      int index = pgdata.qParamsBegin();
+      for(int i = 0; i < pgdata.mb().nrJoints(); ++i)
+      {
+        if(pgdata.mb().joint(i).params() == 1)
+        {
+          data.postureBlocks.push_back(pattern_.addDense(1, 1, {0, index}));
+        }
+        index += pgdata.mb().joint(i).dof();
+      }
+    }
+
+    if(data.forceScale > 0.)
+    {
+      data.forceBlocks = addForceBlocks(pgdata.forceParamsBegin(), pgdata.nrForcePoints());
+    }
+
     for(std::size_t i = 0; i < robotConfig.bodyPosTargets.size(); ++i)
     {
       const BodyPositionTarget& bodyPosTarget = robotConfig.bodyPosTargets[i];
       rbd::Jacobian jac(pgdata.mb(), bodyPosTarget.bodyId);
       Eigen::MatrixXd jacMat(1, jac.dof());
-      Eigen::SparseMatrix<double, Eigen::RowMajor> jacMatFull(1, pgdata.pbSize());
-      jacMatFull.reserve(jac.dof());
+      int jacBlock = pattern_.addJacobian(pgdata.mb(), jac, 1, {0, pgdata.qParamsBegin()});
       data.bodyPosTargets.push_back({pgdata.mb().bodyIndexById(bodyPosTarget.bodyId),
                                      bodyPosTarget.target,
                                      bodyPosTarget.scale,
-                                     jac, jacMat, jacMatFull});
+                                     jac, jacMat, jacBlock});
     }
 
     for(std::size_t i = 0; i < robotConfig.bodyOriTargets.size(); ++i)
@@ -69,12 +86,11 @@ StdCostFunc::StdCostFunc(std::vector<PGData>& pgdatas,
       const BodyOrientationTarget& bodyOriTarget = robotConfig.bodyOriTargets[i];
       rbd::Jacobian jac(pgdata.mb(), bodyOriTarget.bodyId);
       Eigen::MatrixXd jacMat(1, jac.dof());
-      Eigen::SparseMatrix<double, Eigen::RowMajor> jacMatFull(1, pgdata.pbSize());
-      jacMatFull.reserve(jac.dof());
+      int jacBlock = pattern_.addJacobian(pgdata.mb(), jac, 1, {0, pgdata.qParamsBegin()});
       data.bodyOriTargets.push_back({pgdata.mb().bodyIndexById(bodyOriTarget.bodyId),
                                      bodyOriTarget.target,
                                      bodyOriTarget.scale,
-                                     jac, jacMat, jacMatFull});
+                                     jac, jacMat, jacBlock});
     }
 
     for(std::size_t i = 0; i < robotConfig.forceContactsMin.size(); ++i)
@@ -87,7 +103,8 @@ StdCostFunc::StdCostFunc(std::vector<PGData>& pgdatas,
         if(robotConfig.forceContactsMin[i].bodyId == forceData.bodyId)
         {
           data.forceContactsMin.push_back({j, gradientPos,
-                                           robotConfig.forceContactsMin[i].scale});
+                                           robotConfig.forceContactsMin[i].scale,
+                                           addForceBlocks(gradientPos, forceData.points.size())});
         }
         gradientPos += forceData.points.size()*3;
       }
@@ -113,11 +130,11 @@ StdCostFunc::StdCostFunc(std::vector<PGData>& pgdatas,
           rbd::Jacobian jac(pgdata.mb(), tcm.bodyId);
           Eigen::MatrixXd jacMat(1, jac.dof());
           Eigen::MatrixXd jacMatTmp(3, jac.dof());
-          Eigen::SparseMatrix<double, Eigen::RowMajor> jacMatFull(1, pgdata.pbSize());
-          jacMatFull.reserve(jac.dof());
+          int jacBlock = pattern_.addJacobian(pgdata.mb(), jac, 1, {0, pgdata.qParamsBegin()});
           data.torqueContactsMin.push_back({bodyIndex, forceData.points, std::move(levers),
-                                            tcm.axis, jac, jacMat, jacMatTmp, jacMatFull,
-                                            j, gradientPos, tcm.scale});
+                                            tcm.axis, jac, jacMat, jacMatTmp,
+                                            j, gradientPos, tcm.scale, jacBlock,
+                                            addForceBlocks(gradientPos, forceData.points.size())});
         }
         gradientPos += forceData.points.size()*3;
       }
@@ -134,12 +151,13 @@ StdCostFunc::StdCostFunc(std::vector<PGData>& pgdatas,
         {
           rbd::Jacobian jac(pgdata.mb(), robotConfig.normalForceTargets[i].bodyId);
           Eigen::MatrixXd jacMat(1, jac.dof());
-          Eigen::SparseMatrix<double, Eigen::RowMajor> jacMatFull(1, pgdata.pbSize());
-          jacMatFull.reserve(jac.dof());
+          int jacBlock = pattern_.addJacobian(pgdata.mb(), jac, 1, {0, pgdata.qParamsBegin()});
           data.normalForceTargets.push_back({j, gradientPos,
                                              robotConfig.normalForceTargets[i].target,
-                                             jac, jacMat, jacMatFull,
-                                             robotConfig.normalForceTargets[i].scale});
+                                             jac, jacMat,
+                                             robotConfig.normalForceTargets[i].scale,
+                                             jacBlock,
+                                             addForceBlocks(gradientPos, forceData.points.size())});
         }
         gradientPos += forceData.points.size()*3;
       }
@@ -156,11 +174,12 @@ StdCostFunc::StdCostFunc(std::vector<PGData>& pgdatas,
         {
           rbd::Jacobian jac(pgdata.mb(), robotConfig.tanForceMin[i].bodyId);
           Eigen::MatrixXd jacMat(1, jac.dof());
-          Eigen::SparseMatrix<double, Eigen::RowMajor> jacMatFull(1, pgdata.pbSize());
-          jacMatFull.reserve(jac.dof());
+          int jacBlock = pattern_.addJacobian(pgdata.mb(), jac, 1, {0, pgdata.qParamsBegin()});
           data.tanForceMin.push_back({j, gradientPos,
-                                      jac, jacMat, jacMatFull,
-                                      robotConfig.tanForceMin[i].scale});
+                                      jac, jacMat,
+                                      robotConfig.tanForceMin[i].scale,
+                                      jacBlock,
+                                      addForceBlocks(gradientPos, forceData.points.size())});
         }
         gradientPos += forceData.points.size()*3;
       }
@@ -168,6 +187,39 @@ StdCostFunc::StdCostFunc(std::vector<PGData>& pgdatas,
 
     robotDatas_[robotIndex] = std::move(data);
   }
+
+  pattern_.finalize();
+}
+
+
+void StdCostFunc::targets(const std::vector<RobotConfig>& robotConfigs,
+                          const std::vector<RunConfig>& runConfigs)
+{
+  for(std::size_t robotIndex = 0; robotIndex < robotDatas_.size(); ++robotIndex)
+  {
+    const RobotConfig& robotConfig = robotConfigs[robotIndex];
+    RobotData& data = robotDatas_[robotIndex];
+    data.tq = runConfigs[robotIndex].targetQ;
+    for(std::size_t i = 0; i < data.bodyPosTargets.size(); ++i)
+    {
+      data.bodyPosTargets[i].target = robotConfig.bodyPosTargets[i].target;
+    }
+    for(std::size_t i = 0; i < data.bodyOriTargets.size(); ++i)
+    {
+      data.bodyOriTargets[i].target = robotConfig.bodyOriTargets[i].target;
+    }
+  }
+}
+
+
+std::vector<int> StdCostFunc::addForceBlocks(std::size_t gradientPos, std::size_t nrPoints)
+{
+  std::vector<int> blocks(nrPoints);
+  for(std::size_t i = 0; i < nrPoints; ++i)
+  {
+    blocks[i] = pattern_.addDense(1, 3, {0, int(gradientPos + i*3)});
+  }
+  return blocks;
 }
 
 
@@ -310,8 +362,7 @@ void StdCostFunc::impl_compute(result_t& res, const argument_t& x) const
 void StdCostFunc::impl_gradient(gradient_t& gradient,
     const argument_t& x, size_type /* functionId */) const
 {
-  gradient.reserve(robotDatas_[0].pgdata->pbSize());
-  gradient.setZero();
+  pattern_.setZero();
 
   for(RobotData& rd: robotDatas_)
   {
@@ -319,33 +370,29 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
 
     if(rd.postureScale > 0.)
     {
-      int index = rd.pgdata->qParamsBegin();
       const std::vector<std::vector<double>>& q = rd.pgdata->mbc().q;
       double coef = 2.*rd.postureScale*scale_;
+      auto block = rd.postureBlocks.begin();
       for(int i = 0; i < rd.pgdata->multibody().nrJoints(); ++i)
       {
         if(rd.pgdata->multibody().joint(i).params() == 1)
         {
-          gradient.coeffRef(index) += coef*(q[i][0] - rd.tq[i][0]);
+          pattern_.add(*block++,
+            Eigen::Matrix<double, 1, 1>::Constant(coef*(q[i][0] - rd.tq[i][0])));
         }
-        index += rd.pgdata->mb().joint(i).dof();
       }
     }
 
 
     if(rd.forceScale > 0.)
     {
-      int index = rd.pgdata->forceParamsBegin();
+      auto block = rd.forceBlocks.begin();
       for(const auto& fd: rd.pgdata->forceDatas())
       {
         for(std::size_t i = 0; i < fd.forces.size(); ++i)
         {
-          Eigen::Vector3d forceTmp = fd.forces[i].force()*rd.forceScale*scale_*2.;
-
-          gradient.coeffRef(index + 0) += forceTmp.x();
-          gradient.coeffRef(index + 1) += forceTmp.y();
-          gradient.coeffRef(index + 2) += forceTmp.z();
-          index += 3;
+          pattern_.add(*block++,
+            (fd.forces[i].force()*rd.forceScale*scale_*2.).transpose());
         }
       }
     }
@@ -354,16 +401,11 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
     for(const ForceContactMinimizationData& fcmd: rd.forceContactsMin)
     {
       const auto& forceData = rd.pgdata->forceDatas()[fcmd.forcePos];
-      int index = int(fcmd.gradientPos);
 
       for(std::size_t i = 0; i < forceData.forces.size(); ++i)
       {
-        Eigen::Vector3d forceTmp = forceData.forces[i].force()*fcmd.scale*scale_*2.;
-
-        gradient.coeffRef(index + 0) += forceTmp.x();
-        gradient.coeffRef(index + 1) += forceTmp.y();
-        gradient.coeffRef(index + 2) += forceTmp.z();
-        index += 3;
+        pattern_.add(fcmd.forceBlocks[i],
+          (forceData.forces[i].force()*fcmd.scale*scale_*2.).transpose());
       }
     }
 
@@ -373,7 +415,6 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
       const auto& forceData = rd.pgdata->forceDatas()[tcmd.forcePos];
       const sva::PTransformd& X_0_b = rd.pgdata->mbc().bodyPosW[tcmd.bodyIndex];
 
-      int forceIndex = int(tcmd.gradientPos);
       for(std::size_t pi = 0; pi < tcmd.points.size(); ++pi)
       {
         Eigen::Vector3d fBody(X_0_b.rotation()*forceData.forces[pi].force());
@@ -385,29 +426,22 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
 
         const auto& qDiffX = tcmd.jac.vectorJacobian(rd.pgdata->mb(), rd.pgdata->mbc(),
                                                      Eigen::Vector3d::UnitX()).block(3, 0, 3, tcmd.jac.dof());
-        tcmd.jacMatTmp.row(0) = forceData.forces[pi].force().transpose()*qDiffX;
+        tcmd.jacMatTmp.row(0).noalias() = forceData.forces[pi].force().transpose()*qDiffX;
 
         const auto& qDiffY = tcmd.jac.vectorJacobian(rd.pgdata->mb(), rd.pgdata->mbc(),
                                                      Eigen::Vector3d::UnitY()).block(3, 0, 3, tcmd.jac.dof());
-        tcmd.jacMatTmp.row(1) = forceData.forces[pi].force().transpose()*qDiffY;
+        tcmd.jacMatTmp.row(1).noalias() = forceData.forces[pi].force().transpose()*qDiffY;
 
         const auto& qDiffZ = tcmd.jac.vectorJacobian(rd.pgdata->mb(), rd.pgdata->mbc(),
                                                      Eigen::Vector3d::UnitZ()).block(3, 0, 3, tcmd.jac.dof());
-        tcmd.jacMatTmp.row(2) = forceData.forces[pi].force().transpose()*qDiffZ;
+        tcmd.jacMatTmp.row(2).noalias() = forceData.forces[pi].force().transpose()*qDiffZ;
 
         tcmd.jacMat.noalias() = (squareDiff*dotCrossDiff)*tcmd.jacMatTmp;
-
-        updateFullJacobianSparse(rd.pgdata->mb(), tcmd.jac, tcmd.jacMat, tcmd.jacMatFull,
-                                 {0, rd.pgdata->qParamsBegin()});
-        gradient += tcmd.jacMatFull.transpose();
+        pattern_.add(tcmd.jacBlock, tcmd.jacMat);
 
         Eigen::RowVector3d fDiff;
         fDiff = squareDiff*dotCrossDiff*X_0_b.rotation();
-
-        gradient.coeffRef(forceIndex + 0) += fDiff.x();
-        gradient.coeffRef(forceIndex + 1) += fDiff.y();
-        gradient.coeffRef(forceIndex + 2) += fDiff.z();
-        forceIndex += 3;
+        pattern_.add(tcmd.forceBlocks[pi], fDiff);
       }
     }
 
@@ -426,7 +460,6 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
       }
       double error = nForceSum - nft.target;
 
-      int forceIndex = int(nft.gradientPos);
       double scale = scale_*nft.scale;
       for(std::size_t pi = 0; pi < forceData.points.size(); ++pi)
       {
@@ -440,17 +473,11 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
             .block(3, 0, 3, nft.jac.dof());
         nft.jacMat.noalias() = (coef*forceData.forces[pi].force().transpose())*
           jacPointMat;
-        updateFullJacobianSparse(rd.pgdata->mb(), nft.jac, nft.jacMat,
-                                 nft.jacMatFull,
-                                 {0, rd.pgdata->qParamsBegin()});
-        gradient += nft.jacMatFull.transpose();
+        pattern_.add(nft.jacBlock, nft.jacMat);
 
         Eigen::RowVector3d fDiff;
         fDiff = coef*X_0_pi.rotation().row(2);
-        gradient.coeffRef(forceIndex + 0) += fDiff.x();
-        gradient.coeffRef(forceIndex + 1) += fDiff.y();
-        gradient.coeffRef(forceIndex + 2) += fDiff.z();
-        forceIndex += 3;
+        pattern_.add(nft.forceBlocks[pi], fDiff);
       }
     }
 
@@ -460,7 +487,6 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
       const auto& forceData = rd.pgdata->forceDatas()[tfm.forcePos];
       const sva::PTransformd& X_0_b = rd.pgdata->mbc().bodyPosW[forceData.bodyIndex];
 
-      int forceIndex = int(tfm.gradientPos);
       double scale = scale_*tfm.scale;
       for(std::size_t pi = 0; pi < forceData.points.size(); ++pi)
       {
@@ -471,7 +497,7 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
         double coefB = 2.*scale*fPoint.y();
 
         auto fillGradient =
-          [forceIndex, pi, &X_0_pi, &forceData, &rd, &gradient, &tfm](int row, double coef)
+          [this, pi, &X_0_pi, &forceData, &rd, &tfm](int row, double coef)
         {
           const auto& jacPointMat =
               tfm.jac.vectorJacobian(rd.pgdata->mb(),
@@ -480,21 +506,14 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
               .block(3, 0, 3, tfm.jac.dof());
           tfm.jacMat.noalias() = (coef*forceData.forces[pi].force().transpose())*
             jacPointMat;
-          updateFullJacobianSparse(rd.pgdata->mb(), tfm.jac, tfm.jacMat,
-                                   tfm.jacMatFull,
-                                   {0, rd.pgdata->qParamsBegin()});
-          gradient += tfm.jacMatFull.transpose();
+          pattern_.add(tfm.jacBlock, tfm.jacMat);
 
           Eigen::RowVector3d fDiff;
           fDiff = coef*X_0_pi.rotation().row(row);
-          gradient.coeffRef(forceIndex + 0) += fDiff.x();
-          gradient.coeffRef(forceIndex + 1) += fDiff.y();
-          gradient.coeffRef(forceIndex + 2) += fDiff.z();
+          pattern_.add(tfm.forceBlocks[pi], fDiff);
         };
         fillGradient(0, coefT);
         fillGradient(1, coefB);
-
-        forceIndex += 3;
       }
     }
 
@@ -507,9 +526,7 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
       const Eigen::MatrixXd& jacMat = bp.jac.jacobian(rd.pgdata->mb(), rd.pgdata->mbc());
       bp.jacMat.noalias() = (scale_*bp.scale*2.*error.transpose())*\
           jacMat.block(3, 0, 3, bp.jac.dof());
-      updateFullJacobianSparse(rd.pgdata->mb(), bp.jac, bp.jacMat, bp.jacMatFull,
-                               {0, rd.pgdata->qParamsBegin()});
-      gradient += bp.jacMatFull.transpose();
+      pattern_.add(bp.jacBlock, bp.jacMat);
     }
 
 
@@ -521,11 +538,11 @@ void StdCostFunc::impl_gradient(gradient_t& gradient,
       const Eigen::MatrixXd& jacMat = bo.jac.jacobian(rd.pgdata->mb(), rd.pgdata->mbc());
       bo.jacMat.noalias() = (scale_*bo.scale*2.*error.transpose())*\
           jacMat.block(0, 0, 3, bo.jac.dof());
-      updateFullJacobianSparse(rd.pgdata->mb(), bo.jac, bo.jacMat, bo.jacMatFull,
-                               {0, rd.pgdata->qParamsBegin()});
-      gradient += bo.jacMatFull.transpose();
+      pattern_.add(bo.jacBlock, bo.jacMat);
     }
   }
+
+  pattern_.copyTo(gradient);
 }
 
 
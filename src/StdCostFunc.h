@@ -22,6 +22,9 @@
 // RBDyn
 #include <RBDyn/Jacobian.h>
 
+// PG
+#include "FillSparse.h"
+
 
 namespace pg
 {
@@ -38,11 +41,19 @@ public:
   StdCostFunc(std::vector<PGData>& pgdatas, const std::vector<RobotConfig>& robotConfigs,
               const std::vector<RunConfig>& runConfigs);
 
+  /// Copy the targets of robotConfigs and runConfigs (configs with the
+  /// same structure than the constructor ones).
+  void targets(const std::vector<RobotConfig>& robotConfigs,
+               const std::vector<RunConfig>& runConfigs);
+
   void impl_compute(result_t& res, const argument_t& x) const;
   void impl_gradient(gradient_t& gradient,
       const argument_t& x, size_type /* functionId */) const;
 
 private:
+  // jacBlock, forceBlocks and postureBlocks are gradient blocks in pattern_,
+  // forceBlocks have one 1x3 block by force point.
+
   struct BodyPositionTargetData
   {
     int bodyIndex;
@@ -50,7 +61,7 @@ private:
     double scale;
     rbd::Jacobian jac;
     Eigen::MatrixXd jacMat;
-    Eigen::SparseMatrix<double, Eigen::RowMajor> jacMatFull;
+    int jacBlock;
   };
 
   struct BodyOrientationTargetData
@@ -60,7 +71,7 @@ private:
     double scale;
     rbd::Jacobian jac;
     Eigen::MatrixXd jacMat;
-    Eigen::SparseMatrix<double, Eigen::RowMajor> jacMatFull;
+    int jacBlock;
   };
 
   struct ForceContactMinimizationData
@@ -68,6 +79,7 @@ private:
     std::size_t forcePos;
     std::size_t gradientPos;
     double scale;
+    std::vector<int> forceBlocks;
   };
 
   struct TorqueContactMinimizationData
@@ -79,10 +91,11 @@ private:
     rbd::Jacobian jac;
     Eigen::MatrixXd jacMat;
     Eigen::MatrixXd jacMatTmp;
-    Eigen::SparseMatrix<double, Eigen::RowMajor> jacMatFull;
     std::size_t forcePos;
     std::size_t gradientPos;
     double scale;
+    int jacBlock;
+    std::vector<int> forceBlocks;
   };
 
   struct NormalForceTargetData
@@ -92,8 +105,9 @@ private:
     double target;
     rbd::Jacobian jac;
     Eigen::MatrixXd jacMat;
-    Eigen::SparseMatrix<double, Eigen::RowMajor> jacMatFull;
     double scale;
+    int jacBlock;
+    std::vector<int> forceBlocks;
   };
 
   struct TangentialForceMinimizationData
@@ -102,8 +116,9 @@ private:
     std::size_t gradientPos;
     rbd::Jacobian jac;
     Eigen::MatrixXd jacMat;
-    Eigen::SparseMatrix<double, Eigen::RowMajor> jacMatFull;
     double scale;
+    int jacBlock;
+    std::vector<int> forceBlocks;
   };
 
   struct RobotData
@@ -114,6 +129,8 @@ private:
     double torqueScale;
     double forceScale;
     double ellipseScale;
+    std::vector<int> postureBlocks;
+    std::vector<int> forceBlocks;
     std::vector<BodyPositionTargetData> bodyPosTargets;
     std::vector<BodyOrientationTargetData> bodyOriTargets;
     std::vector<ForceContactMinimizationData> forceContactsMin;
@@ -122,9 +139,14 @@ private:
     std::vector<TangentialForceMinimizationData> tanForceMin;
   };
 
+private:
+  /// Force blocks of the nrPoints force points starting at gradientPos.
+  std::vector<int> addForceBlocks(std::size_t gradientPos, std::size_t nrPoints);
+
 private:
   mutable std::vector<RobotData> robotDatas_;
   double scale_;
+  mutable SparsePattern pattern_;
 };
 
 } // namespace pg
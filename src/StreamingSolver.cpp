@@ -0,0 +1,281 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "StreamingSolver.h"
+
+// include
+// std
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+
+namespace pg
+{
+
+
+/// Set the target of update.param to the update value.
+static void applyUpdate(const TargetUpdate& update,
+                        std::vector<RobotConfig>& robotConfigs,
+                        std::vector<RunConfig>& configs)
+{
+  const TargetParameter& param = update.param;
+  RobotConfig& rc = robotConfigs[param.robot];
+  switch(param.kind)
+  {
+    case TargetParameter::BodyPosition:
+      rc.bodyPosTargets[param.index].target = update.frame.translation();
+      break;
+    case TargetParameter::BodyOrientation:
+      rc.bodyOriTargets[param.index].target = update.frame.rotation();
+      break;
+    case TargetParameter::FixedPosition:
+      rc.fixedPosContacts[param.index].target = update.frame.translation();
+      break;
+    case TargetParameter::FixedOrientation:
+      rc.fixedOriContacts[param.index].target = update.frame.rotation();
+      break;
+    case TargetParameter::PlanarFrame:
+      rc.planarContacts[param.index].targetFrame = update.frame;
+      break;
+    case TargetParameter::TargetQ:
+    {
+      std::vector<double>& target = configs[param.robot].targetQ[param.index];
+      for(std::size_t i = 0; i < target.size(); ++i)
+      {
+        target[i] = update.q[i];
+      }
+      break;
+    }
+  }
+}
+
+
+StreamingSolver::StreamingSolver(std::size_t queueSize)
+  : pg_()
+  , queue_(queueSize)
+  , solutions_(StreamingSolution())
+  , iterationsPerCycle_(10)
+  , idlePeriod_(1e-4)
+  , configs_()
+  , problem_()
+  , stop_(std::make_shared<std::atomic<bool>>(false))
+  , running_(false)
+  , error_()
+  , thread_()
+{}
+
+
+StreamingSolver::~StreamingSolver()
+{
+  if(thread_.joinable())
+  {
+    *stop_ = true;
+    thread_.join();
+  }
+}
+
+
+PostureGenerator& StreamingSolver::solver()
+{
+  return pg_;
+}
+
+
+const PostureGenerator& StreamingSolver::solver() const
+{
+  return pg_;
+}
+
+
+void StreamingSolver::iterationsPerCycle(int nrIter)
+{
+  iterationsPerCycle_ = nrIter;
+}
+
+
+int StreamingSolver::iterationsPerCycle() const
+{
+  return iterationsPerCycle_;
+}
+
+
+void StreamingSolver::idlePeriod(double seconds)
+{
+  idlePeriod_ = seconds;
+}
+
+
+double StreamingSolver::idlePeriod() const
+{
+  return idlePeriod_;
+}
+
+
+void StreamingSolver::start(const std::vector<RunConfig>& configs)
+{
+  if(thread_.joinable())
+  {
+    throw std::logic_error("Stream already started");
+  }
+  bool lockedJoints = std::any_of(configs.begin(), configs.end(),
+    [](const RunConfig& rc) {return !rc.lockedJoints.empty();});
+  if(pg_.modelReduction() || lockedJoints)
+  {
+    throw std::logic_error("Model reduction is not supported by the stream");
+  }
+
+  configs_ = configs;
+  pg_.maxIterations(iterationsPerCycle_);
+  pg_.iterateRecording(IterateRecording(IterateRecording::Off));
+  pg_.iters_->start();
+  pg_.iters_->startDeadline(0.);
+  pg_.profile_ = Profile();
+  pg_.tracer_.start(pg_.tracing() ? std::max(int(pg_.pgdatas_.size()), 1) : 0);
+  problem_ = pg_.buildProblem(configs_);
+  pg_.startingPoint(*problem_, configs_);
+
+  pg_.iters_->cancel = stop_;
+  *stop_ = false;
+  error_ = nullptr;
+  running_ = true;
+  thread_ = std::thread([this]()
+  {
+    try
+    {
+      loop();
+    }
+    catch(...)
+    {
+      error_ = std::current_exception();
+    }
+    running_ = false;
+  });
+}
+
+
+void StreamingSolver::stop()
+{
+  if(!thread_.joinable())
+  {
+    return;
+  }
+
+  *stop_ = true;
+  thread_.join();
+  pg_.iters_->cancel.reset();
+  problem_.reset();
+  if(error_)
+  {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+
+bool StreamingSolver::running() const
+{
+  return running_;
+}
+
+
+int StreamingSolver::qParamsBegin(int robot) const
+{
+  return pg_.qParamsBegin(robot);
+}
+
+
+bool StreamingSolver::push(const TargetUpdate& update)
+{
+  // targets are changed by the solver thread but not their number
+  if(parameterSize(pg_.robotConfigs_, update.param) > int(update.q.size()))
+  {
+    throw std::out_of_range("Target with too many parameters");
+  }
+  return queue_.push(update);
+}
+
+
+bool StreamingSolver::update()
+{
+  return solutions_.update();
+}
+
+
+const StreamingSolution& StreamingSolver::solution() const
+{
+  return solutions_.read();
+}
+
+
+void StreamingSolver::loop()
+{
+  typedef std::chrono::steady_clock clock;
+
+  std::uint64_t cycle = 0, nrUpdates = 0;
+  bool idle = false, warmStart = false;
+  while(!*stop_)
+  {
+    int nrApplied = applyUpdates();
+    nrUpdates += nrApplied;
+    if(idle && nrApplied == 0)
+    {
+      std::this_thread::sleep_for(std::chrono::duration<double>(idlePeriod_));
+      continue;
+    }
+
+    clock::time_point start = clock::now();
+    pg_.resolve(*problem_, configs_, warmStart);
+    double solveTime = std::chrono::duration<double>(clock::now() - start).count();
+    // a stopped run don't have a meaningful result
+    if(*stop_)
+    {
+      break;
+    }
+
+    ++cycle;
+    PostureGenerator::ResultSelection selection = pg_.resultSelection();
+    idle = selection == PostureGenerator::Converged;
+    // next cycles start from the last solution
+    warmStart = warmStart || selection != PostureGenerator::NoResult;
+
+    StreamingSolution& solution = solutions_.back();
+    solution.x = pg_.x_;
+    solution.selection = selection;
+    solution.nrIters = pg_.iters_->nrIterations;
+    solution.cycle = cycle;
+    solution.nrUpdates = nrUpdates;
+    solution.solveTime = solveTime;
+    solutions_.publish();
+  }
+}
+
+
+int StreamingSolver::applyUpdates()
+{
+  int nrApplied = 0;
+  TargetUpdate update;
+  while(queue_.pop(update))
+  {
+    applyUpdate(update, pg_.robotConfigs_, configs_);
+    ++nrApplied;
+  }
+  return nrApplied;
+}
+
+
+} // pg
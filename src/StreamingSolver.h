@@ -0,0 +1,195 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Eigen
+#include <Eigen/Core>
+
+// SpaceVecAlg
+#include <SpaceVecAlg/SpaceVecAlg>
+
+// PG
+#include "ConfigStruct.h"
+#include "PostureGenerator.h"
+#include "Sensitivity.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+
+namespace pg
+{
+
+/// New value of a target of a StreamingSolver problem.
+struct TargetUpdate
+{
+  TargetUpdate()
+    : param()
+    , frame(sva::PTransformd::Identity())
+    , q()
+  {}
+  /// Position (frame translation), orientation (frame rotation)
+  /// or planar contact frame target.
+  TargetUpdate(const TargetParameter& p, const sva::PTransformd& f)
+    : param(p)
+    , frame(f)
+    , q()
+  {}
+  /// TargetQ of the joint param.index.
+  TargetUpdate(const TargetParameter& p, const std::vector<double>& jointQ)
+    : param(p)
+    , frame(sva::PTransformd::Identity())
+    , q()
+  {
+    for(std::size_t i = 0; i < jointQ.size() && i < q.size(); ++i)
+    {
+      q[i] = jointQ[i];
+    }
+  }
+
+  TargetParameter param;
+  sva::PTransformd frame;
+  /// Joint parameters of a TargetQ update.
+  std::array<double, 7> q;
+};
+
+
+struct StreamingSolution
+{
+  StreamingSolution()
+    : x()
+    , selection(PostureGenerator::NoResult)
+    , nrIters(0)
+    , cycle(0)
+    , nrUpdates(0)
+    , solveTime(0.)
+  {}
+
+  /// Last solution: joints parameters of each robot from
+  /// StreamingSolver::qParamsBegin, then the forces.
+  Eigen::VectorXd x;
+  /// Result of the cycle, x is the previous solution if NoResult.
+  PostureGenerator::ResultSelection selection;
+  int nrIters;
+  /// Number of solved cycles.
+  std::uint64_t cycle;
+  /// Number of target updates applied before the cycle.
+  std::uint64_t nrUpdates;
+  /// Cycle solving time in seconds.
+  double solveTime;
+};
+
+
+/**
+  * Solve a problem continuously on a dedicated thread for a control loop.
+  * The problem functions and the solver are built once by start and kept
+  * until stop. Targets updates are received through a lock-free queue,
+  * each cycle copy them in the functions and run the solver from the
+  * previous solution with at most iterationsPerCycle iterations.
+  * Each cycle solution is published through a triple buffer: push, update
+  * and solution never block nor allocate.
+  * The solver thread sleep when the last cycle converged and no target
+  * changed.
+  * Model reduction, the posture database, the reachability maps and the
+  * sensitivity are not used by the stream.
+  */
+class StreamingSolver
+{
+public:
+  /// @param queueSize Capacity of the target updates queue.
+  StreamingSolver(std::size_t queueSize=256);
+  /// Stop the solver thread.
+  ~StreamingSolver();
+
+  /// Problem solved by the stream. Robots, links and solver options must
+  /// be set before start and not be changed until stop.
+  PostureGenerator& solver();
+  const PostureGenerator& solver() const;
+
+  /// Solver iterations limit of each cycle (default 10).
+  void iterationsPerCycle(int nrIter);
+  int iterationsPerCycle() const;
+
+  /// Sleep time of the idle solver thread between two queue checks
+  /// (default 1e-4 seconds).
+  void idlePeriod(double seconds);
+  double idlePeriod() const;
+
+  /**
+    * Build the problem of configs and start the solver thread from
+    * configs initQ and initForces.
+    * The solver iterations limit is set to iterationsPerCycle and the
+    * iterates recording is disabled.
+    * @throw std::logic_error if the stream is already started or if
+    * model reduction or locked joints are used.
+    */
+  void start(const std::vector<RunConfig>& configs);
+  /// Stop the solver thread and rethrow its exception if any.
+  void stop();
+  /// False after stop or after an exception of the solver thread
+  /// (stop then rethrow it).
+  bool running() const;
+
+  /// Index of robot joints parameters in StreamingSolution::x.
+  int qParamsBegin(int robot) const;
+
+  /**
+    * Control thread: queue a target update applied at the next cycle.
+    * @return false if the queue is full.
+    * @throw std::out_of_range if update.param don't exist in the problem.
+    */
+  bool push(const TargetUpdate& update);
+
+  /**
+    * Control thread: take the last published solution.
+    * @return true if a new solution was published since the last update.
+    */
+  bool update();
+  /// Control thread: solution taken by the last update.
+  const StreamingSolution& solution() const;
+
+private:
+  void loop();
+  /// @return Number of applied updates.
+  int applyUpdates();
+
+private:
+  PostureGenerator pg_;
+  SpscQueue<TargetUpdate> queue_;
+  TripleBuffer<StreamingSolution> solutions_;
+  int iterationsPerCycle_;
+  double idlePeriod_;
+
+  std::vector<RunConfig> configs_;
+  /// Built by start, destroyed before pg_.
+  boost::shared_ptr<PostureGenerator::Problem> problem_;
+  /// Stop the solver thread and its current run.
+  std::shared_ptr<std::atomic<bool>> stop_;
+  std::atomic<bool> running_;
+  std::exception_ptr error_;
+  std::thread thread_;
+};
+
+} // namespace pg
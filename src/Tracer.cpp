@@ -0,0 +1,155 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// associated header
+#include "Tracer.h"
+
+// include
+// std
+#include <fstream>
+#include <stdexcept>
+
+// PG
+#include "JSON.h"
+
+
+namespace pg
+{
+
+
+Tracer::Tracer()
+  : names_({"build", "solve", "iteration", "fk", "collision",
+            "compute", "jacobian", "gradient", "run", "function", "robot"})
+  , lanes_()
+  , laneCapacity_(1 << 17)
+  , origin_(clock::now())
+{}
+
+
+void Tracer::start(int nrLanes)
+{
+  names_.resize(NrNames);
+  // lanes are reused to only allocate their events when the capacity change
+  lanes_.resize(std::size_t(nrLanes));
+  for(TraceBuffer& tb: lanes_)
+  {
+    tb.clear(laneCapacity_);
+  }
+  origin_ = clock::now();
+}
+
+
+void Tracer::laneCapacity(int capacity)
+{
+  if(capacity < 0)
+  {
+    throw std::domain_error("Trace lane capacity must be positive");
+  }
+  laneCapacity_ = capacity;
+}
+
+
+int Tracer::laneCapacity() const
+{
+  return laneCapacity_;
+}
+
+
+int Tracer::name(const std::string& name)
+{
+  names_.push_back(name);
+  return int(names_.size()) - 1;
+}
+
+
+TraceBuffer* Tracer::lane(int i)
+{
+  return &lanes_.at(i);
+}
+
+
+int Tracer::nrLanes() const
+{
+  return int(lanes_.size());
+}
+
+
+int Tracer::nrEvents() const
+{
+  int nrEvents = 0;
+  for(const TraceBuffer& tb: lanes_)
+  {
+    nrEvents += tb.size();
+  }
+  return nrEvents;
+}
+
+
+int Tracer::nrDropped() const
+{
+  int nrDropped = 0;
+  for(const TraceBuffer& tb: lanes_)
+  {
+    nrDropped += tb.nrDropped();
+  }
+  return nrDropped;
+}
+
+
+void Tracer::write(std::ostream& out) const
+{
+  typedef std::chrono::duration<double, std::micro> us;
+
+  out << "{\"traceEvents\":[";
+  bool first = true;
+  for(std::size_t laneIndex = 0; laneIndex < lanes_.size(); ++laneIndex)
+  {
+    out << (first ? "\n" : ",\n");
+    first = false;
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << laneIndex
+        << ",\"args\":{\"name\":";
+    writeJSONString(out, laneIndex == 0 ? std::string("solver") :
+                    "robot " + std::to_string(laneIndex) + " update");
+    out << "}}";
+
+    const TraceBuffer& tb = lanes_[laneIndex];
+    for(int i = 0; i < tb.size(); ++i)
+    {
+      const TraceEvent& e = tb[i];
+      out << ",\n{\"name\":";
+      writeJSONString(out, names_[e.name]);
+      out << ",\"cat\":";
+      writeJSONString(out, names_[e.category]);
+      out << ",\"ph\":\"X\",\"ts\":" << us(e.begin - origin_).count()
+          << ",\"dur\":" << us(e.end - e.begin).count()
+          << ",\"pid\":0,\"tid\":" << laneIndex << "}";
+    }
+  }
+  out << "\n],\"otherData\":{\"droppedEvents\":" << nrDropped() << "}}\n";
+}
+
+
+void Tracer::write(const std::string& file) const
+{
+  std::ofstream out(file);
+  if(!out)
+  {
+    throw std::runtime_error("Can't open trace file " + file);
+  }
+  write(out);
+}
+
+
+} // pg
@@ -0,0 +1,203 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+namespace pg
+{
+
+/// Span recorded by a TraceBuffer.
+struct TraceEvent
+{
+  typedef std::chrono::steady_clock clock;
+
+  int name, category;
+  clock::time_point begin, end;
+};
+
+
+/**
+  * Spans of one lane. A lane is only written by one thread at a time
+  * (the solver thread or a PGDataGroup worker) so no lock is needed.
+  * The events are preallocated, spans added when the buffer is full
+  * are only counted.
+  */
+class TraceBuffer
+{
+public:
+  typedef TraceEvent::clock clock;
+
+public:
+  TraceBuffer(int capacity=0)
+    : events_(std::size_t(capacity))
+    , size_(0)
+    , nrDropped_(0)
+  {}
+
+  void add(int name, int category, clock::time_point begin, clock::time_point end)
+  {
+    if(size_ < events_.size())
+    {
+      events_[size_++] = {name, category, begin, end};
+    }
+    else
+    {
+      ++nrDropped_;
+    }
+  }
+
+  /// Remove all spans, memory is kept if capacity don't change.
+  void clear(int capacity)
+  {
+    events_.resize(std::size_t(capacity));
+    size_ = 0;
+    nrDropped_ = 0;
+  }
+
+  int size() const
+  {
+    return int(size_);
+  }
+
+  int capacity() const
+  {
+    return int(events_.size());
+  }
+
+  /// Number of spans not recorded because the buffer was full.
+  int nrDropped() const
+  {
+    return nrDropped_;
+  }
+
+  const TraceEvent& operator[](int i) const
+  {
+    return events_[std::size_t(i)];
+  }
+
+private:
+  std::vector<TraceEvent> events_;
+  std::size_t size_;
+  int nrDropped_;
+};
+
+
+/**
+  * Record the spans of a run in lanes and export them in the Chrome trace
+  * event format (chrome://tracing, Perfetto).
+  * Lane 0 is the solver thread, lane i > 0 the update thread of robot i
+  * with PostureGenerator::parallelUpdate.
+  */
+class Tracer
+{
+public:
+  typedef TraceEvent::clock clock;
+
+  /// Predefined names and categories.
+  enum Name
+  {
+    Build,
+    Solve,
+    Iteration,
+    FK,
+    Collision,
+    Compute,
+    Jacobian,
+    Gradient,
+    Run,
+    Function,
+    Robot,
+    NrNames
+  };
+
+public:
+  Tracer();
+
+  /// Remove all spans and set nrLanes empty lanes of laneCapacity events.
+  /// Lane pointers are invalidated.
+  void start(int nrLanes);
+
+  /// Number of spans a lane can record, applied at the next start.
+  void laneCapacity(int capacity);
+  int laneCapacity() const;
+
+  /// Name id of name, names are only added between start and the solve.
+  int name(const std::string& name);
+
+  /// @return lane i, valid until the next start.
+  TraceBuffer* lane(int i);
+
+  int nrLanes() const;
+  int nrEvents() const;
+  /// Number of spans dropped by full lanes.
+  int nrDropped() const;
+
+  /// Write the spans as a Chrome trace JSON object.
+  void write(std::ostream& out) const;
+  /// @throw std::runtime_error if file can't be written.
+  void write(const std::string& file) const;
+
+private:
+  std::vector<std::string> names_;
+  std::vector<TraceBuffer> lanes_;
+  int laneCapacity_;
+  clock::time_point origin_;
+};
+
+
+/// Add the lifetime of this object to buffer, do nothing if buffer is null.
+class ScopedTrace
+{
+public:
+  typedef TraceEvent::clock clock;
+
+public:
+  ScopedTrace(TraceBuffer* buffer, int name, int category)
+    : buffer_(buffer)
+    , name_(name)
+    , category_(category)
+  {
+    if(buffer_)
+    {
+      begin_ = clock::now();
+    }
+  }
+
+  ~ScopedTrace()
+  {
+    if(buffer_)
+    {
+      buffer_->add(name_, category_, begin_, clock::now());
+    }
+  }
+
+  ScopedTrace(const ScopedTrace&) = delete;
+  ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+  TraceBuffer* buffer_;
+  int name_, category_;
+  clock::time_point begin_;
+};
+
+} // namespace pg
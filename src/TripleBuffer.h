@@ -0,0 +1,86 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// include
+// std
+#include <array>
+#include <atomic>
+
+
+namespace pg
+{
+
+/**
+  * Wait-free publication of the last value written by one writer thread
+  * to one reader thread. Each side owns one of the three buffers, the third
+  * holds the last published value and is exchanged atomically.
+  */
+template <typename T>
+class TripleBuffer
+{
+public:
+  /// All the buffers are copies of init, read() return it until the
+  /// first publish.
+  TripleBuffer(const T& init)
+    : buffers_{{init, init, init}}
+    , front_(0)
+    , middle_(1)
+    , back_(2)
+  {}
+
+  /// Writer thread: buffer to fill before publish.
+  T& back()
+  {
+    return buffers_[back_];
+  }
+
+  /// Writer thread: make back() the value returned by the next update.
+  void publish()
+  {
+    back_ = middle_.exchange(back_ | newBit, std::memory_order_acq_rel) & indexMask;
+  }
+
+  /// Reader thread: take the last published value.
+  /// @return false if nothing was published since the last update.
+  bool update()
+  {
+    if(!(middle_.load(std::memory_order_relaxed) & newBit))
+    {
+      return false;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & indexMask;
+    return true;
+  }
+
+  /// Reader thread: value taken by the last update.
+  const T& read() const
+  {
+    return buffers_[front_];
+  }
+
+private:
+  static const int indexMask = 3;
+  static const int newBit = 4;
+
+private:
+  std::array<T, 3> buffers_;
+  int front_;
+  std::atomic<int> middle_;
+  int back_;
+};
+
+} // namespace pg
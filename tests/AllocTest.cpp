@@ -0,0 +1,497 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// include
+// std
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <tuple>
+
+// boost
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/get.hpp>
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Alloc test
+#include <boost/test/unit_test.hpp>
+#include <boost/math/constants/constants.hpp>
+
+// roboptim
+#include <roboptim/core/solver-factory.hh>
+
+// sch
+#include <sch/S_Object/S_Sphere.h>
+
+// PG
+#include "ConfigStruct.h"
+#include "PGData.h"
+#include "FixedContactConstr.h"
+#include "PlanarSurfaceConstr.h"
+#include "StaticStabilityConstr.h"
+#include "PositiveForceConstr.h"
+#include "FrictionConeConstr.h"
+#include "CollisionConstr.h"
+#include "StdCostFunc.h"
+#include "LeastSquaresCostFunc.h"
+#include "RobotLinkConstr.h"
+#include "CylindricalSurfaceConstr.h"
+#include "CoMHalfSpaceConstr.h"
+#include "PostureGenerator.h"
+#include "SolverBackend.h"
+
+// Arm
+#include "XYZ12Arm.h"
+#include "Z12Arm.h"
+
+const Eigen::Vector3d gravity(0., 9.81, 0.);
+
+
+/*
+ *   Allocation hooks
+ */
+
+
+static std::atomic<bool> countAllocations(false);
+static std::atomic<int> nrAllocations(0);
+/// Only count the allocations made inside the solver callbacks.
+static std::atomic<bool> countCallbackAllocations(false);
+static thread_local int callbackDepth = 0;
+
+
+static void countAllocation()
+{
+  if(countAllocations || (countCallbackAllocations && callbackDepth > 0))
+  {
+    ++nrAllocations;
+  }
+}
+
+
+// Eigen allocate with malloc, we can only hook it with glibc
+#ifdef __GLIBC__
+extern "C"
+{
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t n, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+
+void* malloc(std::size_t size) __THROW
+{
+  countAllocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t n, std::size_t size) __THROW
+{
+  countAllocation();
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, std::size_t size) __THROW
+{
+  countAllocation();
+  return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+#endif
+
+
+void* operator new(std::size_t size)
+{
+  // with glibc the malloc hook already count this allocation
+#ifndef __GLIBC__
+  countAllocation();
+#endif
+  void* ptr = std::malloc(size);
+  if(!ptr)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+
+void operator delete[](void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+
+/// Number of allocations made by f.
+template <typename F>
+int allocations(F f)
+{
+  nrAllocations = 0;
+  countAllocations = true;
+  f();
+  countAllocations = false;
+  return nrAllocations;
+}
+
+
+/// Evaluate function value and jacobian at x0 to build their structure
+/// then check that evaluating them at x1 don't allocate.
+template <typename T>
+void checkNoAllocation(const roboptim::GenericDifferentiableFunction<T>& function,
+                       const Eigen::VectorXd& x0, const Eigen::VectorXd& x1)
+{
+  typename roboptim::GenericDifferentiableFunction<T>::result_t res(function.outputSize());
+  typename roboptim::GenericFunctionTraits<T>::jacobian_t jac(
+    std::get<0>(function.jacobianSize()),
+    std::get<1>(function.jacobianSize()));
+
+  function(res, x0);
+  function.jacobian(jac, x0);
+
+  BOOST_CHECK_EQUAL(allocations([&]() { function(res, x1); }), 0);
+  BOOST_CHECK_EQUAL(allocations([&]() { function.jacobian(jac, x1); }), 0);
+}
+
+
+/// Same as checkNoAllocation but on a cost gradient.
+template <typename T>
+void checkGradientNoAllocation(const roboptim::GenericDifferentiableFunction<T>& function,
+                               const Eigen::VectorXd& x0, const Eigen::VectorXd& x1)
+{
+  typename roboptim::GenericDifferentiableFunction<T>::result_t res(function.outputSize());
+  typename roboptim::GenericDifferentiableFunction<T>::gradient_t grad(function.inputSize());
+
+  function(res, x0);
+  function.gradient(grad, x0, 0);
+
+  BOOST_CHECK_EQUAL(allocations([&]() { function(res, x1); }), 0);
+  BOOST_CHECK_EQUAL(allocations([&]() { function.gradient(grad, x1, 0); }), 0);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(ConstraintsAllocationTest)
+{
+  using namespace Eigen;
+  namespace cst = boost::math::constants;
+
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  std::tie(mb, mbc) = makeXYZ12Arm();
+
+  int qBegin = 5;
+  int nrForces = 8*3;
+  int nrVar = mb.nrParams() + nrForces + qBegin;
+
+  pg::PGData pgdata(mb, gravity, nrVar, qBegin, mb.nrParams() + qBegin);
+
+  sva::PTransformd bodySurface(sva::RotZ(-cst::pi<double>()/2.), Vector3d(0., 1., 0.));
+  std::vector<Vector2d> surfPoints = {{0.1, 0.1}, {-0.1, 0.1}, {-0.1, -0.1}, {0.1, -0.1}};
+  std::vector<sva::PTransformd> points(surfPoints.size());
+  for(std::size_t i = 0; i < points.size(); ++i)
+  {
+    points[i] = sva::PTransformd(Vector3d(surfPoints[i][0], surfPoints[i][1], 0.))*bodySurface;
+  }
+  pgdata.forces({pg::ForceContact{12, points, 0.7}, pg::ForceContact{0, points, 0.7}});
+
+  sva::PTransformd target(sva::RotZ(-cst::pi<double>()), Vector3d(0., 1., 0.));
+  Matrix3d oriTarget(sva::RotZ(cst::pi<double>()));
+  std::vector<Vector2d> targetPoints = {{1., 1.}, {-0., 1.}, {-0., -1.}, {1., -1.}};
+
+  pg::FixedPositionContactConstr fpc(&pgdata, 12, target.translation(), bodySurface);
+  pg::FixedOrientationContactConstr foc(&pgdata, 12, oriTarget, bodySurface);
+  pg::PlanarPositionContactConstr ppc(&pgdata, 12, target, bodySurface);
+  pg::PlanarOrientationContactConstr poc(&pgdata, 12, target, bodySurface, 1);
+  pg::PlanarInclusionConstr pic(&pgdata, 12, target, targetPoints,
+                                bodySurface, surfPoints);
+  pg::CylindricalPositionConstr cpc(&pgdata, 12, target, bodySurface);
+  pg::CylindricalNVecConstr cnc(&pgdata, 12, target, bodySurface);
+  pg::CoMHalfSpaceConstr chs(&pgdata, {Vector3d(2., 0., 0.)}, {Vector3d(0., 1., 0.)});
+  pg::PositiveForceConstr pfc(&pgdata);
+  pg::FrictionConeConstr fcc(&pgdata);
+  pg::StaticStabilityConstr ssc(&pgdata);
+
+  sch::S_Sphere hullBody1(0.2);
+  sch::S_Sphere hullBody2(0.2);
+  sch::S_Sphere hullEnv(0.5);
+  hullEnv.setTransformation(pg::tosch(sva::PTransformd::Identity()));
+  pg::EnvCollisionConstr ecc(&pgdata,
+    {pg::EnvCollision(12, &hullBody1, sva::PTransformd::Identity(), &hullEnv, 0.1)});
+  pg::SelfCollisionConstr scc(&pgdata,
+    {pg::SelfCollision(12, &hullBody1, sva::PTransformd::Identity(),
+                       6, &hullBody2, sva::PTransformd::Identity(), 0.1)});
+
+  VectorXd x0(VectorXd::Random(pgdata.pbSize()));
+  VectorXd x1(VectorXd::Random(pgdata.pbSize()));
+
+  checkNoAllocation(fpc, x0, x1);
+  checkNoAllocation(foc, x0, x1);
+  checkNoAllocation(ppc, x0, x1);
+  checkNoAllocation(poc, x0, x1);
+  checkNoAllocation(pic, x0, x1);
+  checkNoAllocation(cpc, x0, x1);
+  checkNoAllocation(cnc, x0, x1);
+  checkNoAllocation(chs, x0, x1);
+  checkNoAllocation(pfc, x0, x1);
+  checkNoAllocation(fcc, x0, x1);
+  checkNoAllocation(ssc, x0, x1);
+  checkNoAllocation(ecc, x0, x1);
+  checkNoAllocation(scc, x0, x1);
+}
+
+
+BOOST_AUTO_TEST_CASE(RobotLinkAllocationTest)
+{
+  using namespace Eigen;
+
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  std::tie(mb, mbc) = makeXYZ12Arm();
+
+  int qBegin = 5;
+  int qBegin2 = qBegin + mb.nrParams();
+  int nrVar = mb.nrParams()*2 + qBegin;
+
+  pg::PGData pgdata1(mb, gravity, nrVar, qBegin, mb.nrParams() + qBegin);
+  pg::PGData pgdata2(mb, gravity, nrVar, qBegin2, mb.nrParams() + qBegin2);
+  sva::PTransformd bT(Vector3d(0.1, 0.2, 0.3));
+
+  pg::RobotLinkConstr rlc(&pgdata1, &pgdata2, {{12, bT, bT}, {6, bT, bT}});
+
+  checkNoAllocation(rlc, VectorXd::Random(pgdata1.pbSize()),
+                    VectorXd::Random(pgdata1.pbSize()));
+}
+
+
+BOOST_AUTO_TEST_CASE(CostAllocationTest)
+{
+  using namespace Eigen;
+  namespace cst = boost::math::constants;
+
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbc;
+  std::tie(mb, mbc) = makeXYZ12Arm();
+
+  int qBegin = 5;
+  int nrForces = 4*3;
+  int nrVar = mb.nrParams() + nrForces + qBegin;
+
+  std::vector<pg::PGData> pgdatas;
+  pgdatas.push_back({mb, gravity, nrVar, qBegin, mb.nrParams() + qBegin});
+
+  Matrix3d frame(sva::RotX(-cst::pi<double>()/2.));
+  Matrix3d frameEnd(sva::RotX(cst::pi<double>()/2.));
+  std::vector<pg::ForceContact> forceContacts =
+    {{0 , {sva::PTransformd(frame, Vector3d(0.01, 0., 0.)),
+           sva::PTransformd(frame, Vector3d(-0.01, 0., 0.))}, 1.},
+     {12, {sva::PTransformd(frameEnd, Vector3d(0.01, 0., 0.)),
+      sva::PTransformd(frameEnd, Vector3d(-0.01, 0., 0.))}, 1.}};
+  pgdatas.back().forces(forceContacts);
+
+  pg::RunConfig runConfig;
+  pg::RobotConfig robotConfig;
+  runConfig.targetQ = mbc.q;
+
+  robotConfig.postureScale = 1.;
+  robotConfig.forceScale = 1.;
+  robotConfig.bodyPosTargets = {{12, Vector3d(1.5, 0., 0.), 1.}};
+  robotConfig.bodyOriTargets = {{12, Matrix3d(sva::RotZ(-cst::pi<double>())), 1.}};
+  robotConfig.forceContactsMin = {{12, 1.}};
+  robotConfig.torqueContactsMin = {{12, Vector3d(0.1, 0., 0.),
+                                    Vector3d::UnitZ(), 1.}};
+  robotConfig.normalForceTargets = {{12, 2., 1.}};
+  robotConfig.tanForceMin = {{12, 1.}};
+
+  pg::StdCostFunc cost(pgdatas, {robotConfig}, {runConfig});
+  pg::LeastSquaresCostFunc lsCost(pgdatas, {robotConfig}, {runConfig});
+
+  VectorXd x0(VectorXd::Random(pgdatas.back().pbSize()));
+  VectorXd x1(VectorXd::Random(pgdatas.back().pbSize()));
+
+  checkGradientNoAllocation(cost, x0, x1);
+  checkNoAllocation(lsCost, x0, x1);
+}
+
+
+/*
+ *   Solver callbacks
+ */
+
+
+/// Forward evaluations to function and count their allocations.
+class CountedFunction : public roboptim::DifferentiableSparseFunction
+{
+public:
+  typedef typename parent_t::argument_t argument_t;
+
+public:
+  /// function must outlive this function.
+  CountedFunction(const roboptim::DifferentiableSparseFunction& function)
+    : roboptim::DifferentiableSparseFunction(function.inputSize(),
+                                             function.outputSize(),
+                                             function.getName())
+    , function_(function)
+  {}
+
+  void impl_compute(result_t& res, const argument_t& x) const
+  {
+    ++callbackDepth;
+    function_(res, x);
+    --callbackDepth;
+  }
+
+  void impl_jacobian(jacobian_t& jac, const argument_t& x) const
+  {
+    ++callbackDepth;
+    function_.jacobian(jac, x);
+    --callbackDepth;
+  }
+
+  void impl_gradient(gradient_t& gradient,
+      const argument_t& x, size_type functionId) const
+  {
+    ++callbackDepth;
+    function_.gradient(gradient, x, functionId);
+    --callbackDepth;
+  }
+
+private:
+  const roboptim::DifferentiableSparseFunction& function_;
+};
+
+
+/// Wrap a linear or non linear constraint in a CountedFunction.
+struct CountedConstraint : public boost::static_visitor<
+  boost::shared_ptr<roboptim::DifferentiableSparseFunction>>
+{
+  template <typename T>
+  boost::shared_ptr<roboptim::DifferentiableSparseFunction>
+  operator()(const boost::shared_ptr<T>& constr) const
+  {
+    return boost::shared_ptr<roboptim::DifferentiableSparseFunction>(
+      new CountedFunction(*constr));
+  }
+};
+
+
+/**
+  * IPOPT on a copy of the problem with the cost and constraints evaluations
+  * and the iteration callback wrapped to count their allocations.
+  * The first iterations size the solver and iterates buffers, allocations
+  * are counted from the second iteration.
+  */
+class CountingBackend : public pg::SolverBackend
+{
+public:
+  CountingBackend()
+    : nrIterations(0)
+  {}
+
+  virtual std::string name() const
+  {
+    return "counting ipopt-sparse";
+  }
+
+  virtual bool solve(const Description& pb, const parameters_t& params,
+                     iteration_callback_t& iters, Eigen::VectorXd& x)
+  {
+    CountedFunction cost(pb.problem->function());
+    problem_t problem(cost);
+    problem.startingPoint() = pb.problem->startingPoint();
+    problem.argumentBounds() = pb.problem->argumentBounds();
+    for(std::size_t i = 0; i < pb.problem->constraints().size(); ++i)
+    {
+      problem.addConstraint(
+        boost::apply_visitor(CountedConstraint(), pb.problem->constraints()[i]),
+        pb.problem->boundsVector()[i], pb.problem->scalesVector()[i]);
+    }
+
+    roboptim::SolverFactory<solver_t> factory("ipopt-sparse", problem);
+    solver_t& solver = factory();
+    solver.setIterationCallback(solver_t::callback_t(
+      [this, &iters](const problem_t& p, solver_t::solverState_t& state)
+      {
+        ++callbackDepth;
+        iters(p, state);
+        --callbackDepth;
+        ++nrIterations;
+        countCallbackAllocations = nrIterations >= 2;
+      }));
+    for(const auto& p: params)
+    {
+      solver.parameters()[p.first] = p.second;
+    }
+
+    const solver_t::result_t& res = solver.minimum();
+    countCallbackAllocations = false;
+    if(res.which() == solver_t::SOLVER_VALUE)
+    {
+      x = boost::get<roboptim::Result>(res).x;
+      return true;
+    }
+    if(res.which() == solver_t::SOLVER_VALUE_WARNINGS)
+    {
+      x = boost::get<roboptim::ResultWithWarnings>(res).x;
+      return true;
+    }
+    return false;
+  }
+
+  int nrIterations;
+};
+
+
+BOOST_AUTO_TEST_CASE(SolverCallbacksAllocationTest)
+{
+  using namespace Eigen;
+
+  rbd::MultiBody mb;
+  rbd::MultiBodyConfig mbcInit;
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{12, Vector3d(2., 0., 0.), sva::PTransformd::Identity()}};
+  rc.postureScale = 1.;
+
+  // functions are evaluated directly and through ProfiledFunction when profiling
+  for(bool profiling: {false, true})
+  {
+    boost::shared_ptr<CountingBackend> backend(new CountingBackend);
+    pg::PostureGenerator pgPb;
+    pgPb.param("ipopt.print_level", 0);
+    pgPb.param("ipopt.linear_solver", "mumps");
+    pgPb.profiling(profiling);
+    pgPb.iterateRecording(pg::IterateRecording(pg::IterateRecording::Off));
+    pgPb.robotConfigs({rc}, gravity);
+    pgPb.backend(backend);
+
+    nrAllocations = 0;
+    BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+    BOOST_REQUIRE_GT(backend->nrIterations, 2);
+    BOOST_CHECK_EQUAL(pgPb.profile().functions.empty(), !profiling);
+    BOOST_CHECK_EQUAL(nrAllocations, 0);
+  }
+}
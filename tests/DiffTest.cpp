@@ -485,6 +485,28 @@ BOOST_AUTO_TEST_CASE(RobotLinkTest)
     Eigen::VectorXd x(Eigen::VectorXd::Random(pgdata1.pbSize())*3.14);
     BOOST_CHECK_SMALL(checkGradient(rlc, x), 1e-4);
   }
+
+  // same configuration and same body frame give a null error
+  pg::RobotLinkConstr rlcSame(&pgdata1, &pgdata2, {{12, b1T, b1T}, {6, b2T, b2T}});
+  for(int i = 0; i < 10; ++i)
+  {
+    Eigen::VectorXd x(Eigen::VectorXd::Random(pgdata1.pbSize())*3.14);
+    x.segment(qBegin2, mb.nrParams()) = x.segment(qBegin, mb.nrParams());
+    BOOST_CHECK_SMALL(rlcSame(x).norm(), 1e-8);
+    BOOST_CHECK_SMALL(checkGradient(rlcSame, x), 1e-4);
+  }
+
+  // a body frame rotated near pi is not linked, the error norm is the angle
+  // (the log map is singular at pi itself)
+  const double angle = cst::pi<double>() - 0.1;
+  sva::PTransformd b1TFlip(sva::PTransformd(sva::RotZ(angle))*b1T);
+  pg::RobotLinkConstr rlcFlip(&pgdata1, &pgdata2, {{12, b1T, b1TFlip}});
+  Eigen::VectorXd x(Eigen::VectorXd::Random(pgdata1.pbSize())*3.14);
+  x.segment(qBegin2, mb.nrParams()) = x.segment(qBegin, mb.nrParams());
+  Eigen::VectorXd err(rlcFlip(x));
+  BOOST_CHECK_CLOSE(err.head<3>().norm(), angle, 1e-6);
+  BOOST_CHECK_SMALL(checkGradient(rlcFlip, x), 1e-4);
+  BOOST_CHECK_SMALL(err.tail<3>().norm(), 1e-8);
 }
 
 
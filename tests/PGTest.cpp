@@ -16,8 +16,15 @@
 
 // include
 // std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
 #include <tuple>
 
 // boost
@@ -28,6 +35,7 @@
 
 // sch
 #include <sch/S_Object/S_Sphere.h>
+#include <sch/S_Polyhedron/S_Polyhedron.h>
 
 // RBDyn
 #include <RBDyn/FK.h>
@@ -37,10 +45,21 @@
 // PG
 #include "ConfigStruct.h"
 #include "PostureGenerator.h"
+#include "SolverBackend.h"
 #include "CollisionConstr.h" // tosch
+#include "EquilibriumForces.h"
+#include "IterateFile.h"
+#include "ProblemCapture.h"
+#include "PostureDatabase.h"
+#include "ReachabilityMap.h"
+#include "StanceSequence.h"
+#include "StreamingSolver.h"
+#include "PGData.h"
+#include "StaticStabilityConstr.h"
 
 // Arm
 #include "Z12Arm.h"
+#include "SyntheticModel.h"
 
 
 const Eigen::Vector3d gravity(0., 9.81, 0.);
@@ -564,6 +583,20 @@ BOOST_AUTO_TEST_CASE(PGTestZ12)
     sva::PTransformd body2(mbcWork2.bodyPosW[index]);
     BOOST_CHECK_SMALL((body1.translation() - body2.translation()).norm(), 1e-5);
     BOOST_CHECK_SMALL((body1.rotation() - body2.rotation()).norm(), 1e-3);
+
+    // updating each robot on its own thread must not change the result
+    auto q0 = pgPb.q(0);
+    auto q1 = pgPb.q(1);
+    pgPb.parallelUpdate(true);
+    BOOST_REQUIRE(pgPb.run({rc, rc}));
+    for(std::size_t i = 0; i < q0.size(); ++i)
+    {
+      for(std::size_t j = 0; j < q0[i].size(); ++j)
+      {
+        BOOST_CHECK_EQUAL(pgPb.q(0)[i][j], q0[i][j]);
+        BOOST_CHECK_EQUAL(pgPb.q(1)[i][j], q1[i][j]);
+      }
+    }
   }
 
   /*
@@ -631,3 +664,1222 @@ BOOST_AUTO_TEST_CASE(PGTestZ12)
     toPython(mb, mbcWork, rc.forceContacts, pgPb.forces(),"Z12CoMPlane.py");
   }
 }
+
+
+BOOST_AUTO_TEST_CASE(PGTestContactProjection)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+  namespace cst = boost::math::constants;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit, mbcWork;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+  mbcWork = mbcInit;
+
+  Vector3d target(2., 0., 0.);
+  Matrix3d oriTarget(sva::RotZ(-cst::pi<double>()));
+  int id = 12;
+  int index = mb.bodyIndexById(id);
+
+  pg::PostureGenerator pgPb;
+  pg::RobotConfig rc(mb);
+  pgPb.param("ipopt.print_level", 0);
+  pgPb.param("ipopt.linear_solver", "mumps");
+
+  rc.fixedPosContacts = {{id, target, sva::PTransformd::Identity()}};
+  rc.fixedOriContacts = {{id, oriTarget, sva::PTransformd::Identity()}};
+  rc.postureScale = 1.;
+
+  pgPb.robotConfigs({rc}, gravity);
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  const double startViolation = pgPb.quantitiesIter(0).constr_viol;
+
+  // the projected starting point is nearer to the contacts
+  pgPb.contactProjection(20);
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  BOOST_CHECK_LT(pgPb.quantitiesIter(0).constr_viol, startViolation);
+
+  mbcWork.q = pgPb.q();
+  forwardKinematics(mb, mbcWork);
+  BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].translation() - target).norm(), 1e-5);
+  BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].rotation() - oriTarget).norm(), 1e-3);
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestLMEngine)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+  namespace cst = boost::math::constants;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit, mbcWork;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+  mbcWork = mbcInit;
+
+  Vector3d target(2., 0., 0.);
+  Matrix3d oriTarget(sva::RotZ(-cst::pi<double>()));
+  int id = 12;
+  int index = mb.bodyIndexById(id);
+
+  // kinematics only problem, the Levenberg-Marquardt engine is selected
+  {
+    pg::PostureGenerator pgPb;
+    pg::RobotConfig rc(mb);
+    pgPb.param("ipopt.print_level", 0);
+    pgPb.param("ipopt.linear_solver", "mumps");
+    pgPb.engine(pg::PostureGenerator::AutoEngine);
+
+    rc.fixedPosContacts = {{id, target, sva::PTransformd::Identity()}};
+    rc.fixedOriContacts = {{id, oriTarget, sva::PTransformd::Identity()}};
+    rc.bodyPosTargets = {{6, Vector3d(1., 1., 0.), 1.}};
+    rc.postureScale = 1e-2;
+
+    pgPb.robotConfigs({rc}, gravity);
+    BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+    BOOST_CHECK_EQUAL(pgPb.usedEngine(), pg::PostureGenerator::LMEngine);
+    BOOST_CHECK_GT(pgPb.nrIters(), 0);
+
+    mbcWork.q = pgPb.q();
+    forwardKinematics(mb, mbcWork);
+    BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].translation() - target).norm(), 1e-5);
+    BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].rotation() - oriTarget).norm(), 1e-3);
+    for(int i = 0; i < mb.nrJoints(); ++i)
+    {
+      for(std::size_t j = 0; j < mbcWork.q[i].size(); ++j)
+      {
+        BOOST_CHECK_GE(mbcWork.q[i][j], rc.ql[i][j]);
+        BOOST_CHECK_LE(mbcWork.q[i][j], rc.qu[i][j]);
+      }
+    }
+
+    // same problem solved by IPOPT reach the same solution
+    std::vector<std::vector<double>> qLM = pgPb.q();
+    pgPb.engine(pg::PostureGenerator::IpoptEngine);
+    BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+    BOOST_CHECK_EQUAL(pgPb.usedEngine(), pg::PostureGenerator::IpoptEngine);
+    std::vector<std::vector<double>> qIpopt = pgPb.q();
+    for(std::size_t i = 0; i < qLM.size(); ++i)
+    {
+      for(std::size_t j = 0; j < qLM[i].size(); ++j)
+      {
+        BOOST_CHECK_SMALL(qLM[i][j] - qIpopt[i][j], 1e-2);
+      }
+    }
+
+    // and by a user given backend
+    pgPb.backend(boost::shared_ptr<pg::SolverBackend>(new pg::RoboptimBackend("ipopt-sparse")));
+    BOOST_CHECK_EQUAL(pgPb.engine(), pg::PostureGenerator::CustomEngine);
+    BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+    BOOST_CHECK_EQUAL(pgPb.usedEngine(), pg::PostureGenerator::CustomEngine);
+    mbcWork.q = pgPb.q();
+    forwardKinematics(mb, mbcWork);
+    BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].translation() - target).norm(), 1e-5);
+  }
+
+  // force contacts are not handled by the Levenberg-Marquardt engine
+  {
+    pg::PostureGenerator pgPb;
+    pg::RobotConfig rc(mb);
+    pgPb.param("ipopt.print_level", 0);
+    pgPb.param("ipopt.linear_solver", "mumps");
+
+    Matrix3d frame(RotX(-cst::pi<double>()/2.));
+    rc.fixedPosContacts = {{id, target, sva::PTransformd::Identity()}};
+    rc.forceContacts = {{0, {sva::PTransformd(frame, Vector3d(0.01, 0., 0.)),
+                             sva::PTransformd(frame, Vector3d(-0.01, 0., 0.))}, 0.5}};
+
+    // only the engine selection is checked
+    pgPb.robotConfigs({rc}, gravity);
+    pgPb.run({{mbcInit.q, {}, mbcInit.q}});
+    BOOST_CHECK_EQUAL(pgPb.usedEngine(), pg::PostureGenerator::IpoptEngine);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestDeadline)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+  namespace cst = boost::math::constants;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+
+  pg::PostureGenerator pgPb;
+  pg::RobotConfig rc(mb);
+  pgPb.param("ipopt.print_level", 0);
+  pgPb.param("ipopt.linear_solver", "mumps");
+
+  Vector3d target(2., 0., 0.);
+  Matrix3d oriTarget(sva::RotZ(-cst::pi<double>()));
+  int id = 12;
+  rc.fixedPosContacts = {{id, target, sva::PTransformd::Identity()}};
+  rc.fixedOriContacts = {{id, oriTarget, sva::PTransformd::Identity()}};
+  Matrix3d frame(RotX(-cst::pi<double>()/2.));
+  rc.forceContacts = {{0, {sva::PTransformd(frame, Vector3d(0.01, 0., 0.)),
+                           sva::PTransformd(frame, Vector3d(-0.01, 0., 0.))}, 1.}};
+  pgPb.robotConfigs({rc}, gravity);
+
+  // the solver is stopped at its first iteration
+  pgPb.deadline(1e-9);
+  bool success = pgPb.run({{mbcInit.q, {}, mbcInit.q}});
+  BOOST_CHECK(pgPb.resultSelection() == pg::PostureGenerator::LowestCostFeasible ||
+              pgPb.resultSelection() == pg::PostureGenerator::LeastViolating);
+  BOOST_CHECK_EQUAL(success,
+                    pgPb.resultSelection() == pg::PostureGenerator::LowestCostFeasible);
+  BOOST_CHECK_GT(pgPb.nrIters(), 0);
+  BOOST_CHECK_EQUAL(pgPb.q().size(), mbcInit.q.size());
+
+  pgPb.deadline(60.);
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  BOOST_CHECK_EQUAL(pgPb.resultSelection(), pg::PostureGenerator::Converged);
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestAsync)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+  namespace cst = boost::math::constants;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit, mbcWork;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+  mbcWork = mbcInit;
+
+  Vector3d target(2., 0., 0.);
+  Matrix3d oriTarget(sva::RotZ(-cst::pi<double>()));
+  int id = 12;
+  int index = mb.bodyIndexById(id);
+
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{id, target, sva::PTransformd::Identity()}};
+  rc.fixedOriContacts = {{id, oriTarget, sva::PTransformd::Identity()}};
+  Matrix3d frame(RotX(-cst::pi<double>()/2.));
+  rc.forceContacts = {{0, {sva::PTransformd(frame, Vector3d(0.01, 0., 0.)),
+                           sva::PTransformd(frame, Vector3d(-0.01, 0., 0.))}, 1.}};
+
+  pg::PostureGenerator pgPb1, pgPb2;
+  for(pg::PostureGenerator* pgPb: {&pgPb1, &pgPb2})
+  {
+    pgPb->param("ipopt.print_level", 0);
+    pgPb->param("ipopt.linear_solver", "mumps");
+    pgPb->robotConfigs({rc}, gravity);
+  }
+
+  std::atomic<int> completed(0);
+  auto onComplete = [&completed](bool) {++completed;};
+  pg::RunHandle handle1 = pgPb1.runAsync({{mbcInit.q, {}, mbcInit.q}}, onComplete);
+  pg::RunHandle handle2 = pgPb2.runAsync({{mbcInit.q, {}, mbcInit.q}}, onComplete);
+  BOOST_REQUIRE(handle1.valid());
+
+  // the second run is stopped at its next iteration
+  handle2.cancel();
+  handle2.get();
+  BOOST_CHECK(handle2.done());
+
+  BOOST_REQUIRE(handle1.get());
+  BOOST_CHECK_EQUAL(completed, 2);
+  BOOST_CHECK_EQUAL(handle1.progress().nrIters, pgPb1.nrIters());
+  BOOST_CHECK_EQUAL(pgPb1.resultSelection(), pg::PostureGenerator::Converged);
+
+  mbcWork.q = pgPb1.q();
+  forwardKinematics(mb, mbcWork);
+  BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].translation() - target).norm(), 1e-5);
+
+  // cancel has no effect on next runs
+  BOOST_REQUIRE(pgPb2.run({{mbcInit.q, {}, mbcInit.q}}));
+
+  // a runAsync is rejected until the previous one is done
+  std::atomic<bool> release(false);
+  pg::RunHandle handle3 = pgPb2.runAsync({{mbcInit.q, {}, mbcInit.q}},
+    [&release](bool) {while(!release) {std::this_thread::yield();}});
+  BOOST_CHECK_THROW(pgPb2.runAsync({{mbcInit.q, {}, mbcInit.q}}), std::logic_error);
+  release = true;
+  BOOST_CHECK(handle3.get());
+
+  // invalid handle
+  pg::RunHandle invalid;
+  BOOST_CHECK(!invalid.valid());
+  invalid.cancel();
+  BOOST_CHECK_EQUAL(invalid.progress().nrIters, 0);
+  BOOST_CHECK_THROW(invalid.get(), std::logic_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestIterateRecording)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{12, Vector3d(2., 0., 0.), sva::PTransformd::Identity()}};
+
+  pg::PostureGenerator pgPb;
+  pgPb.param("ipopt.print_level", 0);
+  pgPb.param("ipopt.linear_solver", "mumps");
+  pgPb.robotConfigs({rc}, gravity);
+
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  const int nrIters = pgPb.nrIters();
+  BOOST_REQUIRE_GT(nrIters, 2);
+  std::vector<std::vector<double>> lastQ(pgPb.qIter(nrIters - 1));
+  BOOST_CHECK(vectorToParam(mb, pgPb.xIter(nrIters - 1)) == lastQ);
+  BOOST_CHECK_EQUAL(pgPb.x().size(), mb.nrParams());
+  BOOST_CHECK_EQUAL(pgPb.qParamsBegin(0), 0);
+  BOOST_CHECK_EQUAL(pgPb.nrParams(0), mb.nrParams());
+  BOOST_CHECK_EQUAL(pgPb.nrForcePoints(0), 0);
+  BOOST_CHECK_THROW(pgPb.qParamsBegin(1), std::out_of_range);
+
+  pgPb.iterateRecording(pg::IterateRecording(pg::IterateRecording::Off));
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  BOOST_CHECK_EQUAL(pgPb.nrIters(), 0);
+  BOOST_CHECK_THROW(pgPb.qIter(0), std::out_of_range);
+
+  pgPb.iterateRecording(pg::IterateRecording(pg::IterateRecording::Quantities));
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  BOOST_CHECK_EQUAL(pgPb.nrIters(), nrIters);
+  BOOST_CHECK_NO_THROW(pgPb.quantitiesIter(nrIters - 1));
+  BOOST_CHECK_THROW(pgPb.qIter(0), std::out_of_range);
+
+  // the ring keep the last iterates
+  pgPb.iterateRecording(pg::IterateRecording(pg::IterateRecording::Ring, 2));
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  BOOST_REQUIRE_EQUAL(pgPb.nrIters(), 2);
+  BOOST_CHECK(pgPb.qIter(1) == lastQ);
+
+  const std::string file("PGTestIterateRecording.pgit");
+  pgPb.iterateRecording(pg::IterateRecording(pg::IterateRecording::File, 0, file));
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  BOOST_CHECK_EQUAL(pgPb.nrIters(), 0);
+  std::vector<pg::IterateData> datas(pg::readIterateFile(file));
+  BOOST_REQUIRE_EQUAL(int(datas.size()), nrIters);
+  BOOST_CHECK_EQUAL(datas.back().x.size(), mb.nrParams());
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestProfiling)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{12, Vector3d(2., 0., 0.), sva::PTransformd::Identity()}};
+
+  pg::PostureGenerator pgPb;
+  pgPb.param("ipopt.print_level", 0);
+  pgPb.param("ipopt.linear_solver", "mumps");
+  pgPb.robotConfigs({rc}, gravity);
+
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  BOOST_CHECK(pgPb.profile().functions.empty());
+  BOOST_CHECK_EQUAL(pgPb.profile().solve.calls, 0);
+
+  pgPb.profiling(true);
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  const pg::Profile& profile = pgPb.profile();
+  // cost and fixed position contact
+  BOOST_REQUIRE_EQUAL(int(profile.functions.size()), 2);
+  for(const pg::FunctionProfile& fp: profile.functions)
+  {
+    BOOST_CHECK_GT(fp.compute.calls, 0);
+    BOOST_CHECK_GT(fp.jacobian.calls + fp.gradient.calls, 0);
+  }
+  BOOST_CHECK_GT(profile.functions[1].jacobianNnz, 0);
+  BOOST_REQUIRE_EQUAL(int(profile.robots.size()), 1);
+  BOOST_CHECK_GT(profile.robots[0].fk.calls, 0);
+  BOOST_CHECK_EQUAL(profile.robots[0].collision.calls, 0);
+  BOOST_CHECK_EQUAL(profile.solve.calls, 1);
+  BOOST_CHECK_LE(profile.functionsTime(), profile.solve.time);
+  BOOST_CHECK(!profile.report().empty());
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestTracing)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{12, Vector3d(2., 0., 0.), sva::PTransformd::Identity()}};
+
+  pg::PostureGenerator pgPb;
+  pgPb.param("ipopt.print_level", 0);
+  pgPb.param("ipopt.linear_solver", "mumps");
+  pgPb.robotConfigs({rc}, gravity);
+
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  BOOST_CHECK_EQUAL(pgPb.tracer().nrEvents(), 0);
+
+  pgPb.tracing(true);
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  BOOST_CHECK_EQUAL(pgPb.tracer().nrLanes(), 1);
+  BOOST_CHECK_GT(pgPb.tracer().nrEvents(), pgPb.nrIters());
+  BOOST_CHECK_EQUAL(pgPb.tracer().nrDropped(), 0);
+
+  std::ostringstream out;
+  pgPb.tracer().write(out);
+  const std::string json(out.str());
+  BOOST_CHECK_EQUAL(json.find("{\"traceEvents\":["), 0);
+  for(const char* name: {"\"build\"", "\"solve\"", "\"iteration\"",
+                          "\"fk\"", "\"FixedPositionContact\""})
+  {
+    BOOST_CHECK_NE(json.find(name), std::string::npos);
+  }
+
+  // full lanes only count the next spans
+  pgPb.traceCapacity(10);
+  BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+  BOOST_CHECK_EQUAL(pgPb.tracer().nrEvents(), 10);
+  BOOST_CHECK_GT(pgPb.tracer().nrDropped(), 0);
+  BOOST_CHECK_THROW(pgPb.traceCapacity(-1), std::domain_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestCapture)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+
+  sch::S_Sphere hullBody(0.2);
+  sch::S_Sphere hullEnv(0.3);
+  hullEnv.setTransformation(pg::tosch(sva::PTransformd(Vector3d(1., 0.5, 0.))));
+
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{12, Vector3d(2., 0., 0.), sva::PTransformd::Identity()}};
+  rc.envCollisions = {{6, &hullBody, sva::PTransformd::Identity(), &hullEnv, 0.05}};
+  rc.bodyPosTargets = {{6, Vector3d(1., 0.5, 0.), 0.1}};
+
+  pg::PostureGenerator pgPb;
+  pgPb.param("ipopt.print_level", 0);
+  pgPb.param("ipopt.linear_solver", "mumps");
+  pgPb.param("ipopt.tol", 1e-6);
+  pgPb.robotConfigs({rc}, gravity);
+  pgPb.parallelUpdate(true);
+  pgPb.deadline(10.);
+  pgPb.maxIterations(500);
+  pgPb.iterateRecording(pg::IterateRecording(pg::IterateRecording::Ring, 20));
+
+  std::vector<pg::RunConfig> configs = {{mbcInit.q, {}, mbcInit.q}};
+  BOOST_REQUIRE(pgPb.run(configs));
+
+  const std::string file("PGTestCapture.pgpb");
+  pg::saveProblem(file, pgPb.capture(configs, true));
+  pg::CapturedProblem pb = pg::loadProblem(file);
+
+  BOOST_REQUIRE_EQUAL(pb.robotConfigs.size(), 1);
+  BOOST_CHECK_EQUAL(pb.robotConfigs[0].mb.nrDof(), mb.nrDof());
+  BOOST_CHECK_EQUAL(pb.hulls.size(), 2);
+  BOOST_CHECK_EQUAL(pb.robotConfigs[0].envCollisions[0].envHull, pb.hulls[1].get());
+  BOOST_CHECK(pb.hasResult);
+  BOOST_CHECK_EQUAL(int(pb.iterates.size()), pgPb.nrIters());
+  BOOST_CHECK(pb.options.parallelUpdate);
+  BOOST_CHECK_EQUAL(pb.options.deadline, 10.);
+  BOOST_CHECK_EQUAL(pb.options.maxIter, 500);
+  BOOST_CHECK_EQUAL(pb.options.recording.mode, pg::IterateRecording::Ring);
+  BOOST_CHECK_EQUAL(pb.options.recording.ringSize, 20);
+  BOOST_CHECK_EQUAL(pb.options.engine, pgPb.engine());
+
+  // replay the captured problem
+  pg::PostureGenerator replay;
+  pb.setup(replay);
+  BOOST_CHECK(replay.parallelUpdate());
+  BOOST_CHECK_EQUAL(replay.deadline(), 10.);
+  BOOST_REQUIRE(replay.run(pb.runConfigs));
+
+  std::vector<std::vector<double>> q = pgPb.q(), qReplay = replay.q();
+  for(std::size_t i = 0; i < q.size(); ++i)
+  {
+    for(std::size_t j = 0; j < q[i].size(); ++j)
+    {
+      BOOST_CHECK_SMALL(q[i][j] - qReplay[i][j], 1e-8);
+    }
+  }
+  BOOST_CHECK_THROW(pg::loadProblem("PGTestCapture.none"), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestCapturePolyhedron)
+{
+  using namespace Eigen;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit;
+  std::tie(mb, mbcInit) = makeZ12Arm();
+
+  // tetrahedron with outward normals
+  std::vector<Vector3d> vertices = {{0., 0., 0.}, {1., 0., 0.}, {0., 1., 0.}, {0., 0., 1.}};
+  std::vector<std::array<unsigned, 3>> triangles = {{{0, 2, 1}}, {{0, 1, 3}},
+                                                    {{0, 3, 2}}, {{1, 2, 3}}};
+  sch::S_Polyhedron hullEnv;
+  sch::Polyhedron_algorithms& poly = *hullEnv.getPolyhedronAlgorithm();
+  for(std::size_t i = 0; i < vertices.size(); ++i)
+  {
+    sch::S_PolyhedronVertex* v = new sch::S_PolyhedronVertex;
+    v->setCoordinates(vertices[i].x(), vertices[i].y(), vertices[i].z());
+    v->setNumber(unsigned(i));
+    poly.vertexes_.push_back(v);
+  }
+  for(const std::array<unsigned, 3>& tri: triangles)
+  {
+    Vector3d n = (vertices[tri[1]] - vertices[tri[0]]).cross(
+      vertices[tri[2]] - vertices[tri[0]]).normalized();
+    sch::PolyhedronTriangle t;
+    t.a = tri[0]; t.b = tri[1]; t.c = tri[2];
+    t.normal = sch::Vector3(n.x(), n.y(), n.z());
+    poly.triangles_.push_back(t);
+  }
+  poly.updateVertexNeighbors();
+  hullEnv.updateFastArrays();
+  hullEnv.setTransformation(pg::tosch(sva::PTransformd(Vector3d(1., 0.5, 0.))));
+
+  sch::S_Sphere hullBody(0.2);
+  pg::RobotConfig rc(mb);
+  rc.envCollisions = {{6, &hullBody, sva::PTransformd::Identity(), &hullEnv, 0.05}};
+
+  pg::PostureGenerator pgPb;
+  pgPb.robotConfigs({rc}, gravity);
+
+  const std::string file("PGTestCapturePolyhedron.pgpb");
+  std::vector<pg::RunConfig> configs = {{mbcInit.q, {}, mbcInit.q}};
+  pg::saveProblem(file, pgPb.capture(configs));
+  pg::CapturedProblem pb = pg::loadProblem(file);
+
+  BOOST_REQUIRE_EQUAL(pb.hulls.size(), 2);
+  BOOST_REQUIRE_EQUAL(pb.hulls[1]->getType(), sch::S_Object::TPolyhedron);
+  const sch::Polyhedron_algorithms& loaded =
+    *static_cast<sch::S_Polyhedron*>(pb.hulls[1].get())->getPolyhedronAlgorithm();
+  BOOST_REQUIRE_EQUAL(loaded.vertexes_.size(), poly.vertexes_.size());
+  BOOST_REQUIRE_EQUAL(loaded.triangles_.size(), poly.triangles_.size());
+  for(std::size_t i = 0; i < poly.vertexes_.size(); ++i)
+  {
+    for(int j = 0; j < 3; ++j)
+    {
+      BOOST_CHECK_EQUAL(loaded.vertexes_[i]->getCoordinates()[j],
+                        poly.vertexes_[i]->getCoordinates()[j]);
+    }
+  }
+  for(std::size_t i = 0; i < poly.triangles_.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(loaded.triangles_[i].a, poly.triangles_[i].a);
+    BOOST_CHECK_EQUAL(loaded.triangles_[i].b, poly.triangles_[i].b);
+    BOOST_CHECK_EQUAL(loaded.triangles_[i].c, poly.triangles_[i].c);
+  }
+
+  // same support point once the neighbors are rebuilt
+  sch::Vector3 dir(1., 1., 1.);
+  sch::Point3 sp = hullEnv.support(dir), spLoaded = pb.hulls[1]->support(dir);
+  for(int i = 0; i < 3; ++i)
+  {
+    BOOST_CHECK_SMALL(sp[i] - spLoaded[i], 1e-8);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestPostureDatabase)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  // KD-tree search against a linear search
+  {
+    pg::PostureDatabase db;
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dist(-1., 1.);
+    auto random = [&gen, &dist]() {return Vector3d(dist(gen), dist(gen), dist(gen));};
+    for(int i = 0; i < 300; ++i)
+    {
+      db.add(i%2, random(), VectorXd::Constant(1, double(i)));
+    }
+
+    for(int i = 0; i < 20; ++i)
+    {
+      Vector3d f(random());
+      std::vector<pg::PostureDatabase::Neighbor> nn = db.nearest(1, f, 5);
+      BOOST_REQUIRE_EQUAL(nn.size(), 5);
+
+      std::vector<double> dists;
+      for(int e = 1; e < db.size(); e += 2)
+      {
+        dists.push_back((db.entryFeatures(e) - f).norm());
+      }
+      std::sort(dists.begin(), dists.end());
+      for(std::size_t j = 0; j < nn.size(); ++j)
+      {
+        BOOST_CHECK_EQUAL(db.entrySignature(nn[j].entry), 1);
+        BOOST_CHECK_SMALL(nn[j].distance - dists[j], 1e-12);
+      }
+    }
+    BOOST_CHECK(db.nearest(2, Vector3d::Zero(), 5).empty());
+  }
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+  std::vector<pg::RunConfig> configs = {{mbcInit.q, {}, mbcInit.q}};
+
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{12, Vector3d(2., 0., 0.), sva::PTransformd::Identity()}};
+  rc.postureScale = 1.;
+
+  const std::string file("PGTestPostureDatabase.pgdb");
+  std::remove(file.c_str());
+  int nrItersCold = 0;
+  {
+    boost::shared_ptr<pg::PostureDatabase> db(new pg::PostureDatabase(file));
+    pg::PostureGenerator pgPb;
+    pgPb.param("ipopt.print_level", 0);
+    pgPb.param("ipopt.linear_solver", "mumps");
+    pgPb.robotConfigs({rc}, gravity);
+    pgPb.postureDatabase(db);
+
+    BOOST_REQUIRE(pgPb.run(configs));
+    BOOST_CHECK_EQUAL(pgPb.warmStartEntry(), -1);
+    BOOST_CHECK_EQUAL(db->size(), 1);
+    nrItersCold = pgPb.nrIters();
+
+    // the same problem start from its solution
+    BOOST_REQUIRE(pgPb.run(configs));
+    BOOST_CHECK_EQUAL(pgPb.warmStartEntry(), 0);
+    BOOST_CHECK_LT(pgPb.nrIters(), nrItersCold);
+    BOOST_CHECK_EQUAL(db->size(), 2);
+
+    // a different layout has no neighbor
+    pg::RobotConfig rcOri(rc);
+    rcOri.fixedOriContacts = {{12, Matrix3d(RotZ(-boost::math::constants::pi<double>())),
+                               sva::PTransformd::Identity()}};
+    pgPb.robotConfigs({rcOri}, gravity);
+    pgPb.postureDatabase(db, 1, false);
+    BOOST_REQUIRE(pgPb.run(configs));
+    BOOST_CHECK_EQUAL(pgPb.warmStartEntry(), -1);
+    BOOST_CHECK_EQUAL(db->size(), 2);
+  }
+
+  // entries are read back from the file
+  {
+    boost::shared_ptr<pg::PostureDatabase> db(new pg::PostureDatabase(file));
+    BOOST_REQUIRE_EQUAL(db->size(), 2);
+
+    rc.fixedPosContacts[0].target = Vector3d(2., 0.1, 0.);
+    pg::PostureGenerator pgPb;
+    pgPb.param("ipopt.print_level", 0);
+    pgPb.param("ipopt.linear_solver", "mumps");
+    pgPb.robotConfigs({rc}, gravity);
+    pgPb.postureDatabase(db, 2);
+    BOOST_REQUIRE(pgPb.run(configs));
+    BOOST_CHECK_NE(pgPb.warmStartEntry(), -1);
+    BOOST_CHECK_LE(pgPb.nrIters(), nrItersCold);
+    BOOST_CHECK_EQUAL(db->size(), 3);
+  }
+
+  // an interrupted add leave an incomplete entry, it's dropped at opening
+  {
+    std::ofstream out(file, std::ios::binary | std::ios::app);
+    const char partial[10] = {};
+    out.write(partial, sizeof(partial));
+  }
+  {
+    pg::PostureDatabase db(file);
+    BOOST_REQUIRE_EQUAL(db.size(), 3);
+    db.add(db.entrySignature(0), db.entryFeatures(0), db.entryX(0));
+  }
+  {
+    pg::PostureDatabase db(file);
+    BOOST_REQUIRE_EQUAL(db.size(), 4);
+    BOOST_CHECK(db.entryX(3) == db.entryX(0));
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestReachability)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+  namespace cst = boost::math::constants;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+
+  Matrix3d frame(RotX(-cst::pi<double>()/2.));
+  Vector3d normal(frame.row(2));
+  std::vector<pg::ReachabilityMap> maps =
+    pg::buildReachabilityMaps(mb, {}, {}, {12}, {normal},
+                              pg::ReachabilityConfig(0.1, 200000, 2));
+  BOOST_REQUIRE_EQUAL(maps.size(), 1);
+  BOOST_CHECK_GT(maps[0].nrReached(), 0);
+  // the arm move in the z = 0 plane
+  BOOST_CHECK(maps[0].reachable(Vector3d(2., 0., 0.), 0.));
+  BOOST_CHECK(!maps[0].reachable(Vector3d(2., 0., 1.), 0.));
+  BOOST_CHECK(!maps[0].reachable(Vector3d(100., 0., 0.), 0.));
+  BOOST_CHECK(maps[0].reachable(Vector3d(2., 0., 0.), 0., Vector3d::UnitY()));
+  BOOST_CHECK(!maps[0].reachable(Vector3d(2., 0., 0.), 0., Vector3d::UnitZ()));
+
+  const std::string file("PGTestReachability.pgrm");
+  pg::saveReachabilityMaps(file, maps);
+  std::vector<pg::ReachabilityMap> loaded = pg::loadReachabilityMaps(file);
+  BOOST_REQUIRE_EQUAL(loaded.size(), 1);
+  BOOST_CHECK_EQUAL(loaded[0].bodyId(), 12);
+  BOOST_CHECK_EQUAL(loaded[0].nrReached(), maps[0].nrReached());
+
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{12, Vector3d(2., 0., 0.), sva::PTransformd::Identity()}};
+  std::vector<pg::RunConfig> configs = {{mbcInit.q, {}, mbcInit.q}};
+
+  pg::PostureGenerator pgPb;
+  pgPb.param("ipopt.print_level", 0);
+  pgPb.param("ipopt.linear_solver", "mumps");
+  pgPb.reachabilityMaps({loaded});
+  pgPb.robotConfigs({rc}, gravity);
+  BOOST_CHECK(pgPb.run(configs));
+  BOOST_CHECK(pgPb.unreachableContacts().empty());
+
+  // out of reach, only reported by default
+  rc.fixedPosContacts[0].target = Vector3d(100., 0., 0.);
+  pgPb.robotConfigs({rc}, gravity);
+  pgPb.run(configs);
+  BOOST_CHECK_EQUAL(pgPb.unreachableContacts().size(), 1);
+  BOOST_CHECK_NE(pgPb.resultSelection(), pg::PostureGenerator::NoResult);
+
+  // rejected before solving
+  pgPb.reachabilityMaps({loaded}, true);
+  BOOST_CHECK(!pgPb.run(configs));
+  BOOST_REQUIRE_EQUAL(pgPb.unreachableContacts().size(), 1);
+  BOOST_CHECK_EQUAL(pgPb.unreachableContacts()[0].bodyId, 12);
+  BOOST_CHECK_EQUAL(pgPb.resultSelection(), pg::PostureGenerator::NoResult);
+
+  // horizontal plane, the arm surface can't face it
+  std::vector<Vector2d> targetPoints = {{1., 1.}, {-0., 1.}, {-0., -1.}, {1., -1.}};
+  std::vector<Vector2d> surfPoints = {{0.1, 0.1}, {-0.1, 0.1}, {-0.1, -0.1}, {0.1, -0.1}};
+  rc.fixedPosContacts = {};
+  rc.planarContacts = {{12, sva::PTransformd(frame, Vector3d(0., 1., 0.)), targetPoints,
+                        sva::PTransformd(frame), surfPoints}};
+  pgPb.robotConfigs({rc}, gravity);
+  pgPb.reachabilityMaps({loaded}, false);
+  pgPb.run(configs);
+  BOOST_CHECK(pgPb.unreachableContacts().empty());
+
+  rc.planarContacts[0].targetFrame = sva::PTransformd(Vector3d(0., 1., 0.));
+  pgPb.robotConfigs({rc}, gravity);
+  pgPb.run(configs);
+  BOOST_CHECK_EQUAL(pgPb.unreachableContacts().size(), 1);
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestStanceSequence)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+  namespace cst = boost::math::constants;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+
+  Matrix3d oriTarget(RotZ(-cst::pi<double>()));
+  Matrix3d frame(RotX(-cst::pi<double>()/2.));
+  std::vector<pg::ForceContact> baseForces =
+    {{0, {PTransformd(frame, Vector3d(0.01, 0., 0.)),
+          PTransformd(frame, Vector3d(-0.01, 0., 0.))}, 1.}};
+
+  // add the orientation contact, move the target and remove the forces
+  std::vector<pg::Stance> stances(4, pg::Stance({pg::RobotConfig(mb)}));
+  std::vector<Vector3d> targets = {Vector3d(2., 0., 0.), Vector3d(2., 0., 0.),
+                                   Vector3d(1.8, 0.3, 0.), Vector3d(1.8, 0.3, 0.)};
+  for(std::size_t k = 0; k < stances.size(); ++k)
+  {
+    pg::RobotConfig& rc = stances[k].robotConfigs[0];
+    rc.fixedPosContacts = {{12, targets[k], PTransformd::Identity()}};
+    if(k > 0)
+    {
+      rc.fixedOriContacts = {{12, oriTarget, PTransformd::Identity()}};
+    }
+    if(k < 3)
+    {
+      rc.forceContacts = baseForces;
+    }
+  }
+
+  pg::StanceSequence sequence;
+  sequence.setup([](pg::PostureGenerator& pgPb)
+  {
+    pgPb.param("ipopt.print_level", 0);
+    pgPb.param("ipopt.linear_solver", "mumps");
+  });
+
+  int index = mb.bodyIndexById(12);
+  auto checkResults = [&]()
+  {
+    BOOST_REQUIRE_EQUAL(sequence.results().size(), stances.size());
+    for(std::size_t k = 0; k < stances.size(); ++k)
+    {
+      const pg::StanceResult& res = sequence.results()[k];
+      BOOST_REQUIRE(res.success);
+      MultiBodyConfig mbc(mbcInit);
+      mbc.q = res.q[0];
+      forwardKinematics(mb, mbc);
+      BOOST_CHECK_SMALL((mbc.bodyPosW[index].translation() - targets[k]).norm(), 1e-5);
+      BOOST_CHECK_EQUAL(res.forces[0].size(), k < 3 ? 2 : 0);
+    }
+  };
+
+  BOOST_REQUIRE(sequence.run(stances, {{mbcInit.q, {}, mbcInit.q}}, gravity));
+  checkResults();
+  for(const pg::StanceResult& res: sequence.results())
+  {
+    BOOST_CHECK(!res.speculative);
+  }
+
+  sequence.nrThreads(3);
+  BOOST_REQUIRE(sequence.run(stances, {{mbcInit.q, {}, mbcInit.q}}, gravity));
+  checkResults();
+  BOOST_CHECK(!sequence.results()[0].speculative);
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestSensitivity)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit, mbcWork;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+  mbcWork = mbcInit;
+
+  int id = 12;
+  int index = mb.bodyIndexById(id);
+  Vector3d target(1.8, 0.3, 0.);
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{id, target, PTransformd::Identity()}};
+  rc.bodyPosTargets = {{6, Vector3d(1., 1., 0.), 1.}};
+  rc.postureScale = 1e-2;
+  std::vector<pg::RunConfig> configs = {{mbcInit.q, {}, mbcInit.q}};
+
+  auto makePb = [](pg::PostureGenerator& pgPb, const pg::RobotConfig& robotConfig)
+  {
+    pgPb.param("ipopt.print_level", 0);
+    pgPb.param("ipopt.linear_solver", "mumps");
+    pgPb.param("ipopt.tol", 1e-10);
+    pgPb.robotConfigs({robotConfig}, gravity);
+  };
+
+  pg::PostureGenerator pgPb;
+  makePb(pgPb, rc);
+  BOOST_CHECK_THROW(pgPb.sensitivityParameters(
+    {{pg::TargetParameter::PlanarFrame, 0, 0}}), std::out_of_range);
+  pgPb.sensitivityParameters({{pg::TargetParameter::FixedPosition, 0, 0},
+                              {pg::TargetParameter::BodyPosition, 0, 0}});
+  BOOST_REQUIRE(pgPb.run(configs));
+  BOOST_REQUIRE_EQUAL(pgPb.sensitivity().rows(), mb.nrParams());
+  BOOST_REQUIRE_EQUAL(pgPb.sensitivity().cols(), 6);
+  MatrixXd S(pgPb.qSensitivity(0));
+  VectorXd x0(paramToVector(mb, pgPb.q()));
+
+  // first order prediction of the solution of a new solve
+  VectorXd dp(6);
+  dp << 0.01, -0.02, 0., 0.02, 0.01, 0.;
+  pg::RobotConfig rcMoved(rc);
+  rcMoved.fixedPosContacts[0].target += dp.head<3>();
+  rcMoved.bodyPosTargets[0].target += dp.tail<3>();
+  pg::PostureGenerator pgMoved;
+  makePb(pgMoved, rcMoved);
+  BOOST_REQUIRE(pgMoved.run({{pgPb.q(), {}, mbcInit.q}}));
+  VectorXd x1(paramToVector(mb, pgMoved.q()));
+  BOOST_CHECK_LT((x1 - x0 - S*dp).norm(), 0.1*(x1 - x0).norm());
+
+  // predictor-corrector reach the new solution and update the sensitivity
+  BOOST_REQUIRE(pgPb.track(configs, dp, 5));
+  BOOST_CHECK_SMALL((pgPb.robotConfigs()[0].fixedPosContacts[0].target -
+                     rcMoved.fixedPosContacts[0].target).norm(), 1e-12);
+  mbcWork.q = pgPb.q();
+  forwardKinematics(mb, mbcWork);
+  BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].translation() -
+                     rcMoved.fixedPosContacts[0].target).norm(), 1e-5);
+  BOOST_CHECK_SMALL((paramToVector(mb, pgPb.q()) - x1).norm(), 1e-4);
+  BOOST_CHECK_EQUAL(pgPb.sensitivity().cols(), 6);
+
+  // the sensitivity is only computed when asked
+  pgPb.sensitivityParameters({});
+  BOOST_REQUIRE(pgPb.run(configs));
+  BOOST_CHECK_EQUAL(pgPb.sensitivity().size(), 0);
+  BOOST_CHECK_THROW(pgPb.track(configs, dp), std::logic_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestStreaming)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  // queue and triple buffer semantics
+  pg::SpscQueue<int> queue(3);
+  BOOST_CHECK_EQUAL(queue.capacity(), 4);
+  int value = 0;
+  BOOST_CHECK(!queue.pop(value));
+  for(int i = 0; i < 4; ++i)
+  {
+    BOOST_CHECK(queue.push(i));
+  }
+  BOOST_CHECK(!queue.push(4));
+  BOOST_CHECK(queue.pop(value));
+  BOOST_CHECK_EQUAL(value, 0);
+
+  pg::TripleBuffer<int> buffer(-1);
+  BOOST_CHECK(!buffer.update());
+  BOOST_CHECK_EQUAL(buffer.read(), -1);
+  buffer.back() = 1;
+  buffer.publish();
+  buffer.back() = 2;
+  buffer.publish();
+  BOOST_CHECK(buffer.update());
+  BOOST_CHECK_EQUAL(buffer.read(), 2);
+  BOOST_CHECK(!buffer.update());
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit, mbcWork;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+  mbcWork = mbcInit;
+
+  int id = 12;
+  int index = mb.bodyIndexById(id);
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{id, Vector3d(2., 0., 0.), PTransformd::Identity()}};
+  rc.postureScale = 1e-2;
+
+  pg::StreamingSolver stream(16);
+  stream.solver().param("ipopt.print_level", 0);
+  stream.solver().param("ipopt.linear_solver", "mumps");
+  stream.solver().robotConfigs({rc}, gravity);
+  stream.iterationsPerCycle(20);
+  BOOST_CHECK(!stream.update());
+  BOOST_CHECK_THROW(stream.push(pg::TargetUpdate({pg::TargetParameter::FixedPosition, 0, 1},
+                                                 PTransformd::Identity())),
+                    std::out_of_range);
+
+  stream.start({{mbcInit.q, {}, mbcInit.q}});
+  BOOST_CHECK(stream.running());
+  BOOST_CHECK_THROW(stream.start({{mbcInit.q, {}, mbcInit.q}}), std::logic_error);
+
+  // move the contact target along a line as a control loop would do
+  std::vector<Vector3d> targets;
+  for(int i = 1; i <= 10; ++i)
+  {
+    targets.push_back(Vector3d(2. - 0.02*i, 0.03*i, 0.));
+    BOOST_REQUIRE(stream.push(pg::TargetUpdate({pg::TargetParameter::FixedPosition, 0, 0},
+                                               PTransformd(targets.back()))));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+
+  // wait a converged solution of the last target
+  std::chrono::steady_clock::time_point end =
+    std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  bool converged = false;
+  while(!converged && std::chrono::steady_clock::now() < end)
+  {
+    if(stream.update())
+    {
+      const pg::StreamingSolution& sol = stream.solution();
+      converged = sol.nrUpdates == targets.size() &&
+        sol.selection == pg::PostureGenerator::Converged;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  stream.stop();
+  BOOST_CHECK(!stream.running());
+  BOOST_REQUIRE(converged);
+
+  const pg::StreamingSolution& sol = stream.solution();
+  BOOST_CHECK_GT(sol.cycle, 0);
+  mbcWork.q = vectorToParam(mb, sol.x.segment(stream.qParamsBegin(0), mb.nrParams()));
+  forwardKinematics(mb, mbcWork);
+  BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].translation() - targets.back()).norm(), 1e-5);
+
+  // the stream problem is built once, model reduction can't be used
+  stream.solver().modelReduction(true);
+  BOOST_CHECK_THROW(stream.start({{mbcInit.q, {}, mbcInit.q}}), std::logic_error);
+  BOOST_CHECK(!stream.running());
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestBatch)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit, mbcWork;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // to avoid to start in singularity
+  mbcInit.q[3][0] = -0.1;
+  mbcWork = mbcInit;
+
+  int id = 12;
+  int index = mb.bodyIndexById(id);
+  Vector3d target(1.8, 0.3, 0.);
+  pg::RobotConfig rc(mb);
+  rc.fixedPosContacts = {{id, target, PTransformd::Identity()}};
+  std::vector<pg::RunConfig> configs = {{mbcInit.q, {}, mbcInit.q}};
+
+  pg::PostureGenerator pgPb;
+  pgPb.param("ipopt.print_level", 0);
+  pgPb.param("ipopt.linear_solver", "mumps");
+  pgPb.robotConfigs({rc}, gravity);
+
+  const int nrQueries = 5;
+  MatrixXd initQ(mb.nrParams(), nrQueries);
+  MatrixXd targets(3, nrQueries);
+  for(int i = 0; i < nrQueries; ++i)
+  {
+    initQ.col(i) = paramToVector(mb, mbcInit.q);
+    targets.col(i) = Vector3d(0., 0.1*i, 0.);
+  }
+  std::vector<pg::TargetParameter> params = {{pg::TargetParameter::FixedPosition, 0, 0}};
+
+  BOOST_CHECK_THROW(pgPb.runBatch(configs, initQ.topRows(2), params, targets),
+                    std::domain_error);
+  BOOST_CHECK_THROW(pgPb.runBatch(configs, initQ, params, targets.topRows(2)),
+                    std::domain_error);
+
+  pg::BatchResult res = pgPb.runBatch(configs, initQ, params, targets, 2);
+  BOOST_REQUIRE_EQUAL(res.x.rows(), mb.nrParams());
+  BOOST_REQUIRE_EQUAL(res.x.cols(), nrQueries);
+  for(int i = 0; i < nrQueries; ++i)
+  {
+    BOOST_REQUIRE(res.success[i]);
+    BOOST_CHECK_GT(res.nrIters[i], 0);
+    mbcWork.q = vectorToParam(mb, res.x.col(i));
+    forwardKinematics(mb, mbcWork);
+    BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].translation() -
+                       (target + targets.col(i))).norm(), 1e-5);
+  }
+  // the batch don't move this problem targets
+  BOOST_CHECK_EQUAL(pgPb.robotConfigs()[0].fixedPosContacts[0].target, target);
+
+  // same result as a sequential run
+  BOOST_REQUIRE(pgPb.run(configs));
+  BOOST_CHECK_SMALL((paramToVector(mb, pgPb.q()) - res.x.col(0)).norm(), 1e-6);
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestSynthetic)
+{
+  // 2 leaves
+  SyntheticModel model(makeSyntheticModel(SyntheticModelConfig(6, 2, 1, false, 3)));
+  BOOST_REQUIRE_EQUAL(int(model.leafIds.size()), 2);
+  BOOST_CHECK_EQUAL(model.mb.nrDof(), 12);
+
+  SyntheticScenario sc(makeSyntheticScenario(model,
+    SyntheticScenarioConfig(2, 0, 2, 2, 7)));
+  BOOST_REQUIRE_EQUAL(int(sc.robotConfig.fixedPosContacts.size()), 2);
+
+  pg::PostureGenerator pgPb;
+  pgPb.param("ipopt.print_level", 0);
+  pgPb.param("ipopt.linear_solver", "mumps");
+  pgPb.robotConfigs({sc.robotConfig}, gravity);
+  BOOST_REQUIRE(pgPb.run({sc.runConfig}));
+
+  rbd::MultiBodyConfig mbc(model.mbc);
+  mbc.q = pgPb.q();
+  rbd::forwardKinematics(model.mb, mbc);
+  for(const pg::FixedPositionContact& fpc: sc.robotConfig.fixedPosContacts)
+  {
+    int index = model.mb.bodyIndexById(fpc.bodyId);
+    BOOST_CHECK_SMALL((mbc.bodyPosW[index].translation() - fpc.target).norm(), 1e-5);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(PGTestModelReduction)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit, mbcWork;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+  // joint 0 is the fixed root joint
+  for(int i = 1; i < mb.nrJoints(); ++i)
+  {
+    mbcInit.q[i][0] = -0.1*i;
+  }
+  mbcWork = mbcInit;
+
+  // only the 6 first joints move body 6
+  {
+    pg::PostureGenerator pgPb;
+    pg::RobotConfig rc(mb);
+    pgPb.param("ipopt.print_level", 0);
+    pgPb.param("ipopt.linear_solver", "mumps");
+    pgPb.modelReduction(true);
+
+    Vector3d target(1., 1.5, 0.);
+    int id = 6;
+    int index = mb.bodyIndexById(id);
+    rc.fixedPosContacts = {{id, target, sva::PTransformd::Identity()}};
+
+    pgPb.robotConfigs({rc}, gravity);
+    BOOST_REQUIRE(pgPb.run({{mbcInit.q, {}, mbcInit.q}}));
+    BOOST_CHECK_GT(pgPb.nrIters(), 0);
+
+    mbcWork.q = pgPb.q();
+    BOOST_REQUIRE_EQUAL(mbcWork.q.size(), mbcInit.q.size());
+    for(int i = index + 1; i < mb.nrJoints(); ++i)
+    {
+      BOOST_CHECK_EQUAL(mbcWork.q[i][0], mbcInit.q[i][0]);
+    }
+
+    forwardKinematics(mb, mbcWork);
+    BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].translation() - target).norm(), 1e-5);
+  }
+
+  // locked joints keep their initial value
+  {
+    pg::PostureGenerator pgPb;
+    pg::RobotConfig rc(mb);
+    pgPb.param("ipopt.print_level", 0);
+    pgPb.param("ipopt.linear_solver", "mumps");
+
+    Vector3d target(2., 0., 0.);
+    int id = 12;
+    int index = mb.bodyIndexById(id);
+    rc.fixedPosContacts = {{id, target, sva::PTransformd::Identity()}};
+
+    pg::RunConfig runConfig(mbcInit.q, {}, mbcInit.q);
+    runConfig.lockedJoints = {2, 3, 7};
+
+    pgPb.robotConfigs({rc}, gravity);
+    BOOST_REQUIRE(pgPb.run({runConfig}));
+
+    mbcWork.q = pgPb.q();
+    for(int jointId: runConfig.lockedJoints)
+    {
+      int jointIndex = mb.jointIndexById(jointId);
+      BOOST_CHECK_EQUAL(mbcWork.q[jointIndex][0], mbcInit.q[jointIndex][0]);
+    }
+
+    forwardKinematics(mb, mbcWork);
+    BOOST_CHECK_SMALL((mbcWork.bodyPosW[index].translation() - target).norm(), 1e-5);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(EquilibriumForcesTest)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+  namespace cst = boost::math::constants;
+
+  MultiBody mb;
+  MultiBodyConfig mbcInit;
+
+  std::tie(mb, mbcInit) = makeZ12Arm();
+
+  double mu = 0.5;
+  Matrix3d frame(RotX(-cst::pi<double>()/2.));
+  std::vector<pg::ForceContact> forceContacts =
+    {{0, {sva::PTransformd(frame, Vector3d(0.01, 0., 0.)),
+          sva::PTransformd(frame, Vector3d(-0.01, 0., 0.))}, mu}};
+
+  int nrForceVar = 6;
+  pg::PGData pgdata(mb, gravity, mb.nrParams() + nrForceVar, 0, mb.nrParams());
+  pgdata.forces(forceContacts);
+  pgdata.updateKinematics(mbcInit.q);
+
+  std::vector<Vector3d> forces = pg::equilibriumForces(pgdata);
+  BOOST_REQUIRE_EQUAL(int(forces.size()), pgdata.nrForcePoints());
+
+  VectorXd x(pgdata.pbSize());
+  x.head(mb.nrParams()) = rbd::paramToVector(mb, mbcInit.q);
+  for(std::size_t i = 0; i < forces.size(); ++i)
+  {
+    x.segment<3>(mb.nrParams() + 3*i) = forces[i];
+
+    // inside the friction cone
+    Vector3d fPoint(forceContacts[0].points[i].rotation()*forces[i]);
+    BOOST_CHECK_GE(fPoint.z(), 0.);
+    BOOST_CHECK_LE(fPoint.head<2>().norm(), mu*fPoint.z() + 1e-8);
+  }
+
+  // static equilibrium
+  pg::StaticStabilityConstr stab(&pgdata);
+  double weight = pgdata.robotMass()*gravity.norm();
+  BOOST_CHECK_SMALL(stab(x).norm()/weight, 1e-4);
+}
@@ -0,0 +1,307 @@
+// This file is part of PG.
+//
+// PG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with PG.  If not, see <http://www.gnu.org/licenses/>.
+
+// Seeded random robots and scenarios to exercise the solver and the
+// constraints on models of arbitrary size.
+
+#pragma once
+
+// include
+// std
+#include <algorithm>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// boost
+#include <boost/shared_ptr.hpp>
+
+// sch
+#include <sch/S_Object/S_Sphere.h>
+
+// RBDyn
+#include <RBDyn/FK.h>
+#include <RBDyn/MultiBody.h>
+#include <RBDyn/MultiBodyConfig.h>
+#include <RBDyn/MultiBodyGraph.h>
+
+// PG
+#include "ConfigStruct.h"
+#include "CollisionConstr.h" // tosch
+
+
+/// Size of a synthetic robot.
+struct SyntheticModelConfig
+{
+  SyntheticModelConfig(int d=12, int b=1, int bLevels=0, bool fr=false,
+                       unsigned s=0)
+    : depth(d)
+    , branching(b)
+    , branchLevels(bLevels)
+    , freeRoot(fr)
+    , linkLength(0.3)
+    , seed(s)
+  {}
+
+  /// Number of joints between the root and each leaf.
+  int depth;
+  /// Children of the bodies of the branchLevels first levels
+  /// (other bodies have one child).
+  int branching;
+  int branchLevels;
+  bool freeRoot;
+  /// Mean distance between two joints.
+  double linkLength;
+  unsigned seed;
+};
+
+
+struct SyntheticModel
+{
+  rbd::MultiBody mb;
+  /// Zero configuration.
+  rbd::MultiBodyConfig mbc;
+  /// Bodies without children.
+  std::vector<int> leafIds;
+  /// Upper bound of the distance between the root and a body.
+  double reach;
+  /// Sphere hull of each body (body index), radius hullRadius.
+  std::vector<boost::shared_ptr<sch::S_Sphere>> hulls;
+  double hullRadius;
+};
+
+
+/**
+  * Tree of revolute joints with random axis and link lengths.
+  * Body and joint ids are their index (joint i move body i + 1).
+  */
+inline SyntheticModel makeSyntheticModel(const SyntheticModelConfig& config)
+{
+  using namespace Eigen;
+  using namespace sva;
+  using namespace rbd;
+
+  std::mt19937 gen(config.seed);
+  std::uniform_real_distribution<double> lengthDist(0.7*config.linkLength,
+                                                    1.3*config.linkLength);
+  std::uniform_int_distribution<int> axisDist(0, 2);
+  const Joint::OldType axis[3] = {Joint::RevX, Joint::RevY, Joint::RevZ};
+
+  MultiBodyGraph mbg;
+  RBInertiad rbi(1., Vector3d::Zero(), Matrix3d::Identity());
+  mbg.addBody({rbi, 0, "b0"});
+
+  SyntheticModel model;
+  model.reach = 0.;
+  model.hullRadius = 0.05;
+
+  // (body id, level) of the bodies to expand
+  std::vector<std::tuple<int, int>> parents = {std::make_tuple(0, 0)};
+  int nextId = 1;
+  while(!parents.empty())
+  {
+    int parentId, level;
+    std::tie(parentId, level) = parents.back();
+    parents.pop_back();
+
+    if(level == config.depth)
+    {
+      model.leafIds.push_back(parentId);
+      continue;
+    }
+
+    int nrChild = level < config.branchLevels ? config.branching : 1;
+    for(int c = 0; c < nrChild; ++c)
+    {
+      int id = nextId++;
+      mbg.addBody({rbi, id, "b" + std::to_string(id)});
+      mbg.addJoint({axis[axisDist(gen)], true, id - 1, "j" + std::to_string(id - 1)});
+
+      double lateral = config.linkLength*(c - (nrChild - 1)/2.);
+      PTransformd to(parentId == 0 ? Vector3d::Zero() :
+                     Vector3d(lateral, lengthDist(gen), 0.));
+      mbg.linkBodies(parentId, to, id, PTransformd::Identity(), id - 1);
+      parents.push_back(std::make_tuple(id, level + 1));
+    }
+  }
+  model.reach = 1.3*config.linkLength*config.depth;
+
+  model.mb = mbg.makeMultiBody(0, !config.freeRoot);
+  model.mbc = MultiBodyConfig(model.mb);
+  model.mbc.zero(model.mb);
+  if(config.freeRoot)
+  {
+    model.mbc.q[0] = {1., 0., 0., 0., 0., 0., 0.};
+  }
+
+  for(int i = 0; i < model.mb.nrBodies(); ++i)
+  {
+    model.hulls.emplace_back(new sch::S_Sphere(model.hullRadius));
+  }
+
+  return model;
+}
+
+
+/// Content of a synthetic problem.
+struct SyntheticScenarioConfig
+{
+  SyntheticScenarioConfig(int nrC=1, int nrFP=0, int nrEC=0, int nrSC=0,
+                          unsigned s=0)
+    : nrContacts(nrC)
+    , nrForcePoints(nrFP)
+    , nrEnvCollisions(nrEC)
+    , nrSelfCollisions(nrSC)
+    , seed(s)
+  {}
+
+  /// Fixed position contacts on the first leaves.
+  int nrContacts;
+  /// Force points shared between the root and the contact bodies.
+  int nrForcePoints;
+  /// Obstacles, each one avoided by a random body.
+  int nrEnvCollisions;
+  /// Pairs of non adjacent bodies.
+  int nrSelfCollisions;
+  unsigned seed;
+};
+
+
+struct SyntheticScenario
+{
+  pg::RobotConfig robotConfig;
+  pg::RunConfig runConfig;
+  /// Random posture used to build the contacts targets and to place
+  /// the obstacles, a solution of the problem.
+  std::vector<std::vector<double>> solutionQ;
+  std::vector<boost::shared_ptr<sch::S_Sphere>> obstacles;
+};
+
+
+/**
+  * Feasible problem on model: contacts targets are the leaves position in
+  * a random posture and collisions are satisfied in this posture.
+  * model must outlive the scenario (collisions use its hulls).
+  */
+inline SyntheticScenario makeSyntheticScenario(const SyntheticModel& model,
+                                               const SyntheticScenarioConfig& config)
+{
+  using namespace Eigen;
+  using namespace sva;
+
+  const rbd::MultiBody& mb = model.mb;
+  std::mt19937 gen(config.seed);
+  std::uniform_real_distribution<double> qDist(-0.5, 0.5);
+  std::uniform_real_distribution<double> posDist(-model.reach, model.reach);
+  std::uniform_int_distribution<int> bodyDist(1, mb.nrBodies() - 1);
+
+  SyntheticScenario scenario;
+  scenario.robotConfig = pg::RobotConfig(mb);
+  scenario.robotConfig.postureScale = 1e-2;
+  scenario.runConfig = pg::RunConfig(model.mbc.q, {}, model.mbc.q);
+
+  rbd::MultiBodyConfig mbc(model.mbc);
+  for(int i = 0; i < mb.nrJoints(); ++i)
+  {
+    if(mb.joint(i).type() == rbd::Joint::Rev)
+    {
+      mbc.q[i][0] = qDist(gen);
+    }
+  }
+  rbd::forwardKinematics(mb, mbc);
+  scenario.solutionQ = mbc.q;
+
+  int nrContacts = std::min(config.nrContacts, int(model.leafIds.size()));
+  std::vector<int> contactIds(model.leafIds.begin(), model.leafIds.begin() + nrContacts);
+  for(int id: contactIds)
+  {
+    scenario.robotConfig.fixedPosContacts.push_back(
+      {id, mbc.bodyPosW[mb.bodyIndexById(id)].translation(), PTransformd::Identity()});
+  }
+
+  // force points on a square on the root and each contact body
+  if(config.nrForcePoints > 0)
+  {
+    std::vector<int> forceIds = {0};
+    forceIds.insert(forceIds.end(), contactIds.begin(), contactIds.end());
+    for(int id: forceIds)
+    {
+      scenario.robotConfig.forceContacts.push_back({id, {}, 1.});
+    }
+    for(int i = 0; i < config.nrForcePoints; ++i)
+    {
+      double x = (i%4 < 2) ? 0.05 : -0.05;
+      double z = (i%2 == 0) ? 0.05 : -0.05;
+      scenario.robotConfig.forceContacts[i%forceIds.size()].points.push_back(
+        PTransformd(Vector3d(x, 0., z)));
+    }
+  }
+
+  // obstacles are kept at more than minDist of every body in the solution
+  const double minDist = 0.05;
+  const double obstacleRadius = 0.1;
+  auto freeFromBodies = [&](const Vector3d& pos, double clearance)
+  {
+    for(const PTransformd& X: mbc.bodyPosW)
+    {
+      if((X.translation() - pos).norm() < clearance)
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  const int maxTry = 100;
+  for(int i = 0; i < config.nrEnvCollisions; ++i)
+  {
+    for(int t = 0; t < maxTry; ++t)
+    {
+      Vector3d pos(posDist(gen), posDist(gen), posDist(gen));
+      if(freeFromBodies(pos, obstacleRadius + model.hullRadius + 2.*minDist))
+      {
+        scenario.obstacles.emplace_back(new sch::S_Sphere(obstacleRadius));
+        scenario.obstacles.back()->setTransformation(pg::tosch(PTransformd(pos)));
+        int id = bodyDist(gen);
+        scenario.robotConfig.envCollisions.push_back(
+          {id, model.hulls[mb.bodyIndexById(id)].get(), PTransformd::Identity(),
+           scenario.obstacles.back().get(), minDist});
+        break;
+      }
+    }
+  }
+
+  for(int i = 0; i < config.nrSelfCollisions; ++i)
+  {
+    for(int t = 0; t < maxTry; ++t)
+    {
+      int id1 = bodyDist(gen), id2 = bodyDist(gen);
+      int index1 = mb.bodyIndexById(id1), index2 = mb.bodyIndexById(id2);
+      double dist = (mbc.bodyPosW[index1].translation() -
+                     mbc.bodyPosW[index2].translation()).norm();
+      if(id1 != id2 && mb.parent(index1) != index2 && mb.parent(index2) != index1 &&
+         dist > 2.*(model.hullRadius + minDist))
+      {
+        scenario.robotConfig.selfCollisions.push_back(
+          {id1, model.hulls[index1].get(), PTransformd::Identity(),
+           id2, model.hulls[index2].get(), PTransformd::Identity(), minDist});
+        break;
+      }
+    }
+  }
+
+  return scenario;
+}